@@ -3,9 +3,39 @@
 #include <fstream>
 #include <cstring>
 #include <cstdio>
+#include <climits>
+#include <cerrno>
+#include <iterator>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #ifdef _WIN32
 #include <Windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// SIMD kernels are built for x64 only, other targets use the scalar kernels
+// Define FC_JSON_NO_SIMD to disable them
+#if !defined(FC_JSON_NO_SIMD) && (defined(_M_X64) || defined(__x86_64__))
+#define FC_JSON_SIMD_X86
+#endif
+
+#ifdef FC_JSON_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define FC_JSON_TARGET_AVX2
+#else
+#define FC_JSON_TARGET_AVX2      __attribute__((target("avx2")))
+#endif
 #endif
 
 // UTF-8 encoding standard
@@ -60,2581 +90,8666 @@ namespace fcjson
 #endif
 
     static std::string _get_utf8_text_for_code_point(uint32_t cp32);
-    static bool _get_utf16_code_point(const _tchar* data_ptr, uint32_t* code_point_ptr, const _tchar** end_ptr);
-    static bool _get_unicode_string(_tstring& append_str, const _tchar* data_ptr, const _tchar** end_ptr);
-    static int32_t _utf8_to_utf16(const void* data_ptr, size_t size = -1, std::string* text_utf8_ptr = nullptr, std::wstring* text_utf16_ptr = nullptr);
-    static int32_t _utf16_to_utf8(const void* data_ptr, size_t size = -1, std::string* text_utf8_ptr = nullptr, std::wstring* text_utf16_ptr = nullptr);
-    static std::string _utf16_to_utf8(const std::wstring utf16);
-    static std::wstring _utf8_to_utf16(const std::string utf8);
-    inline const _tchar* _skip_whitespace(const _tchar* data_ptr);
-    inline const _tchar* _skip_bom(const _tchar* data_ptr);
-    static bool _skip_digit(const _tchar* data_ptr, const _tchar** end_ptr);
+    static bool _get_utf16_code_point(const _tchar* data_ptr, const _tchar* data_end, uint32_t* code_point_ptr, const _tchar** end_ptr);
+    static void _append_unicode_escape(json_writer& append_str, const _tchar* data_ptr, const _tchar* data_end, const _tchar** end_ptr);
+    static size_t _get_escape_code_point(const _tchar* data_ptr, const _tchar* data_end, uint32_t* code_point_ptr);
+    static bool _utf8_to_utf16(const uint8_t* data_ptr, size_t size, std::wstring* text_ptr);
+    static bool _utf16_to_utf8(const uint16_t* data_ptr, size_t count, std::string* text_ptr);
+    inline size_t _get_utf8_sequence(const uint8_t* data_ptr, const uint8_t* data_end, uint32_t* code_point_ptr);
+    inline size_t _put_utf8(char* out_ptr, uint32_t cp32);
+    static std::string _utf16_to_utf8(const std::wstring& utf16);
+    static std::wstring _utf8_to_utf16(const std::string& utf8);
+    static bool _is_utf8_text(const uint8_t* data_ptr, size_t size);
+    static bool _skip_digit(const _tchar* data_ptr, const _tchar* data_end, const _tchar** end_ptr);
+    static double _parse_double(const _tchar* data_ptr, const _tchar* data_end);
+    static size_t _format_uint(_tchar* out_ptr, uint64_t val);
+    static size_t _format_int(_tchar* out_ptr, int64_t val);
+    static size_t _format_double(_tchar* out_ptr, double val);
+
+    // Character masks of a 64 characters block, bit N is character N
+    struct json_block_masks
+    {
+        uint64_t quote;                 // "
+        uint64_t backslash;             // Backslash
+        uint64_t whitespace;            // What _skip_whitespace skips
+        uint64_t op;                    // { } [ ] : ,
+        uint64_t nul;                   // 0x00
+    };
+
+    using json_classify_block_fn = void(*)(const _tchar* data_ptr, json_block_masks& masks);
+
+    inline uint32_t _json_ctz64(uint64_t val)
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long index = 0;
+        _BitScanForward64(&index, val);
+        return index;
+#elif defined(_MSC_VER)
+        unsigned long index = 0;
+        if (_BitScanForward(&index, (uint32_t)val))
+        {
+            return index;
+        }
+        _BitScanForward(&index, (uint32_t)(val >> 32));
+        return index + 32;
+#else
+        return (uint32_t)__builtin_ctzll(val);
+#endif
+    }
 
-    inline const _tchar* _skip_whitespace(const _tchar* data_ptr)
+    inline uint32_t _json_clz64(uint64_t val)
     {
-        while (_T('\0') != *data_ptr)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long index = 0;
+        _BitScanReverse64(&index, val);
+        return 63 - index;
+#elif defined(_MSC_VER)
+        unsigned long index = 0;
+        if (_BitScanReverse(&index, (uint32_t)(val >> 32)))
         {
-            if (*data_ptr > _T(' '))
-            {
-                break;
-            }
-
-            data_ptr++;
+            return 31 - index;
         }
-
-        return data_ptr;
+        _BitScanReverse(&index, (uint32_t)val);
+        return 63 - index;
+#else
+        return (uint32_t)__builtin_clzll(val);
+#endif
     }
 
-    inline const _tchar* _skip_bom(const _tchar* data_ptr)
+#if defined(FC_JSON_SIMD_X86) && !defined(_UNICODE)
+
+    static void _classify_block_sse2(const _tchar* data_ptr, json_block_masks& masks)
     {
-#ifdef _UNICODE
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i brace_open = _mm_set1_epi8('{');
+        const __m128i brace_close = _mm_set1_epi8('}');
+        const __m128i colon = _mm_set1_epi8(':');
+        const __m128i comma = _mm_set1_epi8(',');
+        const __m128i lower_bit = _mm_set1_epi8(0x20);
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i zero = _mm_setzero_si128();
 
-        while (0xFEFF == *data_ptr)
-        {
-            data_ptr++;
-        }
+        masks = {};
 
-#else
-        while (nullptr != _json_tcsstr(data_ptr, "\xEF\xBB\xBF"))
+        for (int i = 0; i < 4; i++)
         {
-            data_ptr += 3;
-        }
+            __m128i chars = _mm_loadu_si128((const __m128i*)(data_ptr + i * 16));
 
-#endif
-        return data_ptr;
+            // '[' ']' become '{' '}' once the 0x20 bit is set
+            __m128i lower = _mm_or_si128(chars, lower_bit);
+            __m128i op = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(lower, brace_open), _mm_cmpeq_epi8(lower, brace_close)),
+                _mm_or_si128(_mm_cmpeq_epi8(chars, colon), _mm_cmpeq_epi8(chars, comma))
+            );
+
+            // Signed compare like _skip_whitespace, bytes >= 0x80 count as whitespace
+            __m128i nul = _mm_cmpeq_epi8(chars, zero);
+            __m128i not_whitespace = _mm_or_si128(_mm_cmpgt_epi8(chars, space), nul);
+
+            int shift = i * 16;
+            masks.quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, quote)) << shift;
+            masks.backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, backslash)) << shift;
+            masks.whitespace |= (uint64_t)(uint16_t)~_mm_movemask_epi8(not_whitespace) << shift;
+            masks.op |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << shift;
+            masks.nul |= (uint64_t)(uint16_t)_mm_movemask_epi8(nul) << shift;
+        }
     }
 
-    json_value::json_value(json_type type) :
-        m_data{ 0 },
-        m_type(type)
+    FC_JSON_TARGET_AVX2
+    static void _classify_block_avx2(const _tchar* data_ptr, json_block_masks& masks)
     {
-        if (json_type::json_type_string == m_type)
-        {
-            m_data._string_ptr = new (std::nothrow) json_string;
-        }
+        const __m256i quote = _mm256_set1_epi8('\"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        const __m256i brace_open = _mm256_set1_epi8('{');
+        const __m256i brace_close = _mm256_set1_epi8('}');
+        const __m256i colon = _mm256_set1_epi8(':');
+        const __m256i comma = _mm256_set1_epi8(',');
+        const __m256i lower_bit = _mm256_set1_epi8(0x20);
+        const __m256i space = _mm256_set1_epi8(' ');
+        const __m256i zero = _mm256_setzero_si256();
 
-        if (json_type::json_type_array == m_type)
-        {
-            m_data._array_ptr = new (std::nothrow) json_array;
-        }
+        masks = {};
 
-        if (json_type::json_type_object == m_type)
+        for (int i = 0; i < 2; i++)
         {
-            m_data._object_ptr = new (std::nothrow) json_object;
+            __m256i chars = _mm256_loadu_si256((const __m256i*)(data_ptr + i * 32));
+
+            __m256i lower = _mm256_or_si256(chars, lower_bit);
+            __m256i op = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(lower, brace_open), _mm256_cmpeq_epi8(lower, brace_close)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(chars, colon), _mm256_cmpeq_epi8(chars, comma))
+            );
+
+            __m256i nul = _mm256_cmpeq_epi8(chars, zero);
+            __m256i not_whitespace = _mm256_or_si256(_mm256_cmpgt_epi8(chars, space), nul);
+
+            int shift = i * 32;
+            masks.quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, quote)) << shift;
+            masks.backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, backslash)) << shift;
+            masks.whitespace |= (uint64_t)(uint32_t)~_mm256_movemask_epi8(not_whitespace) << shift;
+            masks.op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << shift;
+            masks.nul |= (uint64_t)(uint32_t)_mm256_movemask_epi8(nul) << shift;
         }
     }
 
-    json_value::json_value(nullptr_t) : json_value()
-    {
-    }
+#else
 
-    json_value::json_value(json_bool val)
+    static void _classify_block_scalar(const _tchar* data_ptr, json_block_masks& masks)
     {
-        m_type = json_type::json_type_bool;
-        m_data._bool = val;
-    }
+        masks = {};
 
-    json_value::json_value(int32_t val)
-    {
-        m_type = json_type::json_type_int;
-        m_data._int = val;
-    }
+        for (int i = 0; i < 64; i++)
+        {
+            _utchar ch = data_ptr[i];
+            uint64_t bit = (uint64_t)1 << i;
 
-    json_value::json_value(uint32_t val)
-    {
-        m_type = json_type::json_type_int;
-        m_data._uint = val;
+            switch (ch)
+            {
+            case _T('\"'):
+                masks.quote |= bit;
+                break;
+            case _T('\\'):
+                masks.backslash |= bit;
+                break;
+            case _T('{'):
+            case _T('}'):
+            case _T('['):
+            case _T(']'):
+            case _T(':'):
+            case _T(','):
+                masks.op |= bit;
+                break;
+            default:
+                if (0 == ch)
+                {
+                    masks.nul |= bit;
+                }
+                else if (data_ptr[i] <= _T(' '))
+                {
+                    // Same test as _skip_whitespace, including the signedness of _tchar
+                    masks.whitespace |= bit;
+                }
+                break;
+            }
+        }
     }
 
-    json_value::json_value(int64_t val)
-    {
-        m_type = json_type::json_type_int;
-        m_data._int = val;
-    }
+#endif
 
-    json_value::json_value(uint64_t val)
-    {
-        m_type = json_type::json_type_uint;
-        m_data._uint = val;
-    }
+#ifdef FC_JSON_SIMD_X86
 
-    json_value::json_value(json_float val)
+    static bool _cpu_has_avx2()
     {
-        m_type = json_type::json_type_float;
-        m_data._float = val;
-    }
+#ifdef _MSC_VER
+        int cpu_info[4] = { 0 };
+        __cpuid(cpu_info, 0);
+        if (cpu_info[0] < 7)
+        {
+            return false;
+        }
 
-    json_value::json_value(const _tchar* val)
-    {
-        m_type = json_type::json_type_string;
-        m_data._string_ptr = new (std::nothrow) json_string();
-        if (val && nullptr != m_data._string_ptr)
+        // The OS must save the YMM registers
+        __cpuid(cpu_info, 1);
+        bool flag_osxsave = 0 != (cpu_info[2] & (1 << 27));
+        bool flag_avx = 0 != (cpu_info[2] & (1 << 28));
+        if (!flag_osxsave || !flag_avx || 0x06 != (_xgetbv(0) & 0x06))
         {
-            *(m_data._string_ptr) = val;
+            return false;
         }
-    }
 
-    json_value::json_value(const json_string& r)
-    {
-        m_type = json_type::json_type_string;
-        m_data._string_ptr = new (std::nothrow) json_string(r);
+        __cpuidex(cpu_info, 7, 0);
+        return 0 != (cpu_info[1] & (1 << 5));
+#else
+        __builtin_cpu_init();
+        return 0 != __builtin_cpu_supports("avx2");
+#endif
     }
 
-    json_value::json_value(const json_object& r)
-    {
-        m_type = json_type::json_type_object;
-        m_data._object_ptr = new (std::nothrow) json_object(r);
-    }
+#endif
 
-    json_value::json_value(const json_array& r)
+    static json_classify_block_fn _get_classify_block()
     {
-        m_type = json_type::json_type_array;
-        m_data._array_ptr = new (std::nothrow) json_array(r);
+#if defined(FC_JSON_SIMD_X86) && !defined(_UNICODE)
+        static json_classify_block_fn classify_fn = _cpu_has_avx2() ? _classify_block_avx2 : _classify_block_sse2;
+#else
+        static json_classify_block_fn classify_fn = _classify_block_scalar;
+#endif
+        return classify_fn;
     }
 
-    json_value::json_value(const json_bin& r)
+    // First { } [ ] or quote at or after data_ptr, data_end if there is none
+    static const _tchar* _find_bracket_or_quote(const _tchar* data_ptr, const _tchar* data_end)
     {
-        m_type = json_type::json_type_bin;
-        m_data._raw_ptr = new (std::nothrow) json_bin(r);
+#if defined(FC_JSON_SIMD_X86) && !defined(_UNICODE)
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i brace_open = _mm_set1_epi8('{');
+        const __m128i brace_close = _mm_set1_epi8('}');
+        const __m128i lower_bit = _mm_set1_epi8(0x20);
 
-    }
+        while (data_end - data_ptr >= 16)
+        {
+            __m128i chars = _mm_loadu_si128((const __m128i*)data_ptr);
+            __m128i lower = _mm_or_si128(chars, lower_bit);
+            __m128i match = _mm_or_si128(_mm_cmpeq_epi8(chars, quote),
+                _mm_or_si128(_mm_cmpeq_epi8(lower, brace_open), _mm_cmpeq_epi8(lower, brace_close)));
 
-    json_value::json_value(const json_value& r)
-    {
-        m_type = r.m_type;
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(match);
+            if (0 != mask)
+            {
+                return data_ptr + _json_ctz64(mask);
+            }
 
-        switch (m_type)
-        {
-        case json_type::json_type_string:
-        {
-            m_data._string_ptr = new (std::nothrow) json_string(*r.m_data._string_ptr);
-        }
-        break;
-        case json_type::json_type_object:
-        {
-            m_data._object_ptr = new (std::nothrow) json_object(*r.m_data._object_ptr);
-        }
-        break;
-        case json_type::json_type_array:
-        {
-            m_data._array_ptr = new (std::nothrow) json_array(*r.m_data._array_ptr);
-        }
-        break;
-        case json_type::json_type_bin:
-        {
-            m_data._raw_ptr = new (std::nothrow) json_bin(*r.m_data._raw_ptr);
+            data_ptr += 16;
         }
-        break;
-        default:
+#endif
+        while (data_ptr < data_end)
         {
-            m_data = r.m_data;
-        }
-        break;
+            _tchar ch = *data_ptr;
+            if (_T('\"') == ch || _T('{') == ch || _T('}') == ch || _T('[') == ch || _T(']') == ch)
+            {
+                break;
+            }
+
+            data_ptr++;
         }
-    }
 
-    json_value::json_value(json_string&& r)
-    {
-        m_type = json_type::json_type_string;
-        m_data._string_ptr = new (std::nothrow) json_string(std::move(r));
+        return data_ptr;
     }
 
-    json_value::json_value(json_object&& r)
+    // First quote or backslash at or after data_ptr, data_end if there is none
+    static const _tchar* _find_quote_or_backslash(const _tchar* data_ptr, const _tchar* data_end)
     {
-        m_type = json_type::json_type_object;
-        m_data._object_ptr = new (std::nothrow) json_object(std::move(r));
-    }
+#if defined(FC_JSON_SIMD_X86) && !defined(_UNICODE)
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
 
-    json_value::json_value(json_array&& r)
-    {
-        m_type = json_type::json_type_array;
-        m_data._array_ptr = new (std::nothrow) json_array(std::move(r));
-    }
+        while (data_end - data_ptr >= 16)
+        {
+            __m128i chars = _mm_loadu_si128((const __m128i*)data_ptr);
+            __m128i match = _mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash));
 
-    json_value::json_value(json_bin&& r)
-    {
-        m_type = json_type::json_type_bin;
-        m_data._raw_ptr = new (std::nothrow) json_bin(std::move(r));
-    }
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(match);
+            if (0 != mask)
+            {
+                return data_ptr + _json_ctz64(mask);
+            }
 
-    json_value::json_value(json_value&& r) noexcept
-    {
-        m_type = r.m_type;
-        m_data = r.m_data;
+            data_ptr += 16;
+        }
+#endif
+        while (data_ptr < data_end)
+        {
+            if (_T('\"') == *data_ptr || _T('\\') == *data_ptr)
+            {
+                break;
+            }
+
+            data_ptr++;
+        }
 
-        r.m_data = { 0 };
-        r.m_type = json_type::json_type_null;
+        return data_ptr;
     }
 
-    void json_value::clear()
+    const _tchar* _skip_whitespace_run(const _tchar* data_ptr, const _tchar* data_end)
     {
-        switch (m_type)
-        {
-        case json_type::json_type_string:
+#if defined(FC_JSON_SIMD_X86) && !defined(_UNICODE)
+        // Signed compare, like the scalar loop bytes >= 0x80 count as whitespace
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i zero = _mm_setzero_si128();
+
+        while (data_end - data_ptr >= 16)
         {
-            if (m_data._string_ptr)
+            __m128i chars = _mm_loadu_si128((const __m128i*)data_ptr);
+            __m128i stop = _mm_or_si128(_mm_cmpgt_epi8(chars, space), _mm_cmpeq_epi8(chars, zero));
+
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(stop);
+            if (0 != mask)
             {
-                delete m_data._string_ptr;
+                return data_ptr + _json_ctz64(mask);
             }
+
+            data_ptr += 16;
         }
-        break;
-        case json_type::json_type_object:
+#endif
+        while (data_ptr < data_end)
         {
-            if (m_data._object_ptr)
+            if (*data_ptr > _T(' ') || _T('\0') == *data_ptr)
             {
-                delete m_data._object_ptr;
+                break;
             }
+
+            data_ptr++;
         }
-        break;
-        case json_type::json_type_array:
+
+        return data_ptr;
+    }
+
+    // First quote, backslash or NUL at or after data_ptr, data_end if there is none
+    static const _tchar* _find_string_special(const _tchar* data_ptr, const _tchar* data_end)
+    {
+#if defined(FC_JSON_SIMD_X86) && !defined(_UNICODE)
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i zero = _mm_setzero_si128();
+
+        // 32 bytes per step, long string values are the common case
+        while (data_end - data_ptr >= 32)
         {
-            if (m_data._array_ptr)
+            __m128i chars_low = _mm_loadu_si128((const __m128i*)data_ptr);
+            __m128i chars_high = _mm_loadu_si128((const __m128i*)(data_ptr + 16));
+            __m128i match_low = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars_low, quote), _mm_cmpeq_epi8(chars_low, backslash)),
+                _mm_cmpeq_epi8(chars_low, zero));
+            __m128i match_high = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars_high, quote), _mm_cmpeq_epi8(chars_high, backslash)),
+                _mm_cmpeq_epi8(chars_high, zero));
+
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(match_low) | ((uint32_t)_mm_movemask_epi8(match_high) << 16);
+            if (0 != mask)
             {
-                delete m_data._array_ptr;
+                return data_ptr + _json_ctz64(mask);
             }
+
+            data_ptr += 32;
         }
-        break;
-        case json_type::json_type_bin:
+
+        if (data_end - data_ptr >= 16)
         {
-            if (m_data._raw_ptr)
+            __m128i chars = _mm_loadu_si128((const __m128i*)data_ptr);
+            __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash)),
+                _mm_cmpeq_epi8(chars, zero));
+
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(match);
+            if (0 != mask)
             {
-                delete m_data._raw_ptr;
+                return data_ptr + _json_ctz64(mask);
             }
+
+            data_ptr += 16;
         }
-        break;
+#endif
+        while (data_ptr < data_end)
+        {
+            _tchar ch = *data_ptr;
+            if (_T('\"') == ch || _T('\\') == ch || _T('\0') == ch)
+            {
+                break;
+            }
+
+            data_ptr++;
         }
 
-        m_data = { 0 };
+        return data_ptr;
+    }
+
+    // Characters for _dump_string: 0 copied as is, 1 escaped, 2 beyond ASCII, escaped with flag_escape
+    static const uint8_t json_dump_char_class[256] =
+    {
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    };
+
+    inline uint8_t _dump_char_class(_utchar ch)
+    {
+#ifdef _UNICODE
+        return ch < 0x100 ? json_dump_char_class[(uint8_t)ch] : 2;
+#else
+        return json_dump_char_class[ch];
+#endif
     }
 
-    inline void json_value::_reset_type(json_type type)
+    // First character _dump_string can not copy as is at or after data_ptr, data_end if there is none:
+    // quote, backslash, control characters and, with flag_escape, anything beyond ASCII
+    static const _tchar* _find_dump_special(const _tchar* data_ptr, const _tchar* data_end, bool flag_escape)
     {
-        if (this == &_get_none_value())
+#if defined(FC_JSON_SIMD_X86) && !defined(_UNICODE)
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control = _mm_set1_epi8(0x1F);
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i zero = _mm_setzero_si128();
+
+        while (data_end - data_ptr >= 16)
         {
-            return;
-        }
+            __m128i chars = _mm_loadu_si128((const __m128i*)data_ptr);
 
-        clear();
-        m_type = type;
+            // Signed compare also catches bytes >= 0x80, unsigned saturation only 0x00 - 0x1F
+            __m128i special = flag_escape ? _mm_cmplt_epi8(chars, space) : _mm_cmpeq_epi8(_mm_subs_epu8(chars, control), zero);
+            __m128i match = _mm_or_si128(special, _mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash)));
 
-        if (json_type::json_type_string == m_type)
-        {
-            m_data._string_ptr = new (std::nothrow) json_string;
-        }
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(match);
+            if (0 != mask)
+            {
+                return data_ptr + _json_ctz64(mask);
+            }
 
-        if (json_type::json_type_array == m_type)
-        {
-            m_data._array_ptr = new (std::nothrow) json_array;
+            data_ptr += 16;
         }
-
-        if (json_type::json_type_object == m_type)
+#endif
+        uint8_t stop_mask = flag_escape ? 3 : 1;
+        while (data_ptr < data_end && 0 == (_dump_char_class(*data_ptr) & stop_mask))
         {
-            m_data._object_ptr = new (std::nothrow) json_object;
+            data_ptr++;
         }
 
-        if (json_type::json_type_bin == m_type)
-        {
-            m_data._raw_ptr = new (std::nothrow) json_bin;
-        }
+        return data_ptr;
     }
 
-    json_value& json_value::operator = (nullptr_t)
+    struct json_arena::json_arena_block
     {
-        if (this == &_get_none_value())
-        {
-            return _get_none_value();
-        }
+        json_arena_block*   prev_ptr;       // Previous block
+        size_t              size;           // Bytes after the header
+    };
 
-        _reset_type(json_type::json_type_null);
-        return *this;
+    json_arena::json_arena(size_t block_size/* = 64 * 1024*/) :
+        m_block_ptr(nullptr),
+        m_cur_ptr(nullptr),
+        m_end_ptr(nullptr),
+        m_block_size(block_size < 1024 ? 1024 : block_size),
+        m_used(0),
+        m_reserved(0)
+    {
     }
 
-    json_value& json_value::operator = (json_type type)
+    json_arena::~json_arena()
     {
-        if (this == &_get_none_value())
-        {
-            return _get_none_value();
-        }
-
-        _reset_type(type);
-        return *this;
+        reset();
     }
 
-    json_value& json_value::operator = (json_bool val)
+    void json_arena::reset()
     {
-        if (this == &_get_none_value())
+        while (m_block_ptr)
         {
-            return _get_none_value();
+            json_arena_block* prev_ptr = m_block_ptr->prev_ptr;
+            ::operator delete(m_block_ptr);
+            m_block_ptr = prev_ptr;
         }
 
-        _reset_type(json_type::json_type_bool);
-        m_data._bool = val;
-        return *this;
+        m_cur_ptr = nullptr;
+        m_end_ptr = nullptr;
+        m_used = 0;
+        m_reserved = 0;
     }
 
-    json_value& json_value::operator = (int32_t val)
+    size_t json_arena::used() const
     {
-        if (this == &_get_none_value())
+        if (nullptr == m_block_ptr)
         {
-            return _get_none_value();
+            return m_used;
         }
 
-        _reset_type(json_type::json_type_int);
-        m_data._int = val;
-        return *this;
+        return m_used + (m_cur_ptr - (uint8_t*)(m_block_ptr + 1));
     }
 
-    json_value& json_value::operator = (uint32_t val)
+    size_t json_arena::reserved() const
     {
-        if (this == &_get_none_value())
-        {
-            return _get_none_value();
-        }
-
-        _reset_type(json_type::json_type_int);
-        m_data._uint = val;
-        return *this;
+        return m_reserved;
     }
 
-    json_value& json_value::operator = (int64_t val)
+    void* json_arena::_allocate_block(size_t size, size_t align)
     {
-        if (this == &_get_none_value())
+        // Blocks double up to 16 MB, a larger request gets a block of its own
+        size_t block_size = m_block_size;
+        if (block_size < size + align)
         {
-            return _get_none_value();
+            block_size = size + align;
         }
 
-        _reset_type(json_type::json_type_int);
-        m_data._int = val;
-        return *this;
-    }
+        json_arena_block* block_ptr = (json_arena_block*)::operator new(sizeof(json_arena_block) + block_size, std::nothrow);
+        if (nullptr == block_ptr)
+        {
+            return nullptr;
+        }
 
-    json_value& json_value::operator = (uint64_t val)
-    {
-        if (this == &_get_none_value())
+        if (m_block_ptr)
         {
-            return _get_none_value();
+            m_used += m_cur_ptr - (uint8_t*)(m_block_ptr + 1);
         }
 
-        _reset_type(json_type::json_type_uint);
-        m_data._uint = val;
-        return *this;
-    }
+        block_ptr->prev_ptr = m_block_ptr;
+        block_ptr->size = block_size;
+        m_block_ptr = block_ptr;
+        m_cur_ptr = (uint8_t*)(block_ptr + 1);
+        m_end_ptr = m_cur_ptr + block_size;
+        m_reserved += block_size;
 
-    json_value& json_value::operator = (json_float val)
-    {
-        if (this == &_get_none_value())
+        if (m_block_size < 16 * 1024 * 1024)
         {
-            return _get_none_value();
+            m_block_size *= 2;
         }
 
-        _reset_type(json_type::json_type_float);
-        m_data._float = val;
-        return *this;
+        return allocate(size, align);
     }
 
-    json_value& json_value::operator = (const _tchar* val)
+#ifdef FC_JSON_INTERN_KEYS
+
+    struct json_key::json_key_data
     {
-        if (this == &_get_none_value())
-        {
-            return _get_none_value();
-        }
+        std::atomic<uint32_t>   ref_count;      // Keys sharing the text
+        _tstring                text;           // Key text
+    };
 
-        _reset_type(json_type::json_type_string);
-        if (val && nullptr != m_data._string_ptr )
-        {
-            *m_data._string_ptr = val;
-        }
-        return *this;
+    json_key::json_key() :
+        m_ptr(0)
+    {
     }
 
-    json_value& json_value::operator = (const json_string& r)
+    json_key::json_key(const _tchar* text) :
+        json_key(_tstring(text))
     {
-        if (this == &_get_none_value())
-        {
-            return _get_none_value();
-        }
+    }
 
-        _reset_type(json_type::json_type_string);
-        if (nullptr != m_data._string_ptr)
-        {
-            *m_data._string_ptr = r;
-        }
-        return *this;
+    json_key::json_key(const _tstring& text) :
+        m_ptr(0)
+    {
+        json_key_data* data_ptr = new json_key_data;
+        data_ptr->ref_count = 1;
+        data_ptr->text = text;
+        m_ptr = (uintptr_t)data_ptr;
     }
 
-    json_value& json_value::operator = (const json_object& r)
+    json_key::json_key(const json_key& r) :
+        m_ptr(0)
     {
-        if (this == &_get_none_value())
-        {
-            return _get_none_value();
-        }
+        *this = r;
+    }
 
-        _reset_type(json_type::json_type_object);
-        if (nullptr != m_data._object_ptr)
-        {
-            *m_data._object_ptr = r;
-        }
-        return *this;
+    json_key::json_key(json_key&& r) noexcept :
+        m_ptr(r.m_ptr)
+    {
+        r.m_ptr = 0;
     }
 
-    json_value& json_value::operator = (const json_array& r)
+    json_key::~json_key()
     {
-        if (this == &_get_none_value())
+        _release();
+    }
+
+    json_key& json_key::operator = (const json_key& r)
+    {
+        if (&r == this)
         {
-            return _get_none_value();
+            return *this;
         }
 
-        _reset_type(json_type::json_type_array);
-        if (nullptr != m_data._array_ptr)
+        // A copy of a borrowed key owns its text
+        if (r.m_ptr & 1)
+        {
+            *this = json_key(r.str());
+            return *this;
+        }
+
+        if (r.m_ptr)
         {
-            *m_data._array_ptr = r;
+            ((json_key_data*)r.m_ptr)->ref_count.fetch_add(1, std::memory_order_relaxed);
         }
+
+        _release();
+        m_ptr = r.m_ptr;
         return *this;
     }
 
-    json_value& json_value::operator = (const json_bin& r)
+    json_key& json_key::operator = (json_key&& r) noexcept
     {
-        if (this == &_get_none_value())
+        if (&r != this)
         {
-            return _get_none_value();
+            _release();
+            m_ptr = r.m_ptr;
+            r.m_ptr = 0;
         }
 
-        _reset_type(json_type::json_type_bin);
-        if (nullptr != m_data._array_ptr)
-        {
-            *m_data._raw_ptr = r;
-        }
         return *this;
     }
 
-    json_value& json_value::operator = (const json_value& r)
+    json_key json_key::borrow(const _tstring& text)
     {
-        if (this == &_get_none_value())
+        json_key key;
+        key.m_ptr = (uintptr_t)&text | 1;
+        return key;
+    }
+
+    json_key::operator const _tstring& () const
+    {
+        return str();
+    }
+
+    const _tstring& json_key::str() const
+    {
+        static const _tstring empty_text;
+
+        if (m_ptr & 1)
         {
-            return _get_none_value();
+            return *(const _tstring*)(m_ptr & ~(uintptr_t)1);
         }
 
-        if (&r != this)
-        {
-            clear();
-            m_type = r.m_type;
+        return m_ptr ? ((json_key_data*)m_ptr)->text : empty_text;
+    }
 
-            switch (m_type)
-            {
-            case json_type::json_type_string:
-            {
-                m_data._string_ptr = new (std::nothrow) json_string(*r.m_data._string_ptr);
-            }
-            break;
-            case json_type::json_type_object:
-            {
-                m_data._object_ptr = new (std::nothrow) json_object(*r.m_data._object_ptr);
-            }
-            break;
-            case json_type::json_type_array:
-            {
-                m_data._array_ptr = new (std::nothrow) json_array(*r.m_data._array_ptr);
-            }
-            break;
-            case json_type::json_type_bin:
-            {
-                m_data._raw_ptr = new (std::nothrow) json_bin(*r.m_data._raw_ptr);
-            }
-            break;
-            default:
-            {
-                m_data = r.m_data;
-            }
-            break;
-            }
-        }
+    const _tchar* json_key::c_str() const
+    {
+        return str().c_str();
+    }
 
-        return *this;
+    size_t json_key::size() const
+    {
+        return str().size();
     }
 
-    json_value& json_value::operator = (json_string&& r)
+    bool json_key::empty() const
     {
-        if (this == &_get_none_value())
-        {
-            return _get_none_value();
-        }
+        return str().empty();
+    }
 
-        _reset_type(json_type::json_type_string);
-        if (nullptr != m_data._string_ptr)
-        {
-            *m_data._string_ptr = std::move(r);
-        }
-        return *this;
+    bool json_key::operator < (const json_key& r) const
+    {
+        return m_ptr != r.m_ptr && str() < r.str();
     }
 
-    json_value& json_value::operator = (json_object&& r)
+    bool json_key::operator == (const json_key& r) const
     {
-        if (this == &_get_none_value())
-        {
-            return _get_none_value();
-        }
+        return m_ptr == r.m_ptr || str() == r.str();
+    }
 
-        _reset_type(json_type::json_type_object);
-        if (nullptr != m_data._object_ptr)
-        {
-            *m_data._object_ptr = std::move(r);
-        }
-        return *this;
+    bool json_key::operator != (const json_key& r) const
+    {
+        return !(*this == r);
     }
 
-    json_value& json_value::operator = (json_array&& r)
+    void json_key::_release()
     {
-        if (this == &_get_none_value())
+        if (0 == m_ptr || (m_ptr & 1))
         {
-            return _get_none_value();
+            m_ptr = 0;
+            return;
         }
 
-        _reset_type(json_type::json_type_array);
-        if (nullptr != m_data._array_ptr)
+        json_key_data* data_ptr = (json_key_data*)m_ptr;
+        if (1 == data_ptr->ref_count.fetch_sub(1, std::memory_order_acq_rel))
         {
-            *m_data._array_ptr = std::move(r);
+            delete data_ptr;
         }
-        return *this;
+
+        m_ptr = 0;
     }
 
-    json_value& json_value::operator = (json_bin&& r)
+    json_key json_key_pool::intern(const _tstring& text)
     {
-        if (this == &_get_none_value())
+        auto it_find = m_keys.find(text);
+        if (m_keys.end() != it_find)
         {
-            return _get_none_value();
+            return it_find->second;
         }
 
-        _reset_type(json_type::json_type_bin);
-        if (nullptr != m_data._raw_ptr)
-        {
-            *m_data._raw_ptr = std::move(r);
-        }
-        return *this;
+        json_key key(text);
+        m_keys.emplace(text, key);
+        return key;
     }
 
-    json_value& json_value::operator = (json_value&& r) noexcept
+    size_t json_key_pool::size() const
     {
-        if (this == &_get_none_value())
-        {
-            return _get_none_value();
-        }
+        return m_keys.size();
+    }
 
-        if (&r != this)
-        {
-            clear();
-            m_type = r.m_type;
-            m_data = r.m_data;
+    void json_key_pool::clear()
+    {
+        m_keys.clear();
+    }
 
-            r.m_data = { 0 };
-            r.m_type = json_type::json_type_null;
-        }
+    inline json_key _json_lookup_key(const _tstring& name)
+    {
+        return json_key::borrow(name);
+    }
 
-        return *this;
+#else
+
+    inline const _tstring& _json_lookup_key(const _tstring& name)
+    {
+        return name;
     }
 
-    json_value& json_value::operator[](const _tstring& val_name) noexcept
+#endif
+
+    // Heap bytes of a string buffer, 0 when the text is held in the string object itself
+    static size_t _json_string_heap_bytes(const _tstring& text)
     {
-        if (this == &_get_none_value())
+        const uint8_t* data_ptr = (const uint8_t*)text.data();
+        const uint8_t* object_ptr = (const uint8_t*)&text;
+        if (data_ptr >= object_ptr && data_ptr < object_ptr + sizeof(text))
         {
-            return _get_none_value();
+            return 0;
         }
 
-        if (!is_object())
+        return (text.capacity() + 1) * sizeof(_tchar);
+    }
+
+    // Structural index (json_parse_indexed)
+    class json_index
+    {
+    public:
+
+        json_index(const _tchar* data_ptr, size_t size, json_arena* arena = nullptr) :
+            m_text(data_ptr),
+            m_size(size),
+            m_arena(arena),
+            m_structural_pos(0),
+            m_escape_pos(0),
+            m_depth(0)
         {
-            return _get_none_value();
         }
 
-        if (nullptr == m_data._object_ptr)
+        // Stage 1: record the positions of { } [ ] : , both quotes of every string and the start of
+        // every number or literal, plus the backslashes and NULs inside strings
+        bool build()
         {
-            m_data._object_ptr = new (std::nothrow) json_object;
-            if (nullptr == m_data._object_ptr)
+            json_classify_block_fn classify_fn = _get_classify_block();
+            const uint64_t even_bits = 0x5555555555555555ULL;
+            uint64_t prev_escaped = 0;
+            uint64_t prev_in_string = 0;
+            uint64_t prev_scalar = 0;
+            size_t structural_count = 0;
+
+            m_structurals.resize(m_size / 4 + 64);
+
+            for (size_t pos = 0; pos < m_size; pos += 64)
             {
-                return _get_none_value();
+                json_block_masks masks;
+
+                if (m_size - pos >= 64)
+                {
+                    classify_fn(m_text + pos, masks);
+                }
+                else
+                {
+                    _tchar text_buffer[64];
+                    size_t count = m_size - pos;
+                    for (size_t i = 0; i < 64; i++)
+                    {
+                        text_buffer[i] = i < count ? m_text[pos + i] : _T(' ');
+                    }
+                    classify_fn(text_buffer, masks);
+                }
+
+                // Characters preceded by an odd number of backslashes are escaped
+                uint64_t backslash = masks.backslash & ~prev_escaped;
+                uint64_t follows_escape = (backslash << 1) | prev_escaped;
+                uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+                uint64_t even_sequences = odd_starts + backslash;
+                prev_escaped = even_sequences < odd_starts ? 1 : 0;
+                uint64_t escaped = (even_bits ^ (even_sequences << 1)) & follows_escape;
+
+                // Prefix xor of the quotes: set from the opening quote up to the closing quote
+                uint64_t quote = masks.quote & ~escaped;
+                uint64_t in_string = quote;
+                in_string ^= in_string << 1;
+                in_string ^= in_string << 2;
+                in_string ^= in_string << 4;
+                in_string ^= in_string << 8;
+                in_string ^= in_string << 16;
+                in_string ^= in_string << 32;
+                in_string ^= prev_in_string;
+                prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+
+                uint64_t scalar = ~(masks.whitespace | masks.op | quote | in_string);
+                uint64_t scalar_start = scalar & ~((scalar << 1) | prev_scalar);
+                prev_scalar = scalar >> 63;
+
+                uint64_t structural = (masks.op & ~in_string) | quote | scalar_start;
+                // A NUL inside a string takes the slow path, which rejects it
+                uint64_t escape = (masks.backslash | masks.nul) & in_string;
+
+                if (structural_count + 64 > m_structurals.size())
+                {
+                    m_structurals.resize(m_structurals.size() * 2);
+                }
+
+                uint32_t* out_ptr = m_structurals.data() + structural_count;
+                while (0 != structural)
+                {
+                    *out_ptr++ = (uint32_t)(pos + _json_ctz64(structural));
+                    structural &= structural - 1;
+                }
+                structural_count = out_ptr - m_structurals.data();
+
+                while (0 != escape)
+                {
+                    m_escapes.push_back((uint32_t)(pos + _json_ctz64(escape)));
+                    escape &= escape - 1;
+                }
             }
+
+            m_structurals.resize(structural_count);
+
+            // Unterminated string
+            return 0 == prev_in_string;
         }
 
-        auto it_find = m_data._object_ptr->find(val_name);
-        if (m_data._object_ptr->end() != it_find)
+        // Stage 2: walk the index
+        bool next(size_t* pos_ptr)
         {
-            return it_find->second;
-        }
+            if (m_structural_pos >= m_structurals.size())
+            {
+                return false;
+            }
 
-        auto it_insert = m_data._object_ptr->insert(std::make_pair(val_name, json_value()));
-        return it_insert.first->second;
-    }
+            *pos_ptr = m_structurals[m_structural_pos++];
+            return true;
+        }
 
-    json_value& json_value::operator[](size_t index) noexcept
-    {
-        if (this == &_get_none_value())
+        // Position of the next structural, or the text size if there is none
+        size_t peek() const
         {
-            return _get_none_value();
+            if (m_structural_pos >= m_structurals.size())
+            {
+                return m_size;
+            }
+
+            return m_structurals[m_structural_pos];
         }
 
-        if (!is_array())
+        bool is_end() const
         {
-            return _get_none_value();
+            return m_structural_pos >= m_structurals.size();
         }
 
-        if (nullptr == m_data._array_ptr)
+        // Whether a backslash or NUL lies in [begin_pos, end_pos), positions must be increasing between calls
+        bool has_escape(size_t begin_pos, size_t end_pos)
         {
-            m_data._array_ptr = new (std::nothrow) json_array;
-            if (nullptr == m_data._array_ptr)
+            while (m_escape_pos < m_escapes.size() && m_escapes[m_escape_pos] < begin_pos)
             {
-                return _get_none_value();
+                m_escape_pos++;
             }
+
+            return m_escape_pos < m_escapes.size() && m_escapes[m_escape_pos] < end_pos;
         }
 
-        if (m_data._array_ptr->size() <= index)
+        // Open a container, false past FC_JSON_MAX_DEPTH
+        bool enter()
         {
-            m_data._array_ptr->resize(index + 1);
+            return ++m_depth <= FC_JSON_MAX_DEPTH;
         }
 
-        return (*m_data._array_ptr)[index];
-    }
-
-    json_value::~json_value()
-    {
-        clear();
-    }
-
-    json_type json_value::type() const
-    {
-        return m_type;
-    }
+        void leave()
+        {
+            m_depth--;
+        }
 
-    _tstring json_value::type_name() const
-    {
-        if (json_type::json_type_null == m_type) return _T("Null");
-        if (json_type::json_type_bool == m_type) return _T("Bool");
-        if (json_type::json_type_int == m_type) return _T("Integer");
-        if (json_type::json_type_uint == m_type) return _T("Unsigned Integer");
-        if (json_type::json_type_float == m_type) return _T("Float");
-        if (json_type::json_type_string == m_type) return _T("String");
-        if (json_type::json_type_object == m_type) return _T("Object");
-        if (json_type::json_type_array == m_type) return _T("Array");
-        return _T("None");
-    }
+        const _tchar* text() const
+        {
+            return m_text;
+        }
 
-    bool json_value::remove(const _tstring& name)
-    {
-        if (!is_object())
+        const _tchar* text_end() const
         {
-            return false;
+            return m_text + m_size;
         }
 
-        if (nullptr == m_data._object_ptr)
+        json_arena* arena() const
         {
-            return false;
+            return m_arena;
         }
 
-        json_object& object = *m_data._object_ptr;
-        auto it_find = object.find(name);
-        if (object.end() == it_find)
+#ifdef FC_JSON_INTERN_KEYS
+        json_key_pool& key_pool()
         {
-            return false;
+            return m_key_pool;
         }
+#endif
 
-        object.erase(it_find);
+    private:
+
+        const _tchar*           m_text;             // Text
+        size_t                  m_size;             // Text length
+        json_arena*             m_arena;            // Arena for the document, or nullptr
+        std::vector<uint32_t>   m_structurals;      // Structural positions
+        std::vector<uint32_t>   m_escapes;          // Backslash and NUL positions inside strings
+        size_t                  m_structural_pos;   // Next structural
+        size_t                  m_escape_pos;       // Next backslash
+        size_t                  m_depth;            // Open containers
+#ifdef FC_JSON_INTERN_KEYS
+        json_key_pool           m_key_pool;         // Keys of this document
+#endif
+    };
 
-        return true;
-    }
+    // Read size of files that cannot be mapped, such as pipes
+    static const size_t json_file_read_size = 64 * 1024;
 
-    bool json_value::remove(const size_t index)
+    // Read-only view of a whole file, memory mapped when possible
+    class json_file_view
     {
-        if (!is_array())
-        {
-            return false;
-        }
+    public:
 
-        if (nullptr == m_data._array_ptr)
+        json_file_view() :
+#ifdef _WIN32
+            m_file(INVALID_HANDLE_VALUE),
+            m_mapping(nullptr),
+#endif
+            m_data(nullptr),
+            m_size(0),
+            m_mapped(false)
         {
-            return false;
         }
 
-        json_array& array = *m_data._array_ptr;
-        if (index >= array.size())
+        ~json_file_view()
         {
-            return false;
+            close();
         }
 
-        array.erase(array.begin() + index);
+        bool open(const _tstring& file_path)
+        {
+            close();
 
-        return true;
-    }
-
-    bool json_value::is_null() const
-    {
-        return json_type::json_type_null == m_type;
-    }
+            if (_map(file_path))
+            {
+                return true;
+            }
 
-    bool json_value::is_bool() const
-    {
-        return json_type::json_type_bool == m_type;
-    }
+            // Fall back to reading the file until EOF, its size may be unknown
+            std::ifstream input_file(file_path, std::ios::binary | std::ios::in);
+            if (!input_file.is_open())
+            {
+                return false;
+            }
 
-    bool json_value::is_int() const
-    {
-        return json_type::json_type_int == m_type || json_type::json_type_uint == m_type;
-    }
+            size_t read_size = 0;
+            while (input_file)
+            {
+                if (m_buffer.size() - read_size < json_file_read_size)
+                {
+                    m_buffer.resize(m_buffer.size() * 2 + json_file_read_size);
+                }
 
-    bool json_value::is_float() const
-    {
-        return json_type::json_type_float == m_type;
-    }
+                input_file.read(&m_buffer[read_size], m_buffer.size() - read_size);
+                read_size += (size_t)input_file.gcount();
+            }
 
-    bool json_value::is_number() const
-    {
-        return json_type::json_type_int == m_type || json_type::json_type_uint == m_type || json_type::json_type_float == m_type;
-    }
+            if (input_file.bad())
+            {
+                m_buffer.clear();
+                return false;
+            }
 
-    bool json_value::is_string() const
-    {
-        return json_type::json_type_string == m_type;
-    }
+            m_buffer.resize(read_size);
+            m_data = (const uint8_t*)m_buffer.data();
+            m_size = m_buffer.size();
+            return true;
+        }
 
-    bool json_value::is_object() const
-    {
-        return json_type::json_type_object == m_type;
-    }
+        void close()
+        {
+#ifdef _WIN32
+            if (m_mapped)
+            {
+                ::UnmapViewOfFile(m_data);
+            }
 
-    bool json_value::is_array() const
-    {
-        return json_type::json_type_array == m_type;
-    }
+            if (nullptr != m_mapping)
+            {
+                ::CloseHandle(m_mapping);
+                m_mapping = nullptr;
+            }
 
-    bool json_value::is_bin() const
-    {
-        return json_type::json_type_bin == m_type;
-    }
+            if (INVALID_HANDLE_VALUE != m_file)
+            {
+                ::CloseHandle(m_file);
+                m_file = INVALID_HANDLE_VALUE;
+            }
+#else
+            if (m_mapped)
+            {
+                ::munmap((void*)m_data, m_size);
+            }
+#endif
+            m_buffer.clear();
+            m_data = nullptr;
+            m_size = 0;
+            m_mapped = false;
+        }
 
-    json_bool json_value::as_bool() const
-    {
-        if (json_type::json_type_bool != m_type)
+        const uint8_t* data() const
         {
-            throw json_exception(__JSON_FUNCTION__);
+            return m_data;
         }
 
-        return m_data._bool;
-    }
-
-    json_bool json_value::as_bool(json_bool default_val) const
-    {
-        if (json_type::json_type_bool != m_type)
+        size_t size() const
         {
-            return default_val;
+            return m_size;
         }
 
-        return m_data._bool;
-    }
+    private:
 
-    json_int json_value::as_int() const
-    {
-        if (!(json_type::json_type_int == m_type || json_type::json_type_uint == m_type))
+        bool _map(const _tstring& file_path)
         {
-            throw json_exception(__JSON_FUNCTION__);
-        }
+#ifdef _WIN32
+            m_file = ::CreateFile(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (INVALID_HANDLE_VALUE == m_file)
+            {
+                return false;
+            }
 
-        return m_data._int;
-    }
+            // Pipes and files of unknown size are read through the same handle, opening them again
+            // would lose what the writer has sent
+            LARGE_INTEGER file_size = { 0 };
+            if (FILE_TYPE_DISK != ::GetFileType(m_file) || !::GetFileSizeEx(m_file, &file_size) || 0 == file_size.QuadPart)
+            {
+                bool result = _read_all(m_file);
+                ::CloseHandle(m_file);
+                m_file = INVALID_HANDLE_VALUE;
+                return result;
+            }
 
-    json_int json_value::as_int(json_int default_val) const
-    {
-        if (!(json_type::json_type_int == m_type || json_type::json_type_uint == m_type))
-        {
-            return default_val;
-        }
+            if ((uint64_t)file_size.QuadPart > SIZE_MAX)
+            {
+                close();
+                return false;
+            }
 
-        return m_data._int;
-    }
+            m_mapping = ::CreateFileMapping(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (nullptr == m_mapping)
+            {
+                close();
+                return false;
+            }
 
-    json_uint json_value::as_uint() const
-    {
-        if (!(json_type::json_type_int == m_type || json_type::json_type_uint == m_type))
-        {
-            throw json_exception(__JSON_FUNCTION__);
-        }
+            m_data = (const uint8_t*)::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+            if (nullptr == m_data)
+            {
+                close();
+                return false;
+            }
 
-        return m_data._uint;
-    }
+            m_size = (size_t)file_size.QuadPart;
+            m_mapped = true;
+            return true;
+#else
+#ifdef _UNICODE
+            int fd = ::open(_utf16_to_utf8(file_path).c_str(), O_RDONLY);
+#else
+            int fd = ::open(file_path.c_str(), O_RDONLY);
+#endif
+            if (fd < 0)
+            {
+                return false;
+            }
 
-    json_uint json_value::as_uint(json_uint default_val) const
-    {
-        if (!(json_type::json_type_int == m_type || json_type::json_type_uint == m_type))
-        {
-            return default_val;
-        }
+            struct stat file_stat;
+            if (0 != ::fstat(fd, &file_stat))
+            {
+                ::close(fd);
+                return false;
+            }
 
-        return m_data._uint;
-    }
+            // Pipes, FIFOs and files of unknown size are read through the same descriptor, opening
+            // them again would lose what the writer has sent
+            if (!S_ISREG(file_stat.st_mode) || 0 == file_stat.st_size)
+            {
+                bool result = _read_all(fd);
+                ::close(fd);
+                return result;
+            }
 
-    json_float json_value::as_float() const
-    {
-        if (json_type::json_type_float != m_type)
-        {
-            throw json_exception(__JSON_FUNCTION__);
-        }
+            void* map_ptr = ::mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
 
-        return m_data._float;
-    }
+            // The mapping stays valid after the descriptor is closed
+            ::close(fd);
 
-    json_float json_value::as_float(json_float default_val) const
-    {
-        if (json_type::json_type_float != m_type)
-        {
-            return default_val;
-        }
+            if (MAP_FAILED == map_ptr)
+            {
+                return false;
+            }
 
-        return m_data._float;
-    }
+            ::madvise(map_ptr, (size_t)file_stat.st_size, MADV_SEQUENTIAL);
 
-    json_float json_value::as_number() const
-    {
-        if (!is_number())
-        {
-            throw json_exception(__JSON_FUNCTION__);
+            m_data = (const uint8_t*)map_ptr;
+            m_size = (size_t)file_stat.st_size;
+            m_mapped = true;
+            return true;
+#endif
         }
 
-        return m_data._float;
-    }
-
-    json_float json_value::as_number(json_float default_val) const
-    {
-        if (!is_number())
+        // Reads until EOF in chunks, the buffer grows geometrically
+#ifdef _WIN32
+        bool _read_all(HANDLE file)
+#else
+        bool _read_all(int fd)
+#endif
         {
-            return default_val;
-        }
+            size_t read_size = 0;
 
-        return m_data._float;
-    }
+            while (true)
+            {
+                if (m_buffer.size() - read_size < json_file_read_size)
+                {
+                    m_buffer.resize(m_buffer.size() * 2 + json_file_read_size);
+                }
 
-    json_string& json_value::as_string() const
-    {
-        if (json_type::json_type_string != m_type)
-        {
-            throw json_exception(__JSON_FUNCTION__);
-        }
+#ifdef _WIN32
+                DWORD request_size = (DWORD)std::min<size_t>(m_buffer.size() - read_size, 0x40000000);
+                DWORD count = 0;
+                if (!::ReadFile(file, &m_buffer[read_size], request_size, &count, nullptr))
+                {
+                    // The writer closed its end of the pipe
+                    if (ERROR_BROKEN_PIPE == ::GetLastError())
+                    {
+                        break;
+                    }
 
-        return *m_data._string_ptr;
-    }
+                    m_buffer.clear();
+                    return false;
+                }
+#else
+                ssize_t count = ::read(fd, &m_buffer[read_size], m_buffer.size() - read_size);
+                if (count < 0)
+                {
+                    if (EINTR == errno)
+                    {
+                        continue;
+                    }
 
-    json_string json_value::as_string(json_string default_val) const
-    {
-        if (json_type::json_type_string != m_type)
-        {
-            return default_val;
-        }
+                    m_buffer.clear();
+                    return false;
+                }
+#endif
+                if (0 == count)
+                {
+                    break;
+                }
 
-        return *m_data._string_ptr;
-    }
+                read_size += (size_t)count;
+            }
 
-    json_object& json_value::as_object() const
-    {
-        if (json_type::json_type_object != m_type)
-        {
-            throw json_exception(__JSON_FUNCTION__);
+            m_buffer.resize(read_size);
+            m_data = (const uint8_t*)m_buffer.data();
+            m_size = m_buffer.size();
+            return true;
         }
 
-        return *m_data._object_ptr;
-    }
+    private:
 
-    json_object json_value::as_object(json_object default_val) const
-    {
-        if (json_type::json_type_object != m_type)
-        {
-            return default_val;
-        }
+#ifdef _WIN32
+        HANDLE                  m_file;             // File handle
+        HANDLE                  m_mapping;          // File mapping handle
+#endif
+        const uint8_t*          m_data;             // File content
+        size_t                  m_size;             // File size
+        bool                    m_mapped;           // Whether m_data is a mapped view
+        std::string             m_buffer;           // File content when mapping is unavailable
+    };
 
-        return *m_data._object_ptr;
-    }
+    // Characters a streaming dump buffers before passing them to its sink
+    static const size_t json_dump_buffer_size = 64 * 1024;
+
+    // Characters of a string dump past which the whole text is measured and reserved once
+    static const size_t json_dump_reserve_size = 4 * 1024 * 1024;
 
-    json_array& json_value::as_array() const
+    // Length of the whole text of a dump
+    using json_dump_length = std::function<size_t()>;
+
+    // Output of the _dump functions: a string, or a bounded buffer handed to a sink whenever it fills
+    class json_writer
     {
-        if (json_type::json_type_array != m_type)
+    public:
+
+        json_writer(_tstring& text)
+            :
+            m_text(text),
+            m_sink(nullptr),
+            m_measure(nullptr),
+            m_flush_size(SIZE_MAX),
+            m_failed(false)
         {
-            throw json_exception(__JSON_FUNCTION__);
         }
 
-        return *m_data._array_ptr;
-    }
+        // measure gives the length of the whole text, it is called once the text outgrows json_dump_reserve_size
+        json_writer(_tstring& text, const json_dump_length& measure)
+            :
+            m_text(text),
+            m_sink(nullptr),
+            m_measure(&measure),
+            m_flush_size(json_dump_reserve_size),
+            m_failed(false)
+        {
+        }
 
-    json_array json_value::as_array(json_array default_val) const
-    {
-        if (json_type::json_type_array != m_type)
+        json_writer(const json_dump_sink& sink)
+            :
+            m_text(m_buffer),
+            m_sink(&sink),
+            m_measure(nullptr),
+            m_flush_size(json_dump_buffer_size),
+            m_failed(false)
         {
-            return default_val;
+            m_buffer.reserve(json_dump_buffer_size);
         }
 
-        return *m_data._array_ptr;
-    }
+        json_writer(const json_writer&) = delete;
+        json_writer& operator = (const json_writer&) = delete;
 
-    json_bin& json_value::as_bin() const
-    {
-        if (json_type::json_type_bin != m_type)
+        void append(const _tchar* data_ptr, size_t size)
         {
-            throw json_exception(__JSON_FUNCTION__);
-        }
+            while (size > m_flush_size - m_text.size())
+            {
+                // A large text is reserved whole, sparing the copies of geometric growth and its slack
+                // The text moves to a new string, reserve() on a grown one may round up to twice its capacity
+                if (nullptr != m_measure)
+                {
+                    _tstring whole_text;
+                    whole_text.reserve(std::max((*m_measure)(), m_text.size() + size));
+                    whole_text.append(m_text);
+                    m_text.swap(whole_text);
+                    m_measure = nullptr;
+                    m_flush_size = SIZE_MAX;
+                    break;
+                }
 
-        return *m_data._raw_ptr;
-    }
+                // Long strings are passed on in buffer sized pieces
+                size_t count = m_flush_size - m_text.size();
+                m_text.append(data_ptr, count);
+                data_ptr += count;
+                size -= count;
+                flush();
+            }
 
-    json_bin json_value::as_bin(json_bin default_val) const
-    {
-        if (json_type::json_type_bin != m_type)
+            m_text.append(data_ptr, size);
+        }
+
+        void push_back(_tchar ch)
         {
-            return default_val;
+            append(&ch, 1);
         }
 
-        return *m_data._raw_ptr;
-    }
+        json_writer& operator += (const _tchar* text)
+        {
+            append(text, std::char_traits<_tchar>::length(text));
+            return *this;
+        }
 
-    bool json_value::has_value(const _tstring& name) const
-    {
-        if (this == &_get_none_value())
+        json_writer& operator += (const _tstring& text)
         {
-            return false;
+            append(text.data(), text.size());
+            return *this;
         }
 
-        if (is_object() && m_data._object_ptr)
+        // Hands the buffered text to the sink, after a failure the text is dropped
+        bool flush()
         {
-            auto it_find = m_data._object_ptr->find(name);
-            if (m_data._object_ptr->end() != it_find)
+            if (m_sink && !m_text.empty())
             {
-                return true;
+                if (!m_failed && !(*m_sink)(m_text.data(), m_text.size()))
+                {
+                    m_failed = true;
+                }
+
+                m_text.clear();
             }
+
+            return !m_failed;
         }
 
-        return false;
-    }
+    private:
 
-    size_t json_value::count() const
+        _tstring                m_buffer;           // Buffer of a sink writer
+        _tstring&               m_text;             // Text appended to, the caller's string or m_buffer
+        const json_dump_sink*   m_sink;             // Sink, nullptr when writing to a string
+        const json_dump_length* m_measure;          // Length of the whole text, nullptr once reserved
+        size_t                  m_flush_size;       // Buffered characters that trigger a flush
+        bool                    m_failed;           // The sink returned false
+    };
+
+    // json_parse_parallel: values shorter than this are not split, nor levels past the descent limit
+    static const size_t json_parallel_min_size = 1024 * 1024;
+    static const size_t json_parallel_max_descent = 8;
+
+    // State of one json_parse_parallel walk, or of one thread parsing array slices
+    struct json_parallel_context
     {
-        if (this == &_get_none_value())
+        json_parallel_context(size_t threads) :
+            thread_count(threads)
         {
-            return 0;
         }
 
-        if (is_array() && m_data._array_ptr)
+        size_t          thread_count;       // Threads that may parse array slices
+#ifdef FC_JSON_INTERN_KEYS
+        json_key_pool   key_pool;           // Keys parsed on this thread
+#endif
+    };
+
+    // json_value::m_long.flags
+    enum json_value_flag : uint8_t
+    {
+        json_flag_arena     = 0x01,         // Payload placed in a json_arena, destroyed without delete
+        json_flag_short     = 0x02,         // String stored in m_short
+    };
+
+    json_value::json_value(json_type type)
+    {
+        m_long.type = type;
+        m_long.flags = 0;
+        m_long.data = { 0 };
+
+        if (json_type::json_type_string == m_long.type)
         {
-            return m_data._array_ptr->size();
+            m_long.flags = json_flag_short;
+            m_short.text[0] = _T('\0');
         }
 
-        if (is_object() && m_data._object_ptr)
+        if (json_type::json_type_array == m_long.type)
         {
-            return m_data._object_ptr->size();
+            m_long.data._array_ptr = new (std::nothrow) json_array;
         }
 
-        return 0;
+        if (json_type::json_type_object == m_long.type)
+        {
+            m_long.data._object_ptr = new (std::nothrow) json_object;
+        }
     }
 
-    bool json_value::parse(const _tstring& text)
+    json_value::json_value(nullptr_t) : json_value()
     {
-        clear();
-        const _tchar* end_ptr = nullptr;
-        return _parse(text.c_str(), *this, &end_ptr);
     }
 
-    bool json_value::parse_from_file(const _tstring& file_path)
+    json_value::json_value(json_bool val)
     {
-        std::string str_utf8;
-        std::wstring str_utf16;
-        _tstring read_text;
+        m_long.type = json_type::json_type_bool;
+        m_long.flags = 0;
+        m_long.data._bool = val;
+    }
 
-        clear();
-        do
-        {
-            std::ifstream input_file(file_path, std::ios::binary | std::ios::in);
-            if (!input_file.is_open())
-            {
-                return false;
-            }
-
-            input_file.seekg(0, std::ios::end);
-            std::streamoff text_size = input_file.tellg();
-            input_file.seekg(0, std::ios::beg);
-
-            std::string text_buffer(text_size, 0);
-            input_file.read((char*)&text_buffer[0], text_size);
-            size_t byte_count = (size_t)input_file.gcount();
-            input_file.close();
-
-            if (0 == byte_count)
-            {
-                break;
-            }
-
-            int32_t utf8_length = _utf8_to_utf16(text_buffer.data(), text_buffer.size(), &str_utf8, &str_utf16);
-
-#ifdef _UNICODE
-            if (utf8_length > 0)
-            {
-                read_text = str_utf16;
-                break;
-            }
-#else
-            if (utf8_length > 0)
-            {
-                read_text = str_utf8;
-                break;
-            }
-#endif
-
-            int32_t utf16_length = _utf16_to_utf8(text_buffer.data(), text_buffer.size(), &str_utf8, &str_utf16);
-
-#ifdef _UNICODE
-            if (utf16_length > 0)
-            {
-                read_text = str_utf16;
-                break;
-            }
-#else
-            if (utf16_length > 0)
-            {
-                read_text = str_utf8;
-                break;
-            }
-#endif
-
-        } while (false);
+    json_value::json_value(int32_t val)
+    {
+        m_long.type = json_type::json_type_int;
+        m_long.flags = 0;
+        m_long.data._int = val;
+    }
 
-        const _tchar* end_ptr = nullptr;
-        return _parse(read_text.c_str(), *this, &end_ptr);
+    json_value::json_value(uint32_t val)
+    {
+        m_long.type = json_type::json_type_int;
+        m_long.flags = 0;
+        m_long.data._uint = val;
     }
 
-    bool json_value::parse_from_binary(uint8_t* data, size_t size)
+    json_value::json_value(int64_t val)
     {
-        clear();
-        const uint8_t* data_end = data + size;
-        return _parse_raw(data, &data_end, *this);
+        m_long.type = json_type::json_type_int;
+        m_long.flags = 0;
+        m_long.data._int = val;
     }
 
-    bool json_value::parse_from_binary_file(const _tstring& file_path)
+    json_value::json_value(uint64_t val)
     {
-        clear();
+        m_long.type = json_type::json_type_uint;
+        m_long.flags = 0;
+        m_long.data._uint = val;
+    }
 
-        std::ifstream input_file(file_path, std::ios::binary | std::ios::in);
-        if (!input_file.is_open())
-        {
-            return false;
-        }
+    json_value::json_value(json_float val)
+    {
+        m_long.type = json_type::json_type_float;
+        m_long.flags = 0;
+        m_long.data._float = val;
+    }
 
-        input_file.seekg(0, std::ios::end);
-        std::streamoff text_size = input_file.tellg();
-        input_file.seekg(0, std::ios::beg);
+    json_value::json_value(const _tchar* val)
+    {
+        m_long.type = json_type::json_type_null;
+        m_long.flags = 0;
+        m_long.data = { 0 };
+        _reset_string(val ? val : _T(""), val ? std::char_traits<_tchar>::length(val) : 0);
+    }
 
-        std::vector<uint8_t> text_buffer(text_size, 0);
-        input_file.read((char*)&text_buffer[0], text_size);
-        size_t byte_count = (size_t)input_file.gcount();
-        input_file.close();
+    json_value::json_value(const json_string& r)
+    {
+        m_long.type = json_type::json_type_null;
+        m_long.flags = 0;
+        m_long.data = { 0 };
+        _reset_string(r.data(), r.size());
+    }
 
-        const uint8_t* data_end = text_buffer.data() + text_buffer.size();
-        return _parse_raw(text_buffer.data(), &data_end, *this);
+    json_value::json_value(const json_object& r)
+    {
+        m_long.type = json_type::json_type_object;
+        m_long.flags = 0;
+        m_long.data._object_ptr = new (std::nothrow) json_object(r);
     }
 
-    _tstring json_value::dump(int indent/* = 0*/, bool flag_escape/* = false*/) const
+    json_value::json_value(const json_array& r)
     {
-        _tstring result_text;
-        std::vector<_tstring> indent_text({ _T("") });
-        _dump(result_text, indent_text, 0, indent, flag_escape);
-        return result_text;
+        m_long.type = json_type::json_type_array;
+        m_long.flags = 0;
+        m_long.data._array_ptr = new (std::nothrow) json_array(r);
     }
 
-    bool json_value::dump_to_file(const _tstring& strPath, int indent/* = 0*/, bool flag_escape/* = false*/, json_encoding encoding/* = json_encoding::json_encoding_auto*/)
+    json_value::json_value(const json_bin& r)
     {
-        _tstring dump_text;
-        std::vector<_tstring> indent_text({ _T("") });
-        _dump(dump_text, indent_text, 0, indent, flag_escape);
+        m_long.type = json_type::json_type_bin;
+        m_long.flags = 0;
+        m_long.data._raw_ptr = new (std::nothrow) json_bin(r);
 
-        std::string str_utf8;
-        std::wstring str_utf16;
-        _tstring result_text;
+    }
 
-        str_utf16.push_back((uint16_t)0xFEFF);
+    json_value::json_value(const json_value& r)
+    {
+        m_long.type = r.m_long.type;
+        m_long.flags = 0;
 
-        std::ofstream output_file(strPath, std::ios::binary | std::ios::out);
-        if (!output_file.is_open())
+        switch (m_long.type)
         {
-            return false;
+        case json_type::json_type_string:
+        {
+            if (r.m_long.flags & json_flag_short)
+            {
+                m_long.flags = json_flag_short;
+                memcpy(m_short.text, r.m_short.text, sizeof(m_short.text));
+            }
+            else
+            {
+                m_long.data._string_ptr = new (std::nothrow) json_string(*r.m_long.data._string_ptr);
+            }
         }
-
-#ifdef _UNICODE
-        result_text = str_utf16;
-
-        if (json_encoding::json_encoding_utf16 == encoding || json_encoding::json_encoding_auto == encoding)
+        break;
+        case json_type::json_type_object:
         {
-            result_text += dump_text;
-            output_file.write((const char*)result_text.data(), result_text.size() * sizeof(_tchar));
-            output_file.close();
+            m_long.data._object_ptr = r.m_long.data._object_ptr ? new (std::nothrow) json_object(*r.m_long.data._object_ptr) : nullptr;
         }
-
-        if (json_encoding::json_encoding_utf8 == encoding)
+        break;
+        case json_type::json_type_array:
         {
-            int32_t utf8_length = _utf16_to_utf8(dump_text.c_str(), (size_t)-1, &str_utf8, nullptr);
-            if (utf8_length >= 0)
-            {
-                output_file.write((const char*)str_utf8.data(), str_utf8.size() * sizeof(char));
-                output_file.close();
-            }
+            m_long.data._array_ptr = r.m_long.data._array_ptr ? new (std::nothrow) json_array(*r.m_long.data._array_ptr) : nullptr;
         }
-
-#else
-        result_text = str_utf8;
-
-        if (json_encoding::json_encoding_utf8 == encoding || json_encoding::json_encoding_auto == encoding)
+        break;
+        case json_type::json_type_bin:
         {
-            result_text += dump_text;
-            output_file.write((const char*)result_text.data(), result_text.size() * sizeof(_tchar));
-            output_file.close();
+            m_long.data._raw_ptr = new (std::nothrow) json_bin(*r.m_long.data._raw_ptr);
         }
-
-        if (json_encoding::json_encoding_utf16 == encoding)
+        break;
+        default:
         {
-            int32_t utf8_length = _utf8_to_utf16(dump_text.c_str(), (size_t)-1, nullptr, &str_utf16);
-            if (utf8_length >= 0)
-            {
-                output_file.write((const char*)str_utf16.data(), str_utf16.size() * sizeof(wchar_t));
-                output_file.close();
-            }
+            m_long.data = r.m_long.data;
+        }
+        break;
         }
+    }
 
-#endif
+    json_value::json_value(json_string&& r)
+    {
+        m_long.type = json_type::json_type_null;
+        m_long.flags = 0;
+        m_long.data = { 0 };
+        _reset_string(std::move(r));
+    }
 
-        return true;
+    json_value::json_value(json_object&& r)
+    {
+        m_long.type = json_type::json_type_object;
+        m_long.flags = 0;
+        m_long.data._object_ptr = new (std::nothrow) json_object(std::move(r));
     }
 
-    bool json_value::_parse_number(const _tchar* data_ptr, json_value& val, const _tchar** end_ptr)
+    json_value::json_value(json_array&& r)
     {
-        // [-]?[0-9]+\.[0-9]+[eE]?[-+]?[0-9]+
-        const _tchar* start_ptr = data_ptr;
-        bool flag_negative = false;
-        bool flag_dot = false;
-        bool flag_exponent = false;
-        bool result_flag = false;
+        m_long.type = json_type::json_type_array;
+        m_long.flags = 0;
+        m_long.data._array_ptr = new (std::nothrow) json_array(std::move(r));
+    }
 
-        do
+    json_value::json_value(json_bin&& r)
+    {
+        m_long.type = json_type::json_type_bin;
+        m_long.flags = 0;
+        m_long.data._raw_ptr = new (std::nothrow) json_bin(std::move(r));
+    }
+
+    json_value::json_value(json_value&& r) noexcept
+    {
+        m_long.type = r.m_long.type;
+        m_long.flags = r.m_long.flags;
+
+        if (m_long.flags & json_flag_short)
         {
-            if (_T('-') == *data_ptr)
-            {
-                flag_negative = true;
-                data_ptr++;
-            }
+            memcpy(m_short.text, r.m_short.text, sizeof(m_short.text));
+        }
+        else
+        {
+            m_long.data = r.m_long.data;
+        }
 
-            if (!_skip_digit(data_ptr, &data_ptr))
+        r.m_long.data = { 0 };
+        r.m_long.type = json_type::json_type_null;
+        r.m_long.flags = 0;
+    }
+
+    void json_value::clear()
+    {
+        // The arena keeps the memory, only the destructor runs
+        if (m_long.flags & json_flag_arena)
+        {
+            switch (m_long.type)
             {
-                result_flag = false;
+            case json_type::json_type_string:
+                m_long.data._string_ptr->~json_string();
+                break;
+            case json_type::json_type_object:
+                m_long.data._object_ptr->~json_object();
+                break;
+            case json_type::json_type_array:
+                m_long.data._array_ptr->~json_array();
+                break;
+            case json_type::json_type_null:
+            case json_type::json_type_bool:
+            case json_type::json_type_int:
+            case json_type::json_type_uint:
+            case json_type::json_type_float:
+            case json_type::json_type_bin:
+                // Never placed in an arena
                 break;
             }
-
-            if (_T('.') == *data_ptr)
+        }
+        else if (0 == (m_long.flags & json_flag_short))
+        {
+            switch (m_long.type)
             {
-                flag_dot = true;
-                data_ptr++;
+            case json_type::json_type_string:
+            {
+                if (m_long.data._string_ptr)
+                {
+                    delete m_long.data._string_ptr;
+                }
             }
-
-            if (flag_dot)
+            break;
+            case json_type::json_type_object:
             {
-                if (!_skip_digit(data_ptr, &data_ptr))
+                if (m_long.data._object_ptr)
                 {
-                    break;
+                    delete m_long.data._object_ptr;
                 }
             }
-
-            if (_T('E') == *data_ptr || _T('e') == *data_ptr)
+            break;
+            case json_type::json_type_array:
             {
-                flag_exponent = true;
-                data_ptr++;
-
-                if (_T('-') == *data_ptr || _T('+') == *data_ptr)
+                if (m_long.data._array_ptr)
                 {
-                    data_ptr++;
+                    delete m_long.data._array_ptr;
                 }
-
-                if (!_skip_digit(data_ptr, &data_ptr))
+            }
+            break;
+            case json_type::json_type_bin:
+            {
+                if (m_long.data._raw_ptr)
                 {
-                    break;
+                    delete m_long.data._raw_ptr;
                 }
             }
+            break;
+            }
+        }
+
+        m_long.data = { 0 };
+        m_long.flags = 0;
+    }
+
+    inline void json_value::_reset_type(json_type type, json_arena* arena/* = nullptr*/)
+    {
+        if (this == &_get_none_value())
+        {
+            return;
+        }
+
+        clear();
+        m_long.type = type;
 
-            _tstring number_text(start_ptr, data_ptr - start_ptr);
+        if (json_type::json_type_string == m_long.type)
+        {
+            m_long.flags = json_flag_short;
+            m_short.text[0] = _T('\0');
+            return;
+        }
 
-            if (flag_dot || flag_exponent)
+        if (arena && (json_type::json_type_object == m_long.type || json_type::json_type_array == m_long.type))
+        {
+            void* data_ptr = nullptr;
+            if (json_type::json_type_object == m_long.type)
             {
-                val = _json_tcstod(number_text.c_str(), nullptr);
+                data_ptr = arena->allocate(sizeof(json_object), alignof(json_object));
+                m_long.data._object_ptr = data_ptr ? new (data_ptr) json_object(json_allocator<json_object::value_type>(arena)) : nullptr;
             }
             else
             {
-                if (flag_negative)
-                {
-                    val = (int64_t)_json_tcstoll(number_text.c_str(), nullptr, 10);
-                }
-                else
-                {
-                    val = (uint64_t)_json_tcstoull(number_text.c_str(), nullptr, 10);
-                }
-
-                if (ERANGE == errno)
-                {
-                    val = _json_tcstod(number_text.c_str(), nullptr);
-                    errno = 0;
-                }
+                data_ptr = arena->allocate(sizeof(json_array), alignof(json_array));
+                m_long.data._array_ptr = data_ptr ? new (data_ptr) json_array(json_allocator<json_value>(arena)) : nullptr;
             }
 
-            result_flag = true;
+            m_long.flags = data_ptr ? json_flag_arena : 0;
+            return;
+        }
 
-        } while (false);
+        if (json_type::json_type_array == m_long.type)
+        {
+            m_long.data._array_ptr = new (std::nothrow) json_array;
+        }
 
-        if (end_ptr)
+        if (json_type::json_type_object == m_long.type)
         {
-            *end_ptr = data_ptr;
+            m_long.data._object_ptr = new (std::nothrow) json_object;
         }
 
-        return result_flag;
+        if (json_type::json_type_bin == m_long.type)
+        {
+            m_long.data._raw_ptr = new (std::nothrow) json_bin;
+        }
     }
 
-    bool json_value::_parse_unicode(const _tchar* data_ptr, _tstring& val, const _tchar** end_ptr)
+    inline void json_value::_reset_string(const _tchar* data_ptr, size_t size)
     {
-        uint32_t cp32 = 0;
-        bool result_flag = false;
-
-        do
+        if (this == &_get_none_value())
         {
-            if (!_get_utf16_code_point(data_ptr, &cp32, &data_ptr))
-            {
-                break;
-            }
+            return;
+        }
 
-            // High bits
-            if (cp32 >= 0xD800 && cp32 <= 0xDBFF)
-            {
-                cp32 -= 0xD800;
+        _reset_type(json_type::json_type_string);
 
-                if (0 != _json_tcsncmp(_T(R"(\u)"), data_ptr, 2))
-                {
-                    break;
-                }
+        // Text with an embedded NUL stays on the heap, m_short is NUL terminated
+        if (size < json_short_size && nullptr == std::char_traits<_tchar>::find(data_ptr, size, _T('\0')))
+        {
+            std::char_traits<_tchar>::copy(m_short.text, data_ptr, size);
+            m_short.text[size] = _T('\0');
+            return;
+        }
 
-                data_ptr += 2;
+        m_long.flags = 0;
+        m_long.data._string_ptr = new (std::nothrow) json_string(data_ptr, size);
+    }
 
-                uint32_t cp_low = 0;
-                if (!_get_utf16_code_point(data_ptr, &cp_low, &data_ptr))
-                {
-                    break;
-                }
+    inline void json_value::_reset_string(json_string&& text, json_arena* arena/* = nullptr*/)
+    {
+        if (this == &_get_none_value())
+        {
+            return;
+        }
 
-                // Low Bits
-                if (cp_low >= 0xDC00 && cp_low <= 0xDFFF)
-                {
-                    cp_low -= 0xDC00;
+        if (text.size() < json_short_size)
+        {
+            _reset_string(text.data(), text.size());
+            return;
+        }
 
-                    cp32 = 0x10000 + ((cp32 << 10) | cp_low);
-#ifdef _UNICODE
-                    uint16_t cp = (uint16_t)(cp32 - 0x10000);
-                    uint16_t cp32_high = (uint16_t)(cp >> 10) + 0xD800;
-                    uint16_t cp32_low = (uint16_t)(cp & 0x3FF) + 0xDC00;
-                    val.push_back(cp32_high);
-                    val.push_back(cp32_low);
-#else
-                    val += std::move(_get_utf8_text_for_code_point(cp32));
-#endif
-                }
-                else
-                {
-                    break;
-                }
-            }
-            else
-            {
-#ifdef _UNICODE
-                val.push_back((_tchar)cp32);
-#else
-                val += std::move(_get_utf8_text_for_code_point(cp32));
-#endif
-            }
+        _reset_type(json_type::json_type_string);
+        m_long.flags = 0;
 
-            result_flag = true;
+        void* data_ptr = arena ? arena->allocate(sizeof(json_string), alignof(json_string)) : nullptr;
+        if (data_ptr)
+        {
+            m_long.data._string_ptr = new (data_ptr) json_string;
+            m_long.data._string_ptr->swap(text);
+            m_long.flags = json_flag_arena;
+            return;
+        }
 
-        } while (false);
+        m_long.data._string_ptr = new (std::nothrow) json_string(std::move(text));
+    }
 
-        if (end_ptr)
+    bool json_value::_promote_string()
+    {
+        json_string* string_ptr = new (std::nothrow) json_string(m_short.text);
+        if (nullptr == string_ptr)
         {
-            *end_ptr = data_ptr;
+            return false;
         }
 
-        return result_flag;
+        m_long.flags = 0;
+        m_long.data._string_ptr = string_ptr;
+        return true;
     }
 
-    bool json_value::_parse_string(const _tchar* data_ptr, _tstring& val, const _tchar** end_ptr)
+    bool json_value::_promote_container()
     {
-        bool flag_abort = false;
+        // Parsed empty containers carry no header until one is asked for
+        if (json_type::json_type_object == m_long.type)
+        {
+            m_long.data._object_ptr = new (std::nothrow) json_object;
+            return nullptr != m_long.data._object_ptr;
+        }
 
-        data_ptr = _skip_whitespace(data_ptr);
-        if (_T('\"') != *data_ptr)
+        if (json_type::json_type_array == m_long.type)
         {
-            return false;
+            m_long.data._array_ptr = new (std::nothrow) json_array;
+            return nullptr != m_long.data._array_ptr;
         }
 
-        data_ptr++;
+        return false;
+    }
 
-        while (_T('\0') != *data_ptr)
+    json_value& json_value::operator = (nullptr_t)
+    {
+        if (this == &_get_none_value())
         {
-            _tchar ch = *data_ptr;
-            if (_T('\"') == ch)
-            {
-                break;
-            }
+            return _get_none_value();
+        }
 
-            if (_T('\\') == ch)
-            {
-                data_ptr++;
-                ch = *data_ptr;
+        _reset_type(json_type::json_type_null);
+        return *this;
+    }
 
-                switch (ch)
-                {
-                case _T('\"'):
-                {
-                    val.push_back(_T('\"'));
-                }
-                break;
-                case _T('\\'):
-                {
-                    val.push_back(_T('\\'));
-                }
-                break;
-                case _T('/'):
-                {
-                    val.push_back(_T('/'));
-                }
-                break;
-                case _T('b'):
-                {
-                    val.push_back(_T('\b'));
-                }
-                break;
-                case _T('n'):
-                {
-                    val.push_back(_T('\n'));
-                }
-                break;
-                case _T('r'):
-                {
-                    val.push_back(_T('\r'));
-                }
-                break;
-                case _T('t'):
-                {
-                    val.push_back(_T('\t'));
-                }
-                break;
-                case _T('u'):
-                {
-                    data_ptr++;
-                    if (!_parse_unicode(data_ptr, val, &data_ptr))
-                    {
-                        flag_abort = true;
-                        break;
-                    }
-                    continue;
-                }
-                break;
-                default:
-                    data_ptr--;
-                    flag_abort = true;
-                    break;
-                }
-            }
-            else
-            {
-                val.push_back(ch);
-            }
+    json_value& json_value::operator = (json_type type)
+    {
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
 
-            if (flag_abort)
-            {
-                break;
-            }
+        _reset_type(type);
+        return *this;
+    }
 
-            data_ptr++;
+    json_value& json_value::operator = (json_bool val)
+    {
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
         }
 
-        if (_T('\"') != *data_ptr || flag_abort)
+        _reset_type(json_type::json_type_bool);
+        m_long.data._bool = val;
+        return *this;
+    }
+
+    json_value& json_value::operator = (int32_t val)
+    {
+        if (this == &_get_none_value())
         {
-            *end_ptr = data_ptr;
-            return false;
+            return _get_none_value();
         }
 
-        data_ptr++;
+        _reset_type(json_type::json_type_int);
+        m_long.data._int = val;
+        return *this;
+    }
 
-        if (end_ptr)
+    json_value& json_value::operator = (uint32_t val)
+    {
+        if (this == &_get_none_value())
         {
-            *end_ptr = data_ptr;
+            return _get_none_value();
         }
 
-        return true;
+        _reset_type(json_type::json_type_int);
+        m_long.data._uint = val;
+        return *this;
     }
 
-    void json_value::_dump_int(_tstring& append_str, int64_t val) const
+    json_value& json_value::operator = (int64_t val)
     {
-        _tchar out_buffer[64] = { 0 };
-        size_t length = _json_stprintf_s(out_buffer, 64, _T(FC_JSON_INT64_FORMAT), val);
-        append_str.append(out_buffer, length);
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
+
+        _reset_type(json_type::json_type_int);
+        m_long.data._int = val;
+        return *this;
     }
 
-    void json_value::_dump_uint(_tstring& append_str, uint64_t val) const
+    json_value& json_value::operator = (uint64_t val)
     {
-        _tchar out_buffer[64] = { 0 };
-        size_t length = _json_stprintf_s(out_buffer, 64, _T(FC_JSON_UINT64_FORMAT), val);
-        append_str.append(out_buffer, length);
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
+
+        _reset_type(json_type::json_type_uint);
+        m_long.data._uint = val;
+        return *this;
     }
 
-    void json_value::_dump_float(_tstring& append_str, double val) const
+    json_value& json_value::operator = (json_float val)
     {
-        _tchar out_buffer[64] = { 0 };
-        size_t length = _json_stprintf_s(out_buffer, 64, _T(FC_JSON_FLOAT_FORMAT), val);
-        append_str.append(out_buffer, length);
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
 
-        _tchar* ch_ptr = out_buffer;
-        bool flag_dot = false;
-        bool flag_exponent = false;
+        _reset_type(json_type::json_type_float);
+        m_long.data._float = val;
+        return *this;
+    }
 
-        while (_T('\0') != *ch_ptr)
+    json_value& json_value::operator = (const _tchar* val)
+    {
+        if (this == &_get_none_value())
         {
-            _tchar ch = *ch_ptr;
-            if (_T('.') == ch)
-            {
-                flag_dot = true;
-            }
-            else if (_T('e') == ch)
-            {
-                flag_exponent = true;
-            }
-            ch_ptr++;
+            return _get_none_value();
         }
 
-        if (!flag_dot && !flag_exponent)
+        _reset_string(val ? val : _T(""), val ? std::char_traits<_tchar>::length(val) : 0);
+        return *this;
+    }
+
+    json_value& json_value::operator = (const json_string& r)
+    {
+        if (this == &_get_none_value())
         {
-            append_str += _T(".0");
+            return _get_none_value();
         }
+
+        _reset_string(r.data(), r.size());
+        return *this;
     }
 
-    void json_value::_dump_string(_tstring& append_str, const _tstring& text, bool flag_escape) const
+    json_value& json_value::operator = (const json_object& r)
     {
-        const _tchar* data_ptr = text.c_str();
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
 
-        while (_T('\0') != *data_ptr)
+        _reset_type(json_type::json_type_object);
+        if (nullptr != m_long.data._object_ptr)
         {
-            _utchar ch = *data_ptr;
+            *m_long.data._object_ptr = r;
+        }
+        return *this;
+    }
 
-            switch (ch)
+    json_value& json_value::operator = (const json_array& r)
+    {
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
+
+        _reset_type(json_type::json_type_array);
+        if (nullptr != m_long.data._array_ptr)
+        {
+            *m_long.data._array_ptr = r;
+        }
+        return *this;
+    }
+
+    json_value& json_value::operator = (const json_bin& r)
+    {
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
+
+        _reset_type(json_type::json_type_bin);
+        if (nullptr != m_long.data._array_ptr)
+        {
+            *m_long.data._raw_ptr = r;
+        }
+        return *this;
+    }
+
+    json_value& json_value::operator = (const json_value& r)
+    {
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
+
+        if (&r != this)
+        {
+            clear();
+            m_long.type = r.m_long.type;
+
+            switch (m_long.type)
             {
-            case _T('\b'):
+            case json_type::json_type_string:
             {
-                append_str += _T(R"(\b)");
+                if (r.m_long.flags & json_flag_short)
+                {
+                    m_long.flags = json_flag_short;
+                    memcpy(m_short.text, r.m_short.text, sizeof(m_short.text));
+                }
+                else
+                {
+                    m_long.data._string_ptr = new (std::nothrow) json_string(*r.m_long.data._string_ptr);
+                }
             }
             break;
-            case _T('\t'):
+            case json_type::json_type_object:
             {
-                append_str += _T(R"(\t)");
+                m_long.data._object_ptr = r.m_long.data._object_ptr ? new (std::nothrow) json_object(*r.m_long.data._object_ptr) : nullptr;
             }
             break;
-            case _T('\n'):
-            {
-                append_str += _T(R"(\n)");
-            }
-            break;
-            case _T('\f'):
-            {
-                append_str += _T(R"(\f)");
-            }
-            break;
-            case _T('\r'):
-            {
-                append_str += _T(R"(\r)");
-            }
-            break;
-            case _T('\"'):
-            {
-                append_str += _T(R"(\")");
-            }
-            break;
-            case _T('/'):
+            case json_type::json_type_array:
             {
-                append_str += _T(R"(/)");
+                m_long.data._array_ptr = r.m_long.data._array_ptr ? new (std::nothrow) json_array(*r.m_long.data._array_ptr) : nullptr;
             }
             break;
-            case _T('\\'):
+            case json_type::json_type_bin:
             {
-                append_str += _T(R"(\\)");
+                m_long.data._raw_ptr = new (std::nothrow) json_bin(*r.m_long.data._raw_ptr);
             }
             break;
             default:
             {
-                if (ch < 0x80 || !flag_escape)
-                {
-                    append_str.push_back(ch);
-                }
-                else
-                {
-                    _get_unicode_string(append_str, data_ptr, &data_ptr);
-                    continue;
-                }
+                m_long.data = r.m_long.data;
             }
             break;
             }
-
-            data_ptr++;
         }
+
+        return *this;
     }
 
-    void json_value::_dump_object(_tstring& append_str, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const
+    json_value& json_value::operator = (json_string&& r)
     {
-        const json_object& object = *m_data._object_ptr;
-        size_t size = object.size();
-
-        append_str += _T("{");
-        if (indent > 0)
+        if (this == &_get_none_value())
         {
-            depth++;
-
-            if (indent_text.size() <= depth)
-            {
-                indent_text.emplace_back(_tstring(depth * indent, _T(' ')));
-            }
+            return _get_none_value();
+        }
 
-            append_str += _T(FC_JSON_RETURN);
+        _reset_string(std::move(r));
+        return *this;
+    }
 
-            for (const auto& item : object)
-            {
-                append_str += indent_text[depth];
-                append_str += _T("\"");
-                _dump_string(append_str, item.first, flag_escape);
-                append_str += _T("\": ");
-                item.second._dump(append_str, indent_text, depth, indent, flag_escape);
-                size--;
+    json_value& json_value::operator = (json_object&& r)
+    {
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
 
-                if (0 != size)
-                {
-                    append_str += _T(",");
-                }
+        _reset_type(json_type::json_type_object);
+        if (nullptr != m_long.data._object_ptr)
+        {
+            *m_long.data._object_ptr = std::move(r);
+        }
+        return *this;
+    }
 
-                append_str += _T(FC_JSON_RETURN);
-            }
+    json_value& json_value::operator = (json_array&& r)
+    {
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
 
-            depth--;
-            append_str += indent_text[depth];
+        _reset_type(json_type::json_type_array);
+        if (nullptr != m_long.data._array_ptr)
+        {
+            *m_long.data._array_ptr = std::move(r);
         }
-        else
+        return *this;
+    }
+
+    json_value& json_value::operator = (json_bin&& r)
+    {
+        if (this == &_get_none_value())
         {
-            for (const auto& item : object)
-            {
-                append_str += _T("\"");
-                _dump_string(append_str, item.first, flag_escape);
-                append_str += _T("\":");
-                item.second._dump(append_str, indent_text, depth, indent, flag_escape);
-                size--;
+            return _get_none_value();
+        }
 
-                if (0 != size)
-                {
-                    append_str += _T(",");
-                }
-            }
+        _reset_type(json_type::json_type_bin);
+        if (nullptr != m_long.data._raw_ptr)
+        {
+            *m_long.data._raw_ptr = std::move(r);
         }
-        append_str += _T("}");
+        return *this;
     }
 
-    void json_value::_dump_array(_tstring& append_str, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const
+    json_value& json_value::operator = (json_value&& r) noexcept
     {
-        const json_array& array = *m_data._array_ptr;
-        size_t size = array.size();
+        if (this == &_get_none_value())
+        {
+            return _get_none_value();
+        }
 
-        append_str += _T("[");
-        if (indent > 0)
+        if (&r != this)
         {
-            depth++;
+            clear();
+            m_long.type = r.m_long.type;
+            m_long.flags = r.m_long.flags;
 
-            if (indent_text.size() <= depth)
+            if (m_long.flags & json_flag_short)
             {
-                indent_text.emplace_back(_tstring(depth * indent, _T(' ')));
+                memcpy(m_short.text, r.m_short.text, sizeof(m_short.text));
             }
-
-            append_str += _T(FC_JSON_RETURN);
-
-            for (const auto& item : array)
+            else
             {
-                append_str += indent_text[depth];
-                item._dump(append_str, indent_text, depth, indent, flag_escape);
-                size--;
-                if (0 != size)
-                {
-                    append_str += _T(",");
-                }
-
-                append_str += _T(FC_JSON_RETURN);
+                m_long.data = r.m_long.data;
             }
 
-            depth--;
-            append_str += indent_text[depth];
-        }
-        else
-        {
-            for (const auto& item : array)
-            {
-                item._dump(append_str, indent_text, depth, indent, flag_escape);
-                size--;
-                if (0 != size)
-                {
-                    append_str += _T(",");
-                }
-            }
+            r.m_long.data = { 0 };
+            r.m_long.type = json_type::json_type_null;
+            r.m_long.flags = 0;
         }
-        append_str += _T("]");
+
+        return *this;
     }
 
-    void json_value::_dump(_tstring& append_str, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const
+    json_value& json_value::operator[](const _tstring& val_name) noexcept
     {
-        if (indent < 0)
+        if (this == &_get_none_value())
         {
-            indent = 0;
+            return _get_none_value();
         }
 
-        switch (m_type)
-        {
-        case json_type::json_type_null:
-        {
-            append_str += _T("null");
-        }
-        break;
-        case json_type::json_type_bool:
+        if (!is_object())
         {
-            append_str += m_data._bool ? _T("true") : _T("false");
+            return _get_none_value();
         }
-        break;
-        case json_type::json_type_int:
+
+        if (nullptr == m_long.data._object_ptr)
         {
-            _dump_int(append_str, m_data._int);
+            m_long.data._object_ptr = new (std::nothrow) json_object;
+            if (nullptr == m_long.data._object_ptr)
+            {
+                return _get_none_value();
+            }
         }
-        break;
-        case json_type::json_type_uint:
+
+        auto it_find = m_long.data._object_ptr->find(_json_lookup_key(val_name));
+        if (m_long.data._object_ptr->end() != it_find)
         {
-            _dump_uint(append_str, m_data._uint);
+            return it_find->second;
         }
-        break;
-        case json_type::json_type_float:
+
+        auto it_insert = m_long.data._object_ptr->insert(std::make_pair(val_name, json_value()));
+        return it_insert.first->second;
+    }
+
+    json_value& json_value::operator[](size_t index) noexcept
+    {
+        if (this == &_get_none_value())
         {
-            _dump_float(append_str, m_data._float);
+            return _get_none_value();
         }
-        break;
-        case json_type::json_type_string:
+
+        if (!is_array())
         {
-            append_str += _T("\"");
-            _dump_string(append_str, *m_data._string_ptr, flag_escape);
-            append_str += _T("\"");
+            return _get_none_value();
         }
-        break;
-        case json_type::json_type_object:
-        {
-            if (nullptr == m_data._array_ptr)
-            {
-                append_str += _T("{}");
-                break;
-            }
-
-            if (m_data._array_ptr->empty())
-            {
-                append_str += _T("{}");
-                break;
-            }
 
-            _dump_object(append_str, indent_text, depth, indent, flag_escape);
-        }
-        break;
-        case json_type::json_type_array:
+        if (nullptr == m_long.data._array_ptr)
         {
-            if (nullptr == m_data._array_ptr)
-            {
-                append_str += _T("[]");
-                break;
-            }
-
-            if (m_data._array_ptr->empty())
+            m_long.data._array_ptr = new (std::nothrow) json_array;
+            if (nullptr == m_long.data._array_ptr)
             {
-                append_str += _T("[]");
-                break;
+                return _get_none_value();
             }
-
-            _dump_array(append_str, indent_text, depth, indent, flag_escape);
         }
-        break;
-        default:
+
+        if (m_long.data._array_ptr->size() <= index)
         {
+            m_long.data._array_ptr->resize(index + 1);
         }
-        break;
-        }
+
+        return (*m_long.data._array_ptr)[index];
     }
 
-    void json_value::_dump_raw_int(std::vector<uint8_t>& append_buf, int64_t val) const
+    json_value::~json_value()
     {
-        union _data_info
-        {
-            int64_t data;
-            uint8_t bytes[sizeof(int64_t)];
-        }data_info;
+        clear();
+    }
 
-        data_info.data = val;
-        int data_size = sizeof(int64_t);
+    json_type json_value::type() const
+    {
+        return m_long.type;
+    }
 
-        if (val <= INT8_MAX && val >= INT8_MIN)
+    _tstring json_value::type_name() const
+    {
+        if (json_type::json_type_null == m_long.type) return _T("Null");
+        if (json_type::json_type_bool == m_long.type) return _T("Bool");
+        if (json_type::json_type_int == m_long.type) return _T("Integer");
+        if (json_type::json_type_uint == m_long.type) return _T("Unsigned Integer");
+        if (json_type::json_type_float == m_long.type) return _T("Float");
+        if (json_type::json_type_string == m_long.type) return _T("String");
+        if (json_type::json_type_object == m_long.type) return _T("Object");
+        if (json_type::json_type_array == m_long.type) return _T("Array");
+        return _T("None");
+    }
+
+    bool json_value::remove(const _tstring& name)
+    {
+        if (!is_object())
         {
-            append_buf.push_back(json_raw_type::raw_int8);
-            data_size = sizeof(uint8_t);
+            return false;
         }
-        else if (val <= INT16_MAX && val >= INT16_MIN)
+
+        if (nullptr == m_long.data._object_ptr)
         {
-            append_buf.push_back(json_raw_type::raw_int16);
-            data_size = sizeof(uint16_t);
+            return false;
         }
-        else if (val <= INT32_MAX && val >= INT32_MIN)
+
+        json_object& object = *m_long.data._object_ptr;
+        auto it_find = object.find(_json_lookup_key(name));
+        if (object.end() == it_find)
         {
-            append_buf.push_back(json_raw_type::raw_int32);
-            data_size = sizeof(uint32_t);
+            return false;
         }
-        else
+
+        object.erase(it_find);
+
+        return true;
+    }
+
+    bool json_value::remove(const size_t index)
+    {
+        if (!is_array())
         {
-            append_buf.push_back(json_raw_type::raw_int64);
-            data_size = sizeof(uint64_t);
+            return false;
         }
 
-        for (int i = 0; i < data_size; i++)
+        if (nullptr == m_long.data._array_ptr)
         {
-            append_buf.push_back(data_info.bytes[i]);
+            return false;
         }
+
+        json_array& array = *m_long.data._array_ptr;
+        if (index >= array.size())
+        {
+            return false;
+        }
+
+        array.erase(array.begin() + index);
+
+        return true;
     }
 
-    void json_value::_dump_raw_uint(std::vector<uint8_t>& append_buf, uint64_t val) const
+    bool json_value::is_null() const
     {
-        union _data_info
-        {
-            uint64_t data;
-            uint8_t bytes[sizeof(uint64_t)];
-        }data_info;
+        return json_type::json_type_null == m_long.type;
+    }
 
-        data_info.data = val;
-        int data_size = sizeof(uint64_t);
+    bool json_value::is_bool() const
+    {
+        return json_type::json_type_bool == m_long.type;
+    }
 
-        if (val <= UINT8_MAX)
-        {
-            append_buf.push_back(json_raw_type::raw_uint8);
-            data_size = sizeof(uint8_t);
-        }
-        else if (val <= UINT16_MAX)
+    bool json_value::is_int() const
+    {
+        return json_type::json_type_int == m_long.type || json_type::json_type_uint == m_long.type;
+    }
+
+    bool json_value::is_float() const
+    {
+        return json_type::json_type_float == m_long.type;
+    }
+
+    bool json_value::is_number() const
+    {
+        return json_type::json_type_int == m_long.type || json_type::json_type_uint == m_long.type || json_type::json_type_float == m_long.type;
+    }
+
+    bool json_value::is_string() const
+    {
+        return json_type::json_type_string == m_long.type;
+    }
+
+    bool json_value::is_object() const
+    {
+        return json_type::json_type_object == m_long.type;
+    }
+
+    bool json_value::is_array() const
+    {
+        return json_type::json_type_array == m_long.type;
+    }
+
+    bool json_value::is_bin() const
+    {
+        return json_type::json_type_bin == m_long.type;
+    }
+
+    json_bool json_value::as_bool() const
+    {
+        if (json_type::json_type_bool != m_long.type)
         {
-            append_buf.push_back(json_raw_type::raw_uint16);
-            data_size = sizeof(uint16_t);
+            throw json_exception(__JSON_FUNCTION__);
         }
-        else if (val <= UINT32_MAX)
+
+        return m_long.data._bool;
+    }
+
+    json_bool json_value::as_bool(json_bool default_val) const
+    {
+        if (json_type::json_type_bool != m_long.type)
         {
-            append_buf.push_back(json_raw_type::raw_uint32);
-            data_size = sizeof(uint32_t);
+            return default_val;
         }
-        else
+
+        return m_long.data._bool;
+    }
+
+    json_int json_value::as_int() const
+    {
+        if (!(json_type::json_type_int == m_long.type || json_type::json_type_uint == m_long.type))
         {
-            append_buf.push_back(json_raw_type::raw_uint64);
-            data_size = sizeof(uint64_t);
+            throw json_exception(__JSON_FUNCTION__);
         }
 
-        for (int i = 0; i < data_size; i++)
+        return m_long.data._int;
+    }
+
+    json_int json_value::as_int(json_int default_val) const
+    {
+        if (!(json_type::json_type_int == m_long.type || json_type::json_type_uint == m_long.type))
         {
-            append_buf.push_back(data_info.bytes[i]);
+            return default_val;
         }
+
+        return m_long.data._int;
     }
 
-    void json_value::_dump_raw_float(std::vector<uint8_t>& append_buf, double val) const
+    json_uint json_value::as_uint() const
     {
-        union _data_info
+        if (!(json_type::json_type_int == m_long.type || json_type::json_type_uint == m_long.type))
         {
-            double data;
-            uint8_t bytes[sizeof(double)];
-        }data_info;
+            throw json_exception(__JSON_FUNCTION__);
+        }
 
-        data_info.data = val;
+        return m_long.data._uint;
+    }
 
-        for (int i = 0; i < sizeof(double); i++)
+    json_uint json_value::as_uint(json_uint default_val) const
+    {
+        if (!(json_type::json_type_int == m_long.type || json_type::json_type_uint == m_long.type))
         {
-            append_buf.push_back(data_info.bytes[i]);
+            return default_val;
         }
+
+        return m_long.data._uint;
     }
 
-    void json_value::_dump_raw_string(std::vector<uint8_t>& append_buf, const std::string& text) const
+    json_float json_value::as_float() const
     {
-        if (text.empty())
+        if (json_type::json_type_float != m_long.type)
         {
-            append_buf.push_back(json_raw_type::raw_string_empty);
+            throw json_exception(__JSON_FUNCTION__);
         }
-        else
-        {
-            int data_size = 0;
-            union _data_info
-            {
-                uint32_t data;
-                uint8_t bytes[sizeof(uint32_t)];
-            }data_info;
-
-            data_info.data = text.size();
-            if (data_info.data <= UINT8_MAX)
-            {
-                append_buf.push_back(json_raw_type::raw_string8);
-                data_size = sizeof(uint8_t);
-            }
-            else if (data_info.data <= UINT16_MAX)
-            {
-                append_buf.push_back(json_raw_type::raw_string16);
-                data_size = sizeof(uint16_t);
-            }
-            else
-            {
-                append_buf.push_back(json_raw_type::raw_string32);
-                data_size = sizeof(uint32_t);
-            }
 
-            for (int i = 0; i < data_size; i++)
-            {
-                append_buf.push_back(data_info.bytes[i]);
-            }
+        return m_long.data._float;
+    }
 
-            append_buf.insert(append_buf.end(), text.begin(), text.end());
+    json_float json_value::as_float(json_float default_val) const
+    {
+        if (json_type::json_type_float != m_long.type)
+        {
+            return default_val;
         }
+
+        return m_long.data._float;
     }
 
-    void json_value::_dump_raw_object(std::vector<uint8_t>& append_buf, const json_object& object) const
+    json_float json_value::as_number() const
     {
-        for (const auto& item : object)
+        if (!is_number())
         {
-#ifdef _UNICODE
-            _dump_raw_string(append_buf, _utf16_to_utf8(item.first));
-#else
-            _dump_raw_string(append_buf, item.first);
-#endif
-            item.second._dump_raw(append_buf);
+            throw json_exception(__JSON_FUNCTION__);
         }
+
+        return m_long.data._float;
     }
 
-    void json_value::_dump_raw_array(std::vector<uint8_t>& append_buf, const json_array& arrry) const
+    json_float json_value::as_number(json_float default_val) const
     {
-        for (const auto& item : arrry)
+        if (!is_number())
         {
-            item._dump_raw(append_buf);
+            return default_val;
         }
+
+        return m_long.data._float;
     }
 
-    void json_value::_dump_raw_bin(std::vector<uint8_t>& append_buf, const json_bin& raw) const
+    json_string& json_value::as_string()
     {
-        if (raw.empty())
+        if (json_type::json_type_string != m_long.type)
         {
-            append_buf.push_back(json_raw_type::raw_bin_empty);
+            throw json_exception(__JSON_FUNCTION__);
         }
-        else
-        {
-            int data_size = 0;
-            union _data_info
-            {
-                uint32_t data;
-                uint8_t bytes[sizeof(uint32_t)];
-            }data_info;
 
-            data_info.data = raw.size();
-            if (data_info.data <= UINT8_MAX)
-            {
-                append_buf.push_back(json_raw_type::raw_bin8);
-                data_size = sizeof(uint8_t);
-            }
-            else if (data_info.data <= UINT16_MAX)
-            {
-                append_buf.push_back(json_raw_type::raw_bin16);
-                data_size = sizeof(uint16_t);
-            }
-            else
-            {
-                append_buf.push_back(json_raw_type::raw_bin32);
-                data_size = sizeof(uint32_t);
-            }
+        if ((m_long.flags & json_flag_short) && !_promote_string())
+        {
+            throw json_exception(__JSON_FUNCTION__);
+        }
 
-            for (int i = 0; i < data_size; i++)
-            {
-                append_buf.push_back(data_info.bytes[i]);
-            }
+        return *m_long.data._string_ptr;
+    }
 
-            append_buf.insert(append_buf.end(), raw.begin(), raw.end());
+    json_string json_value::as_string() const
+    {
+        if (json_type::json_type_string != m_long.type)
+        {
+            throw json_exception(__JSON_FUNCTION__);
         }
+
+        return json_string(string_data(), string_size());
     }
 
-    void json_value::_dump_raw(std::vector<uint8_t>& append_buf) const
+    json_string json_value::as_string(json_string default_val) const
     {
-        switch (m_type)
-        {
-        case json_type::json_type_null:
+        if (json_type::json_type_string != m_long.type)
         {
-            append_buf.push_back(json_raw_type::raw_null);
+            return default_val;
         }
-        break;
-        case json_type::json_type_bool:
+
+        if (m_long.flags & json_flag_short)
         {
-            if (m_data._bool)
-            {
-                append_buf.push_back(json_raw_type::raw_true);
-            }
-            else
-            {
-                append_buf.push_back(json_raw_type::raw_false);
-            }
+            return m_short.text;
         }
-        break;
-        case json_type::json_type_int:
+
+        return *m_long.data._string_ptr;
+    }
+
+    json_object& json_value::as_object()
+    {
+        if (json_type::json_type_object != m_long.type)
         {
-            _dump_raw_int(append_buf, m_data._int);
+            throw json_exception(__JSON_FUNCTION__);
         }
-        break;
-        case json_type::json_type_uint:
+
+        if (nullptr == m_long.data._object_ptr && !_promote_container())
         {
-            _dump_raw_uint(append_buf, m_data._uint);
+            throw json_exception(__JSON_FUNCTION__);
         }
-        break;
-        case json_type::json_type_float:
+
+        return *m_long.data._object_ptr;
+    }
+
+    const json_object& json_value::as_object() const
+    {
+        static const json_object empty_object;
+
+        if (json_type::json_type_object != m_long.type)
         {
-            append_buf.push_back(json_raw_type::raw_float);
-            _dump_raw_float(append_buf, m_data._float);
+            throw json_exception(__JSON_FUNCTION__);
         }
-        break;
-        case json_type::json_type_string:
+
+        if (nullptr == m_long.data._object_ptr)
         {
-#ifdef _UNICODE
-            _dump_raw_string(append_buf, _utf16_to_utf8(*m_data._string_ptr));
-#else
-            _dump_raw_string(append_buf, *m_data._string_ptr);
-#endif
+            return empty_object;
         }
-        break;
-        case json_type::json_type_object:
+
+        return *m_long.data._object_ptr;
+    }
+
+    json_object json_value::as_object(json_object default_val) const
+    {
+        if (json_type::json_type_object != m_long.type)
         {
-            if (m_data._object_ptr && !m_data._object_ptr->empty())
-            {
-                append_buf.push_back(json_raw_type::raw_object_beg);
-                _dump_raw_object(append_buf, *m_data._object_ptr);
-                append_buf.push_back(json_raw_type::raw_object_end);
-            }
-            else
-            {
-                append_buf.push_back(json_raw_type::raw_object_empty);
-            }
+            return default_val;
         }
-        break;
-        case json_type::json_type_array:
+
+        if (nullptr == m_long.data._object_ptr)
         {
-            if (m_data._array_ptr && !m_data._array_ptr->empty())
-            {
-                append_buf.push_back(json_raw_type::raw_array_beg);
-                _dump_raw_array(append_buf, *m_data._array_ptr);
-                append_buf.push_back(json_raw_type::raw_array_end);
-            }
-            else
-            {
-                append_buf.push_back(json_raw_type::raw_array_empty);
-            }
+            return json_object();
         }
-        break;
-        case json_type::json_type_bin:
+
+        return *m_long.data._object_ptr;
+    }
+
+    json_array& json_value::as_array()
+    {
+        if (json_type::json_type_array != m_long.type)
         {
-            if (m_data._raw_ptr && !m_data._raw_ptr->empty())
-            {
-                _dump_raw_bin(append_buf, *m_data._raw_ptr);
-            }
-            else
-            {
-                append_buf.push_back(json_raw_type::raw_bin_empty);
-            }
+            throw json_exception(__JSON_FUNCTION__);
         }
-        break;
+
+        if (nullptr == m_long.data._array_ptr && !_promote_container())
+        {
+            throw json_exception(__JSON_FUNCTION__);
         }
+
+        return *m_long.data._array_ptr;
     }
 
-    bool json_value::_parse_raw_string(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val)
+    const json_array& json_value::as_array() const
     {
-        json_raw_type type = (json_raw_type)*data_ptr;
-        const uint8_t* date_value_ptr = data_ptr + sizeof(json_raw_type);
-        const uint8_t* data_next_ptr = data_ptr;
-        std::string str_value;
+        static const json_array empty_array;
 
-        switch (*data_ptr)
+        if (json_type::json_type_array != m_long.type)
         {
-        case json_raw_type::raw_string_empty:
-            data_next_ptr += sizeof(json_raw_type);
-            break;
-        case json_raw_type::raw_string8:
-            str_value = std::string((const char*)(date_value_ptr + sizeof(uint8_t)), *(uint8_t*)date_value_ptr);
-            data_next_ptr = date_value_ptr + sizeof(uint8_t) + *(uint8_t*)date_value_ptr;
-            break;
-        case json_raw_type::raw_string16:
-            str_value = std::string((const char*)(date_value_ptr + sizeof(uint16_t)), *(uint16_t*)date_value_ptr);
-            data_next_ptr = date_value_ptr + sizeof(uint16_t) + *(uint16_t*)date_value_ptr;
-            break;
-        case json_raw_type::raw_string32:
-            str_value = std::string((const char*)(date_value_ptr + sizeof(uint32_t)), *(uint32_t*)date_value_ptr);
-            data_next_ptr = date_value_ptr + sizeof(uint32_t) + *(uint32_t*)date_value_ptr;
-            break;
+            throw json_exception(__JSON_FUNCTION__);
         }
 
-#ifdef _UNICODE
-        val = _utf8_to_utf16(str_value);
-#else
-        val = str_value;
-#endif
+        if (nullptr == m_long.data._array_ptr)
+        {
+            return empty_array;
+        }
 
-        if (end_ptr)
+        return *m_long.data._array_ptr;
+    }
+
+    json_array json_value::as_array(json_array default_val) const
+    {
+        if (json_type::json_type_array != m_long.type)
         {
-            *end_ptr = data_next_ptr;
+            return default_val;
         }
 
-        return true;
+        if (nullptr == m_long.data._array_ptr)
+        {
+            return json_array();
+        }
+
+        return *m_long.data._array_ptr;
     }
 
-    bool json_value::_parse_raw_object(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val)
+    const _tchar* json_value::string_data() const
     {
-        val._reset_type(json_type::json_type_object);
+        if (json_type::json_type_string != m_long.type)
+        {
+            return nullptr;
+        }
 
-        const uint8_t* data_next_ptr = data_ptr;
-        while (true)
+        if (m_long.flags & json_flag_short)
         {
-            std::string key_name;
-            json_value key_value;
+            return m_short.text;
+        }
 
-            if (json_raw_type::raw_object_end == *data_next_ptr)
+        return m_long.data._string_ptr ? m_long.data._string_ptr->c_str() : nullptr;
+    }
+
+    size_t json_value::string_size() const
+    {
+        if (json_type::json_type_string != m_long.type)
+        {
+            return 0;
+        }
+
+        if (m_long.flags & json_flag_short)
+        {
+            return std::char_traits<_tchar>::length(m_short.text);
+        }
+
+        return m_long.data._string_ptr ? m_long.data._string_ptr->size() : 0;
+    }
+
+    json_bin& json_value::as_bin() const
+    {
+        if (json_type::json_type_bin != m_long.type)
+        {
+            throw json_exception(__JSON_FUNCTION__);
+        }
+
+        return *m_long.data._raw_ptr;
+    }
+
+    json_bin json_value::as_bin(json_bin default_val) const
+    {
+        if (json_type::json_type_bin != m_long.type)
+        {
+            return default_val;
+        }
+
+        return *m_long.data._raw_ptr;
+    }
+
+    bool json_value::has_value(const _tstring& name) const
+    {
+        if (this == &_get_none_value())
+        {
+            return false;
+        }
+
+        if (is_object() && m_long.data._object_ptr)
+        {
+            auto it_find = m_long.data._object_ptr->find(_json_lookup_key(name));
+            if (m_long.data._object_ptr->end() != it_find)
             {
-                data_next_ptr++;
-                break;
+                return true;
             }
+        }
 
-            const uint8_t* value_ptr = data_next_ptr + sizeof(json_raw_type);
-            size_t value_size = 0;
-            switch (*data_next_ptr)
+        return false;
+    }
+
+    json_memory_stats json_value::memory_stats() const
+    {
+        json_memory_stats stats = {};
+        _memory_stats(stats);
+        return stats;
+    }
+
+    void json_value::_memory_stats(json_memory_stats& stats) const
+    {
+        stats.node_count++;
+        stats.node_bytes += sizeof(json_value);
+
+        switch (m_long.type)
+        {
+        case json_type::json_type_string:
+        {
+            if (m_long.flags & json_flag_short)
+            {
+                stats.short_string_count++;
+            }
+            else if (m_long.data._string_ptr)
+            {
+                stats.string_bytes += sizeof(json_string) + _json_string_heap_bytes(*m_long.data._string_ptr);
+            }
+        }
+        break;
+        case json_type::json_type_object:
+        {
+            if (nullptr == m_long.data._object_ptr)
             {
-            case json_raw_type::raw_string8:
-                value_size = *(uint8_t*)value_ptr;
-                key_name = std::string((const char*)(value_ptr + sizeof(uint8_t)), value_size);
-                data_next_ptr = (value_ptr + sizeof(uint8_t)) + value_size;
-                break;
-            case json_raw_type::raw_string16:
-                value_size = *(uint16_t*)value_ptr;
-                key_name = std::string((const char*)(value_ptr + sizeof(uint16_t)), value_size);
-                data_next_ptr = (value_ptr + sizeof(uint16_t)) + value_size;
-                break;
-            case json_raw_type::raw_string32:
-                value_size = *(uint32_t*)value_ptr;
-                key_name = std::string((const char*)(value_ptr + sizeof(uint32_t)), value_size);
-                data_next_ptr = (value_ptr + sizeof(uint32_t)) + value_size;
                 break;
-            default:
-                return false;
             }
 
-            if (key_name.empty())
+            // Member nodes are counted by node_bytes, the rest of each member by container_bytes
+            const json_object& object = *m_long.data._object_ptr;
+#if defined(FC_JSON_FLAT_OBJECT)
+            stats.container_bytes += sizeof(json_object) + object.capacity() * sizeof(json_object::value_type) - object.size() * sizeof(json_value);
+#elif defined(FC_JSON_HASH_OBJECT)
+            stats.container_bytes += sizeof(json_object) + object.capacity() * sizeof(json_object::value_type) - object.size() * sizeof(json_value);
+            stats.container_bytes += object.bucket_count() * sizeof(uint64_t);
+#else
+            // Red-black tree node: color and three links ahead of the member
+            stats.container_bytes += sizeof(json_object) + object.size() * (4 * sizeof(void*) + sizeof(json_object::value_type) - sizeof(json_value));
+#endif
+            for (const auto& item : object)
             {
-                return false;
+#ifndef FC_JSON_INTERN_KEYS
+                stats.string_bytes += _json_string_heap_bytes(item.first);
+#endif
+                item.second._memory_stats(stats);
+            }
+        }
+        break;
+        case json_type::json_type_array:
+        {
+            if (nullptr == m_long.data._array_ptr)
+            {
+                break;
             }
 
-            if (!_parse_raw(data_next_ptr, &data_next_ptr, key_value))
+            const json_array& array = *m_long.data._array_ptr;
+            stats.container_bytes += sizeof(json_array) + (array.capacity() - array.size()) * sizeof(json_value);
+            for (const auto& item : array)
             {
-                return false;
+                item._memory_stats(stats);
+            }
+        }
+        break;
+        case json_type::json_type_bin:
+        {
+            if (m_long.data._raw_ptr)
+            {
+                stats.container_bytes += sizeof(json_bin) + m_long.data._raw_ptr->capacity();
             }
+        }
+        break;
+        default:
+            break;
+        }
+    }
 
-#ifdef _UNICODE
-            val[_utf8_to_utf16(key_name)] = key_value;
-#else
-            val[key_name] = key_value;
-#endif
+    size_t json_value::count() const
+    {
+        if (this == &_get_none_value())
+        {
+            return 0;
         }
 
-        if (end_ptr)
+        if (is_array() && m_long.data._array_ptr)
         {
-            *end_ptr = data_next_ptr;
+            return m_long.data._array_ptr->size();
         }
 
-        return true;
+        if (is_object() && m_long.data._object_ptr)
+        {
+            return m_long.data._object_ptr->size();
+        }
+
+        return 0;
     }
 
-    bool json_value::_parse_raw_array(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val)
+    bool json_value::parse(const _tstring& text, json_parse_flag flags/* = json_parse_flag::json_parse_default*/)
     {
-        const uint8_t* data_next_ptr = data_ptr;
-        val._reset_type(json_type::json_type_array);
+        return parse(text.data(), text.size(), flags);
+    }
 
-        while (true)
+    bool json_value::parse(const _tchar* data, size_t size, json_parse_flag flags/* = json_parse_flag::json_parse_default*/)
+    {
+        clear();
+
+        if (nullptr == data)
         {
-            if (json_raw_type::raw_array_end == *data_next_ptr)
-            {
-                data_next_ptr++;
-                break;
-            }
+            return false;
+        }
 
-            json_value value;
-            if (!_parse_raw(data_next_ptr, &data_next_ptr, value))
+        if (flags & json_parse_flag::json_parse_parallel)
+        {
+            size_t thread_count = FC_JSON_PARSE_THREADS ? FC_JSON_PARSE_THREADS : std::thread::hardware_concurrency();
+            if (thread_count > 1 && size >= json_parallel_min_size)
             {
-                return false;
+                return _parse_parallel(data, size, *this, thread_count);
             }
-
-            val.m_data._array_ptr->emplace_back(std::move(value));
         }
 
-        if (end_ptr)
+        if (flags & json_parse_flag::json_parse_indexed)
         {
-            *end_ptr = data_next_ptr;
+            return _parse_indexed(data, size, *this);
         }
 
-        return true;
+        const _tchar* end_ptr = nullptr;
+        return _parse(data, data + size, *this, &end_ptr);
     }
 
-    bool json_value::_parse_raw_bin(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val)
+    bool json_value::parse(const _tstring& text, json_arena& arena, json_parse_flag flags/* = json_parse_flag::json_parse_default*/)
     {
-        json_raw_type type = (json_raw_type)*data_ptr;
-        const uint8_t* date_value_ptr = data_ptr + sizeof(json_raw_type);
-        const uint8_t* data_next_ptr = data_ptr;
+        return parse(text.data(), text.size(), arena, flags);
+    }
 
-        json_bin raw;
+    bool json_value::parse(const _tchar* data, size_t size, json_arena& arena, json_parse_flag flags/* = json_parse_flag::json_parse_default*/)
+    {
+        clear();
+
+        if (nullptr == data)
+        {
+            return false;
+        }
+
+        // json_arena is not thread safe, json_parse_parallel takes the serial parsers here
+        if (flags & json_parse_flag::json_parse_indexed)
+        {
+            return _parse_indexed(data, size, *this, &arena);
+        }
+
+        const _tchar* end_ptr = nullptr;
+        return _parse(data, data + size, *this, &end_ptr, &arena);
+    }
+
+    bool json_value::parse_from_file(const _tstring& file_path, json_parse_flag flags/* = json_parse_flag::json_parse_default*/)
+    {
+        json_file_view file_view;
+        _tstring read_text;
+
+        clear();
+
+        if (!file_view.open(file_path))
+        {
+            return false;
+        }
+
+        const uint8_t* data_ptr = file_view.data();
+        size_t data_size = file_view.size();
+
+        // Sniff the encoding from the BOM, text without a UTF-16 BOM is tried as UTF-8 first
+        bool flag_utf16_le = data_size >= 2 && 0xFF == data_ptr[0] && 0xFE == data_ptr[1];
+        bool flag_utf16_be = data_size >= 2 && 0xFE == data_ptr[0] && 0xFF == data_ptr[1];
+
+        do
+        {
+            if (!flag_utf16_le && !flag_utf16_be)
+            {
+#ifdef _UNICODE
+                // Validated while transcoding
+                if (_utf8_to_utf16(data_ptr, data_size, &read_text))
+                {
+                    break;
+                }
+#else
+                // Parse the mapped bytes in place
+                if (_is_utf8_text(data_ptr, data_size))
+                {
+                    return parse((const _tchar*)data_ptr, data_size, flags);
+                }
+#endif
+            }
+
+            if (0 != (data_size % 2))
+            {
+                break;
+            }
+
+#ifdef _UNICODE
+            // Native UTF-16 is parsed in place
+            if (flag_utf16_le && 2 == sizeof(wchar_t))
+            {
+                return parse((const _tchar*)data_ptr, data_size / 2, flags);
+            }
+
+            // Other byte orders and wchar_t sizes go through UTF-8
+            std::string text_utf8;
+            _utf16_to_utf8((const uint16_t*)data_ptr, data_size / 2, &text_utf8);
+            _utf8_to_utf16((const uint8_t*)text_utf8.data(), text_utf8.size(), &read_text);
+#else
+            _utf16_to_utf8((const uint16_t*)data_ptr, data_size / 2, &read_text);
+#endif
+
+        } while (false);
+
+        return parse(read_text.data(), read_text.size(), flags);
+    }
+
+    bool json_value::parse_from_binary(uint8_t* data, size_t size)
+    {
+        clear();
+        const uint8_t* data_end = data + size;
+        return _parse_raw(data, &data_end, *this);
+    }
+
+    bool json_value::parse_from_binary_file(const _tstring& file_path)
+    {
+        clear();
+
+        std::ifstream input_file(file_path, std::ios::binary | std::ios::in);
+        if (!input_file.is_open())
+        {
+            return false;
+        }
+
+        input_file.seekg(0, std::ios::end);
+        std::streamoff text_size = input_file.tellg();
+        input_file.seekg(0, std::ios::beg);
+
+        std::vector<uint8_t> text_buffer(text_size, 0);
+        input_file.read((char*)&text_buffer[0], text_size);
+        size_t byte_count = (size_t)input_file.gcount();
+        input_file.close();
+
+        const uint8_t* data_end = text_buffer.data() + text_buffer.size();
+        return _parse_raw(text_buffer.data(), &data_end, *this);
+    }
+
+    _tstring json_value::dump(int indent/* = 0*/, bool flag_escape/* = false*/) const
+    {
+        _tstring result_text;
+        std::vector<_tstring> indent_text({ _T("") });
+
+        // Small texts grow geometrically, a sizing pass costs more than the regrowth it saves
+        json_dump_length measure = [&]() { return _dump_size(0, indent, flag_escape); };
+        json_writer writer(result_text, measure);
+        _dump(writer, indent_text, 0, indent, flag_escape);
+        return result_text;
+    }
+
+    size_t json_value::dump_size(int indent/* = 0*/, bool flag_escape/* = false*/) const
+    {
+        return _dump_size(0, indent, flag_escape);
+    }
+
+    bool json_value::_dump_to_sink(const json_dump_sink& sink, int indent, bool flag_escape) const
+    {
+        std::vector<_tstring> indent_text({ _T("") });
+        json_writer writer(sink);
+        _dump(writer, indent_text, 0, indent, flag_escape);
+        return writer.flush();
+    }
+
+    bool json_value::_dump_to_stdio(FILE* file, int indent, bool flag_escape) const
+    {
+        if (nullptr == file)
+        {
+            return false;
+        }
+
+        return _dump_to_sink([file](const _tchar* data_ptr, size_t size) {
+            return fwrite(data_ptr, sizeof(_tchar), size, file) == size;
+            }, indent, flag_escape);
+    }
+
+    bool json_value::dump(std::basic_ostream<_tchar>& stream, int indent/* = 0*/, bool flag_escape/* = false*/) const
+    {
+        return _dump_to_sink([&stream](const _tchar* data_ptr, size_t size) {
+            stream.write(data_ptr, size);
+            return stream.good();
+            }, indent, flag_escape);
+    }
+
+    bool json_value::dump_to_fd(int fd, int indent/* = 0*/, bool flag_escape/* = false*/) const
+    {
+        return _dump_to_sink([fd](const _tchar* data_ptr, size_t size) {
+            const char* byte_ptr = (const char*)data_ptr;
+            size_t byte_count = size * sizeof(_tchar);
+
+            // Writes may be partial, pipes and sockets take what fits
+            while (byte_count > 0)
+            {
+#ifdef _WIN32
+                int written = _write(fd, byte_ptr, (unsigned int)std::min<size_t>(byte_count, INT_MAX));
+#else
+                ssize_t written = write(fd, byte_ptr, byte_count);
+                if (written < 0 && EINTR == errno)
+                {
+                    continue;
+                }
+#endif
+                if (written <= 0)
+                {
+                    return false;
+                }
+
+                byte_ptr += written;
+                byte_count -= written;
+            }
+
+            return true;
+            }, indent, flag_escape);
+    }
+
+    bool json_value::dump_to_file(const _tstring& strPath, int indent/* = 0*/, bool flag_escape/* = false*/, json_encoding encoding/* = json_encoding::json_encoding_auto*/)
+    {
+        std::ofstream output_file(strPath, std::ios::binary | std::ios::out);
+        if (!output_file.is_open())
+        {
+            return false;
+        }
+
+        // Streamed, converted piece by piece when the file encoding differs from _tchar
+#ifdef _UNICODE
+        bool flag_convert = json_encoding::json_encoding_utf8 == encoding;
+#else
+        bool flag_convert = json_encoding::json_encoding_utf16 == encoding;
+#endif
+
+        if (!flag_convert)
+        {
+#ifdef _UNICODE
+            uint16_t bom = 0xFEFF;
+            output_file.write((const char*)&bom, sizeof(bom));
+#endif
+            bool result_flag = _dump_to_sink([&output_file](const _tchar* data_ptr, size_t size) {
+                output_file.write((const char*)data_ptr, size * sizeof(_tchar));
+                return output_file.good();
+                }, indent, flag_escape);
+
+            output_file.close();
+            return result_flag && !output_file.fail();
+        }
+
+        // A sequence cut at the end of a piece is kept for the next one
+        _tstring pending_text;
+
+#ifdef _UNICODE
+        std::string text_utf8;
+        bool result_flag = _dump_to_sink([&](const _tchar* data_ptr, size_t size) {
+            pending_text.append(data_ptr, size);
+
+            size_t pos = 0;
+            for (; pos < pending_text.size(); pos++)
+            {
+                uint32_t cp32 = (uint16_t)pending_text[pos];
+                if (cp32 >= 0xD800 && cp32 <= 0xDFFF)
+                {
+                    // Only a high surrogate at the end of the piece may wait for its pair
+                    if (cp32 <= 0xDBFF && pos + 1 == pending_text.size())
+                    {
+                        break;
+                    }
+
+                    uint32_t low = pos + 1 < pending_text.size() ? (uint16_t)pending_text[pos + 1] : 0;
+                    if (cp32 > 0xDBFF || low < 0xDC00 || low > 0xDFFF)
+                    {
+                        return false;
+                    }
+
+                    cp32 = 0x10000 + ((cp32 - 0xD800) << 10) + (low - 0xDC00);
+                    pos++;
+                }
+
+                char out_buffer[4];
+                text_utf8.append(out_buffer, _put_utf8(out_buffer, cp32));
+            }
+
+            pending_text.erase(0, pos);
+            output_file.write(text_utf8.data(), text_utf8.size());
+            text_utf8.clear();
+            return output_file.good();
+            }, indent, flag_escape);
+#else
+        std::vector<uint16_t> text_utf16(1, 0xFEFF);
+        bool result_flag = _dump_to_sink([&](const _tchar* data_ptr, size_t size) {
+            pending_text.append(data_ptr, size);
+
+            const uint8_t* text_ptr = (const uint8_t*)pending_text.data();
+            const uint8_t* text_end = text_ptr + pending_text.size();
+            while (text_ptr < text_end)
+            {
+                uint32_t cp32 = 0;
+                size_t byte_count = _get_utf8_sequence(text_ptr, text_end, &cp32);
+                if (0 == byte_count)
+                {
+                    // Only a lead byte followed by too few continuation bytes may wait for more text
+                    size_t need_count = *text_ptr >= 0xF0 ? 4 : (*text_ptr >= 0xE0 ? 3 : 2);
+                    if (*text_ptr < 0xC2 || *text_ptr > 0xF4 || (size_t)(text_end - text_ptr) >= need_count)
+                    {
+                        return false;
+                    }
+
+                    break;
+                }
+
+                if (cp32 >= 0x10000)
+                {
+                    cp32 -= 0x10000;
+                    text_utf16.push_back((uint16_t)(0xD800 + (cp32 >> 10)));
+                    text_utf16.push_back((uint16_t)(0xDC00 + (cp32 & 0x3FF)));
+                }
+                else
+                {
+                    text_utf16.push_back((uint16_t)cp32);
+                }
+
+                text_ptr += byte_count;
+            }
+
+            pending_text.erase(0, (const _tchar*)text_ptr - pending_text.data());
+            output_file.write((const char*)text_utf16.data(), text_utf16.size() * sizeof(uint16_t));
+            text_utf16.clear();
+            return output_file.good();
+            }, indent, flag_escape);
+#endif
+
+        output_file.close();
+        return result_flag && pending_text.empty() && !output_file.fail();
+    }
+
+    bool json_value::_parse_number(const _tchar* data_ptr, const _tchar* data_end, json_value& val, const _tchar** end_ptr)
+    {
+        json_data number_data;
+        json_type number_type = json_type::json_type_null;
+
+        if (!_parse_number(data_ptr, data_end, number_type, number_data, end_ptr))
+        {
+            return false;
+        }
+
+        val._reset_type(number_type);
+        val.m_long.data = number_data;
+        return true;
+    }
+
+    bool json_value::_parse_number(const _tchar* data_ptr, const _tchar* data_end, json_type& type, json_data& data, const _tchar** end_ptr)
+    {
+        // [-]?[0-9]+\.[0-9]+[eE]?[-+]?[0-9]+
+        const _tchar* start_ptr = data_ptr;
+        uint64_t int_value = 0;
+        bool flag_negative = false;
+        bool flag_overflow = false;
+        bool flag_dot = false;
+        bool flag_exponent = false;
+        bool result_flag = false;
+
+        do
+        {
+            if (data_ptr < data_end && _T('-') == *data_ptr)
+            {
+                flag_negative = true;
+                data_ptr++;
+            }
+
+            // Accumulate the integer part while it fits in 64 bits
+            const _tchar* digit_ptr = data_ptr;
+            while (data_ptr < data_end && *data_ptr >= _T('0') && *data_ptr <= _T('9'))
+            {
+                uint32_t digit = (uint32_t)(*data_ptr - _T('0'));
+                if (int_value < UINT64_MAX / 10 || (UINT64_MAX / 10 == int_value && digit <= UINT64_MAX % 10))
+                {
+                    int_value = int_value * 10 + digit;
+                }
+                else
+                {
+                    flag_overflow = true;
+                }
+
+                data_ptr++;
+            }
+
+            if (digit_ptr == data_ptr)
+            {
+                break;
+            }
+
+            if (data_ptr < data_end && _T('.') == *data_ptr)
+            {
+                flag_dot = true;
+                data_ptr++;
+            }
+
+            if (flag_dot)
+            {
+                if (!_skip_digit(data_ptr, data_end, &data_ptr))
+                {
+                    break;
+                }
+            }
+
+            if (data_ptr < data_end && (_T('E') == *data_ptr || _T('e') == *data_ptr))
+            {
+                flag_exponent = true;
+                data_ptr++;
+
+                if (data_ptr < data_end && (_T('-') == *data_ptr || _T('+') == *data_ptr))
+                {
+                    data_ptr++;
+                }
+
+                if (!_skip_digit(data_ptr, data_end, &data_ptr))
+                {
+                    break;
+                }
+            }
+
+            // Integers below -2^63 or above 2^64 - 1 become floats
+            if (flag_negative && int_value > (uint64_t)INT64_MAX + 1)
+            {
+                flag_overflow = true;
+            }
+
+            if (flag_dot || flag_exponent || flag_overflow)
+            {
+                type = json_type::json_type_float;
+                data._float = _parse_double(start_ptr, data_ptr);
+            }
+            else if (flag_negative)
+            {
+                type = json_type::json_type_int;
+                data._int = 0 == int_value ? 0 : -(int64_t)(int_value - 1) - 1;
+            }
+            else
+            {
+                type = json_type::json_type_uint;
+                data._uint = int_value;
+            }
+
+            result_flag = true;
+
+        } while (false);
+
+        if (end_ptr)
+        {
+            *end_ptr = data_ptr;
+        }
+
+        return result_flag;
+    }
+
+    bool json_value::_parse_unicode(const _tchar* data_ptr, const _tchar* data_end, _tstring& val, const _tchar** end_ptr)
+    {
+        uint32_t cp32 = 0;
+        bool result_flag = false;
+
+        do
+        {
+            if (!_get_utf16_code_point(data_ptr, data_end, &cp32, &data_ptr))
+            {
+                break;
+            }
+
+            // High bits
+            if (cp32 >= 0xD800 && cp32 <= 0xDBFF)
+            {
+                cp32 -= 0xD800;
+
+                if (!_skip_literal(data_ptr, data_end, _T(R"(\u)"), 2))
+                {
+                    break;
+                }
+
+                data_ptr += 2;
+
+                uint32_t cp_low = 0;
+                if (!_get_utf16_code_point(data_ptr, data_end, &cp_low, &data_ptr))
+                {
+                    break;
+                }
+
+                // Low Bits
+                if (cp_low >= 0xDC00 && cp_low <= 0xDFFF)
+                {
+                    cp_low -= 0xDC00;
+
+                    cp32 = 0x10000 + ((cp32 << 10) | cp_low);
+#ifdef _UNICODE
+                    uint16_t cp = (uint16_t)(cp32 - 0x10000);
+                    uint16_t cp32_high = (uint16_t)(cp >> 10) + 0xD800;
+                    uint16_t cp32_low = (uint16_t)(cp & 0x3FF) + 0xDC00;
+                    val.push_back(cp32_high);
+                    val.push_back(cp32_low);
+#else
+                    val += std::move(_get_utf8_text_for_code_point(cp32));
+#endif
+                }
+                else
+                {
+                    break;
+                }
+            }
+            else
+            {
+#ifdef _UNICODE
+                val.push_back((_tchar)cp32);
+#else
+                val += std::move(_get_utf8_text_for_code_point(cp32));
+#endif
+            }
+
+            result_flag = true;
+
+        } while (false);
+
+        if (end_ptr)
+        {
+            *end_ptr = data_ptr;
+        }
+
+        return result_flag;
+    }
+
+    bool json_value::_parse_string(const _tchar* data_ptr, const _tchar* data_end, _tstring& val, const _tchar** end_ptr)
+    {
+        bool flag_abort = false;
+
+        data_ptr = _skip_whitespace(data_ptr, data_end);
+        if (data_ptr >= data_end || _T('\"') != *data_ptr)
+        {
+            return false;
+        }
+
+        data_ptr++;
+
+        while (data_ptr < data_end)
+        {
+            // Copy the run up to the next quote, backslash or NUL in one append
+            const _tchar* run_end = _find_string_special(data_ptr, data_end);
+            if (run_end > data_ptr)
+            {
+                val.append(data_ptr, run_end - data_ptr);
+                data_ptr = run_end;
+            }
+
+            if (data_ptr >= data_end || _T('\\') != *data_ptr)
+            {
+                break;
+            }
+
+            // Escape sequence
+            data_ptr++;
+            _tchar ch = (data_ptr < data_end) ? *data_ptr : _T('\0');
+
+            switch (ch)
+            {
+            case _T('\"'):
+            {
+                val.push_back(_T('\"'));
+            }
+            break;
+            case _T('\\'):
+            {
+                val.push_back(_T('\\'));
+            }
+            break;
+            case _T('/'):
+            {
+                val.push_back(_T('/'));
+            }
+            break;
+            case _T('b'):
+            {
+                val.push_back(_T('\b'));
+            }
+            break;
+            case _T('f'):
+            {
+                val.push_back(_T('\f'));
+            }
+            break;
+            case _T('n'):
+            {
+                val.push_back(_T('\n'));
+            }
+            break;
+            case _T('r'):
+            {
+                val.push_back(_T('\r'));
+            }
+            break;
+            case _T('t'):
+            {
+                val.push_back(_T('\t'));
+            }
+            break;
+            case _T('u'):
+            {
+                data_ptr++;
+                if (!_parse_unicode(data_ptr, data_end, val, &data_ptr))
+                {
+                    flag_abort = true;
+                    break;
+                }
+                continue;
+            }
+            break;
+            default:
+                data_ptr--;
+                flag_abort = true;
+                break;
+            }
+
+            if (flag_abort)
+            {
+                break;
+            }
+
+            data_ptr++;
+        }
+
+        if (data_ptr >= data_end || _T('\"') != *data_ptr || flag_abort)
+        {
+            *end_ptr = data_ptr;
+            return false;
+        }
+
+        data_ptr++;
+
+        if (end_ptr)
+        {
+            *end_ptr = data_ptr;
+        }
+
+        return true;
+    }
+
+    void json_value::_dump_int(json_writer& append_str, int64_t val) const
+    {
+        _tchar out_buffer[32];
+        size_t length = _format_int(out_buffer, val);
+        append_str.append(out_buffer, length);
+    }
+
+    void json_value::_dump_uint(json_writer& append_str, uint64_t val) const
+    {
+        _tchar out_buffer[32];
+        size_t length = _format_uint(out_buffer, val);
+        append_str.append(out_buffer, length);
+    }
+
+    void json_value::_dump_float(json_writer& append_str, double val) const
+    {
+        _tchar out_buffer[32];
+        size_t length = _format_double(out_buffer, val);
+        append_str.append(out_buffer, length);
+    }
+
+    // Second character of the two character escapes, 'u' for the ones written as \u00XX
+    static const char json_escape_chars[0x20] =
+    {
+        'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+        'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    };
+
+    static const char json_hex_digits[] = "0123456789abcdef";
+
+    // \uXXXX with lower case hex digits, returns the 6 characters written
+    static size_t _put_escaped_code_unit(_tchar* out_ptr, uint32_t code_unit)
+    {
+        out_ptr[0] = _T('\\');
+        out_ptr[1] = _T('u');
+        out_ptr[2] = (_tchar)json_hex_digits[(code_unit >> 12) & 0x0F];
+        out_ptr[3] = (_tchar)json_hex_digits[(code_unit >> 8) & 0x0F];
+        out_ptr[4] = (_tchar)json_hex_digits[(code_unit >> 4) & 0x0F];
+        out_ptr[5] = (_tchar)json_hex_digits[code_unit & 0x0F];
+        return 6;
+    }
+
+    void json_value::_dump_string(json_writer& append_str, const _tchar* text, bool flag_escape) const
+    {
+        const _tchar* data_ptr = text;
+        const _tchar* data_end = text + std::char_traits<_tchar>::length(text);
+
+        while (data_ptr < data_end)
+        {
+            // Runs that need no escaping are appended at once
+            const _tchar* run_end = _find_dump_special(data_ptr, data_end, flag_escape);
+            append_str.append(data_ptr, run_end - data_ptr);
+            if (run_end >= data_end)
+            {
+                break;
+            }
+
+            data_ptr = run_end;
+            _utchar ch = *data_ptr;
+
+            if (_T('\"') == ch || _T('\\') == ch)
+            {
+                _tchar out_buffer[2] = { _T('\\'), (_tchar)ch };
+                append_str.append(out_buffer, 2);
+                data_ptr++;
+            }
+            else if (ch < 0x20)
+            {
+                _tchar out_buffer[6] = { _T('\\'), (_tchar)json_escape_chars[ch] };
+                size_t length = 'u' == json_escape_chars[ch] ? _put_escaped_code_unit(out_buffer, ch) : 2;
+                append_str.append(out_buffer, length);
+                data_ptr++;
+            }
+            else
+            {
+                _append_unicode_escape(append_str, data_ptr, data_end, &data_ptr);
+            }
+        }
+    }
+
+    void json_value::_dump_object(json_writer& append_str, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const
+    {
+        const json_object& object = *m_long.data._object_ptr;
+        size_t size = object.size();
+
+        append_str += _T("{");
+        if (indent > 0)
+        {
+            depth++;
+
+            if (indent_text.size() <= depth)
+            {
+                indent_text.emplace_back(_tstring(depth * indent, _T(' ')));
+            }
+
+            append_str += _T(FC_JSON_RETURN);
+
+            for (const auto& item : object)
+            {
+                append_str += indent_text[depth];
+                append_str += _T("\"");
+                _dump_string(append_str, item.first.c_str(), flag_escape);
+                append_str += _T("\": ");
+                item.second._dump(append_str, indent_text, depth, indent, flag_escape);
+                size--;
+
+                if (0 != size)
+                {
+                    append_str += _T(",");
+                }
+
+                append_str += _T(FC_JSON_RETURN);
+            }
+
+            depth--;
+            append_str += indent_text[depth];
+        }
+        else
+        {
+            for (const auto& item : object)
+            {
+                append_str += _T("\"");
+                _dump_string(append_str, item.first.c_str(), flag_escape);
+                append_str += _T("\":");
+                item.second._dump(append_str, indent_text, depth, indent, flag_escape);
+                size--;
+
+                if (0 != size)
+                {
+                    append_str += _T(",");
+                }
+            }
+        }
+        append_str += _T("}");
+    }
+
+    void json_value::_dump_array(json_writer& append_str, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const
+    {
+        const json_array& array = *m_long.data._array_ptr;
+        size_t size = array.size();
+
+        append_str += _T("[");
+        if (indent > 0)
+        {
+            depth++;
+
+            if (indent_text.size() <= depth)
+            {
+                indent_text.emplace_back(_tstring(depth * indent, _T(' ')));
+            }
+
+            append_str += _T(FC_JSON_RETURN);
+
+            for (const auto& item : array)
+            {
+                append_str += indent_text[depth];
+                item._dump(append_str, indent_text, depth, indent, flag_escape);
+                size--;
+                if (0 != size)
+                {
+                    append_str += _T(",");
+                }
+
+                append_str += _T(FC_JSON_RETURN);
+            }
+
+            depth--;
+            append_str += indent_text[depth];
+        }
+        else
+        {
+            for (const auto& item : array)
+            {
+                item._dump(append_str, indent_text, depth, indent, flag_escape);
+                size--;
+                if (0 != size)
+                {
+                    append_str += _T(",");
+                }
+            }
+        }
+        append_str += _T("]");
+    }
+
+    void json_value::_dump(json_writer& append_str, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const
+    {
+        if (indent < 0)
+        {
+            indent = 0;
+        }
+
+        switch (m_long.type)
+        {
+        case json_type::json_type_null:
+        {
+            append_str += _T("null");
+        }
+        break;
+        case json_type::json_type_bool:
+        {
+            append_str += m_long.data._bool ? _T("true") : _T("false");
+        }
+        break;
+        case json_type::json_type_int:
+        {
+            _dump_int(append_str, m_long.data._int);
+        }
+        break;
+        case json_type::json_type_uint:
+        {
+            _dump_uint(append_str, m_long.data._uint);
+        }
+        break;
+        case json_type::json_type_float:
+        {
+            _dump_float(append_str, m_long.data._float);
+        }
+        break;
+        case json_type::json_type_string:
+        {
+            append_str += _T("\"");
+            _dump_string(append_str, (m_long.flags & json_flag_short) ? m_short.text : m_long.data._string_ptr->c_str(), flag_escape);
+            append_str += _T("\"");
+        }
+        break;
+        case json_type::json_type_object:
+        {
+            if (nullptr == m_long.data._object_ptr)
+            {
+                append_str += _T("{}");
+                break;
+            }
+
+            if (m_long.data._object_ptr->empty())
+            {
+                append_str += _T("{}");
+                break;
+            }
+
+            _dump_object(append_str, indent_text, depth, indent, flag_escape);
+        }
+        break;
+        case json_type::json_type_array:
+        {
+            if (nullptr == m_long.data._array_ptr)
+            {
+                append_str += _T("[]");
+                break;
+            }
+
+            if (m_long.data._array_ptr->empty())
+            {
+                append_str += _T("[]");
+                break;
+            }
+
+            _dump_array(append_str, indent_text, depth, indent, flag_escape);
+        }
+        break;
+        default:
+        {
+        }
+        break;
+        }
+    }
+
+    size_t json_value::_dump_string_size(const _tchar* text, bool flag_escape) const
+    {
+        const _tchar* data_ptr = text;
+        const _tchar* data_end = nullptr;
+        uint8_t stop_mask = flag_escape ? 3 : 1;
+        size_t size = 0;
+
+        // Same walk as _dump_string, counting instead of appending
+        while (true)
+        {
+            if (nullptr == data_end)
+            {
+                // Short strings, most keys and values, are counted before their length is known
+                size_t count = 0;
+                while (count < 16 && 0 == (_dump_char_class(data_ptr[count]) & stop_mask))
+                {
+                    count++;
+                }
+
+                data_ptr += count;
+                size += count;
+                if (16 == count)
+                {
+                    data_end = data_ptr + std::char_traits<_tchar>::length(data_ptr);
+                    continue;
+                }
+            }
+            else
+            {
+                const _tchar* run_end = _find_dump_special(data_ptr, data_end, flag_escape);
+                size += run_end - data_ptr;
+                data_ptr = run_end;
+            }
+
+            // The terminating NUL is a control character, so every run stops at it
+            _utchar ch = *data_ptr;
+            if (_T('\0') == ch)
+            {
+                break;
+            }
+
+            if (_T('\"') == ch || _T('\\') == ch)
+            {
+                size += 2;
+                data_ptr++;
+            }
+            else if (ch < 0x20)
+            {
+                size += 'u' == json_escape_chars[ch] ? 6 : 2;
+                data_ptr++;
+            }
+            else
+            {
+                if (nullptr == data_end)
+                {
+                    data_end = data_ptr + std::char_traits<_tchar>::length(data_ptr);
+                }
+
+                // The whole run of non-ASCII characters
+                while (data_ptr < data_end && (_utchar)*data_ptr >= 0x80)
+                {
+                    uint32_t cp32 = 0;
+                    size_t byte_count = _get_escape_code_point(data_ptr, data_end, &cp32);
+
+                    size += 0 == byte_count ? 1 : (cp32 >= 0x10000 ? 12 : 6);
+                    data_ptr += 0 == byte_count ? 1 : byte_count;
+                }
+            }
+        }
+
+        return size;
+    }
+
+    size_t json_value::_dump_size(int depth, int indent, bool flag_escape) const
+    {
+        if (indent < 0)
+        {
+            indent = 0;
+        }
+
+        switch (m_long.type)
+        {
+        case json_type::json_type_null:
+            return 4;
+        case json_type::json_type_bool:
+            return m_long.data._bool ? 4 : 5;
+        case json_type::json_type_int:
+        {
+            _tchar out_buffer[32];
+            return _format_int(out_buffer, m_long.data._int);
+        }
+        case json_type::json_type_uint:
+        {
+            _tchar out_buffer[32];
+            return _format_uint(out_buffer, m_long.data._uint);
+        }
+        case json_type::json_type_float:
+        {
+            _tchar out_buffer[32];
+            return _format_double(out_buffer, m_long.data._float);
+        }
+        case json_type::json_type_string:
+            return 2 + _dump_string_size((m_long.flags & json_flag_short) ? m_short.text : m_long.data._string_ptr->c_str(), flag_escape);
+        case json_type::json_type_object:
+        {
+            if (nullptr == m_long.data._object_ptr || m_long.data._object_ptr->empty())
+            {
+                return 2;
+            }
+
+            // Braces and commas, then per member the quotes, colon, and with indent the space,
+            // the line break and the leading spaces
+            const json_object& object = *m_long.data._object_ptr;
+            size_t size = 2 + object.size() - 1;
+            size_t member_size = indent > 0 ? 4 + (size_t)(depth + 1) * indent + 1 : 3;
+
+            if (indent > 0)
+            {
+                size += 1 + (size_t)depth * indent;
+            }
+
+            for (const auto& item : object)
+            {
+                size += member_size + _dump_string_size(item.first.c_str(), flag_escape);
+                size += item.second._dump_size(depth + 1, indent, flag_escape);
+            }
+
+            return size;
+        }
+        case json_type::json_type_array:
+        {
+            if (nullptr == m_long.data._array_ptr || m_long.data._array_ptr->empty())
+            {
+                return 2;
+            }
+
+            const json_array& array = *m_long.data._array_ptr;
+            size_t size = 2 + array.size() - 1;
+
+            if (indent > 0)
+            {
+                size += 1 + (size_t)depth * indent + array.size() * ((size_t)(depth + 1) * indent + 1);
+            }
+
+            for (const auto& item : array)
+            {
+                size += item._dump_size(depth + 1, indent, flag_escape);
+            }
+
+            return size;
+        }
+        default:
+            break;
+        }
+
+        return 0;
+    }
+
+    void json_value::_dump_raw_int(std::vector<uint8_t>& append_buf, int64_t val) const
+    {
+        union _data_info
+        {
+            int64_t data;
+            uint8_t bytes[sizeof(int64_t)];
+        }data_info;
+
+        data_info.data = val;
+        int data_size = sizeof(int64_t);
+
+        if (val <= INT8_MAX && val >= INT8_MIN)
+        {
+            append_buf.push_back(json_raw_type::raw_int8);
+            data_size = sizeof(uint8_t);
+        }
+        else if (val <= INT16_MAX && val >= INT16_MIN)
+        {
+            append_buf.push_back(json_raw_type::raw_int16);
+            data_size = sizeof(uint16_t);
+        }
+        else if (val <= INT32_MAX && val >= INT32_MIN)
+        {
+            append_buf.push_back(json_raw_type::raw_int32);
+            data_size = sizeof(uint32_t);
+        }
+        else
+        {
+            append_buf.push_back(json_raw_type::raw_int64);
+            data_size = sizeof(uint64_t);
+        }
+
+        for (int i = 0; i < data_size; i++)
+        {
+            append_buf.push_back(data_info.bytes[i]);
+        }
+    }
+
+    void json_value::_dump_raw_uint(std::vector<uint8_t>& append_buf, uint64_t val) const
+    {
+        union _data_info
+        {
+            uint64_t data;
+            uint8_t bytes[sizeof(uint64_t)];
+        }data_info;
+
+        data_info.data = val;
+        int data_size = sizeof(uint64_t);
+
+        if (val <= UINT8_MAX)
+        {
+            append_buf.push_back(json_raw_type::raw_uint8);
+            data_size = sizeof(uint8_t);
+        }
+        else if (val <= UINT16_MAX)
+        {
+            append_buf.push_back(json_raw_type::raw_uint16);
+            data_size = sizeof(uint16_t);
+        }
+        else if (val <= UINT32_MAX)
+        {
+            append_buf.push_back(json_raw_type::raw_uint32);
+            data_size = sizeof(uint32_t);
+        }
+        else
+        {
+            append_buf.push_back(json_raw_type::raw_uint64);
+            data_size = sizeof(uint64_t);
+        }
+
+        for (int i = 0; i < data_size; i++)
+        {
+            append_buf.push_back(data_info.bytes[i]);
+        }
+    }
+
+    void json_value::_dump_raw_float(std::vector<uint8_t>& append_buf, double val) const
+    {
+        union _data_info
+        {
+            double data;
+            uint8_t bytes[sizeof(double)];
+        }data_info;
+
+        data_info.data = val;
+
+        for (int i = 0; i < sizeof(double); i++)
+        {
+            append_buf.push_back(data_info.bytes[i]);
+        }
+    }
+
+    void json_value::_dump_raw_string(std::vector<uint8_t>& append_buf, const std::string& text) const
+    {
+        if (text.empty())
+        {
+            append_buf.push_back(json_raw_type::raw_string_empty);
+        }
+        else
+        {
+            int data_size = 0;
+            union _data_info
+            {
+                uint32_t data;
+                uint8_t bytes[sizeof(uint32_t)];
+            }data_info;
+
+            data_info.data = text.size();
+            if (data_info.data <= UINT8_MAX)
+            {
+                append_buf.push_back(json_raw_type::raw_string8);
+                data_size = sizeof(uint8_t);
+            }
+            else if (data_info.data <= UINT16_MAX)
+            {
+                append_buf.push_back(json_raw_type::raw_string16);
+                data_size = sizeof(uint16_t);
+            }
+            else
+            {
+                append_buf.push_back(json_raw_type::raw_string32);
+                data_size = sizeof(uint32_t);
+            }
+
+            for (int i = 0; i < data_size; i++)
+            {
+                append_buf.push_back(data_info.bytes[i]);
+            }
+
+            append_buf.insert(append_buf.end(), text.begin(), text.end());
+        }
+    }
+
+    void json_value::_dump_raw_object(std::vector<uint8_t>& append_buf, const json_object& object) const
+    {
+        for (const auto& item : object)
+        {
+#ifdef _UNICODE
+            _dump_raw_string(append_buf, _utf16_to_utf8(item.first));
+#else
+            _dump_raw_string(append_buf, item.first);
+#endif
+            item.second._dump_raw(append_buf);
+        }
+    }
+
+    void json_value::_dump_raw_array(std::vector<uint8_t>& append_buf, const json_array& arrry) const
+    {
+        for (const auto& item : arrry)
+        {
+            item._dump_raw(append_buf);
+        }
+    }
+
+    void json_value::_dump_raw_bin(std::vector<uint8_t>& append_buf, const json_bin& raw) const
+    {
+        if (raw.empty())
+        {
+            append_buf.push_back(json_raw_type::raw_bin_empty);
+        }
+        else
+        {
+            int data_size = 0;
+            union _data_info
+            {
+                uint32_t data;
+                uint8_t bytes[sizeof(uint32_t)];
+            }data_info;
+
+            data_info.data = raw.size();
+            if (data_info.data <= UINT8_MAX)
+            {
+                append_buf.push_back(json_raw_type::raw_bin8);
+                data_size = sizeof(uint8_t);
+            }
+            else if (data_info.data <= UINT16_MAX)
+            {
+                append_buf.push_back(json_raw_type::raw_bin16);
+                data_size = sizeof(uint16_t);
+            }
+            else
+            {
+                append_buf.push_back(json_raw_type::raw_bin32);
+                data_size = sizeof(uint32_t);
+            }
+
+            for (int i = 0; i < data_size; i++)
+            {
+                append_buf.push_back(data_info.bytes[i]);
+            }
+
+            append_buf.insert(append_buf.end(), raw.begin(), raw.end());
+        }
+    }
+
+    void json_value::_dump_raw(std::vector<uint8_t>& append_buf) const
+    {
+        switch (m_long.type)
+        {
+        case json_type::json_type_null:
+        {
+            append_buf.push_back(json_raw_type::raw_null);
+        }
+        break;
+        case json_type::json_type_bool:
+        {
+            if (m_long.data._bool)
+            {
+                append_buf.push_back(json_raw_type::raw_true);
+            }
+            else
+            {
+                append_buf.push_back(json_raw_type::raw_false);
+            }
+        }
+        break;
+        case json_type::json_type_int:
+        {
+            _dump_raw_int(append_buf, m_long.data._int);
+        }
+        break;
+        case json_type::json_type_uint:
+        {
+            _dump_raw_uint(append_buf, m_long.data._uint);
+        }
+        break;
+        case json_type::json_type_float:
+        {
+            append_buf.push_back(json_raw_type::raw_float);
+            _dump_raw_float(append_buf, m_long.data._float);
+        }
+        break;
+        case json_type::json_type_string:
+        {
+            json_string short_text;
+            if (m_long.flags & json_flag_short)
+            {
+                short_text = m_short.text;
+            }
+
+            const json_string& text = (m_long.flags & json_flag_short) ? short_text : *m_long.data._string_ptr;
+#ifdef _UNICODE
+            _dump_raw_string(append_buf, _utf16_to_utf8(text));
+#else
+            _dump_raw_string(append_buf, text);
+#endif
+        }
+        break;
+        case json_type::json_type_object:
+        {
+            if (m_long.data._object_ptr && !m_long.data._object_ptr->empty())
+            {
+                append_buf.push_back(json_raw_type::raw_object_beg);
+                _dump_raw_object(append_buf, *m_long.data._object_ptr);
+                append_buf.push_back(json_raw_type::raw_object_end);
+            }
+            else
+            {
+                append_buf.push_back(json_raw_type::raw_object_empty);
+            }
+        }
+        break;
+        case json_type::json_type_array:
+        {
+            if (m_long.data._array_ptr && !m_long.data._array_ptr->empty())
+            {
+                append_buf.push_back(json_raw_type::raw_array_beg);
+                _dump_raw_array(append_buf, *m_long.data._array_ptr);
+                append_buf.push_back(json_raw_type::raw_array_end);
+            }
+            else
+            {
+                append_buf.push_back(json_raw_type::raw_array_empty);
+            }
+        }
+        break;
+        case json_type::json_type_bin:
+        {
+            if (m_long.data._raw_ptr && !m_long.data._raw_ptr->empty())
+            {
+                _dump_raw_bin(append_buf, *m_long.data._raw_ptr);
+            }
+            else
+            {
+                append_buf.push_back(json_raw_type::raw_bin_empty);
+            }
+        }
+        break;
+        }
+    }
+
+    bool json_value::_parse_raw_string(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val)
+    {
+        json_raw_type type = (json_raw_type)*data_ptr;
+        const uint8_t* date_value_ptr = data_ptr + sizeof(json_raw_type);
+        const uint8_t* data_next_ptr = data_ptr;
+        std::string str_value;
+
+        switch (*data_ptr)
+        {
+        case json_raw_type::raw_string_empty:
+            data_next_ptr += sizeof(json_raw_type);
+            break;
+        case json_raw_type::raw_string8:
+            str_value = std::string((const char*)(date_value_ptr + sizeof(uint8_t)), *(uint8_t*)date_value_ptr);
+            data_next_ptr = date_value_ptr + sizeof(uint8_t) + *(uint8_t*)date_value_ptr;
+            break;
+        case json_raw_type::raw_string16:
+            str_value = std::string((const char*)(date_value_ptr + sizeof(uint16_t)), *(uint16_t*)date_value_ptr);
+            data_next_ptr = date_value_ptr + sizeof(uint16_t) + *(uint16_t*)date_value_ptr;
+            break;
+        case json_raw_type::raw_string32:
+            str_value = std::string((const char*)(date_value_ptr + sizeof(uint32_t)), *(uint32_t*)date_value_ptr);
+            data_next_ptr = date_value_ptr + sizeof(uint32_t) + *(uint32_t*)date_value_ptr;
+            break;
+        }
+
+#ifdef _UNICODE
+        val = _utf8_to_utf16(str_value);
+#else
+        val = str_value;
+#endif
+
+        if (end_ptr)
+        {
+            *end_ptr = data_next_ptr;
+        }
+
+        return true;
+    }
+
+    bool json_value::_parse_raw_object(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val)
+    {
+        val._reset_type(json_type::json_type_object);
+
+        const uint8_t* data_next_ptr = data_ptr;
+        while (true)
+        {
+            std::string key_name;
+            json_value key_value;
+
+            if (json_raw_type::raw_object_end == *data_next_ptr)
+            {
+                data_next_ptr++;
+                break;
+            }
+
+            const uint8_t* value_ptr = data_next_ptr + sizeof(json_raw_type);
+            size_t value_size = 0;
+            switch (*data_next_ptr)
+            {
+            case json_raw_type::raw_string8:
+                value_size = *(uint8_t*)value_ptr;
+                key_name = std::string((const char*)(value_ptr + sizeof(uint8_t)), value_size);
+                data_next_ptr = (value_ptr + sizeof(uint8_t)) + value_size;
+                break;
+            case json_raw_type::raw_string16:
+                value_size = *(uint16_t*)value_ptr;
+                key_name = std::string((const char*)(value_ptr + sizeof(uint16_t)), value_size);
+                data_next_ptr = (value_ptr + sizeof(uint16_t)) + value_size;
+                break;
+            case json_raw_type::raw_string32:
+                value_size = *(uint32_t*)value_ptr;
+                key_name = std::string((const char*)(value_ptr + sizeof(uint32_t)), value_size);
+                data_next_ptr = (value_ptr + sizeof(uint32_t)) + value_size;
+                break;
+            default:
+                return false;
+            }
+
+            if (key_name.empty())
+            {
+                return false;
+            }
+
+            if (!_parse_raw(data_next_ptr, &data_next_ptr, key_value))
+            {
+                return false;
+            }
+
+#ifdef _UNICODE
+            val[_utf8_to_utf16(key_name)] = key_value;
+#else
+            val[key_name] = key_value;
+#endif
+        }
+
+        if (end_ptr)
+        {
+            *end_ptr = data_next_ptr;
+        }
+
+        return true;
+    }
+
+    bool json_value::_parse_raw_array(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val)
+    {
+        const uint8_t* data_next_ptr = data_ptr;
+        val._reset_type(json_type::json_type_array);
+
+        while (true)
+        {
+            if (json_raw_type::raw_array_end == *data_next_ptr)
+            {
+                data_next_ptr++;
+                break;
+            }
+
+            json_value value;
+            if (!_parse_raw(data_next_ptr, &data_next_ptr, value))
+            {
+                return false;
+            }
+
+            val.m_long.data._array_ptr->emplace_back(std::move(value));
+        }
+
+        if (end_ptr)
+        {
+            *end_ptr = data_next_ptr;
+        }
+
+        return true;
+    }
+
+    bool json_value::_parse_raw_bin(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val)
+    {
+        json_raw_type type = (json_raw_type)*data_ptr;
+        const uint8_t* date_value_ptr = data_ptr + sizeof(json_raw_type);
+        const uint8_t* data_next_ptr = data_ptr;
+
+        json_bin raw;
 
         switch (*data_ptr)
         {
-        case json_raw_type::raw_bin_empty:
-            val = json_bin();
-            data_next_ptr += sizeof(json_raw_type);
-            break;
-        case json_raw_type::raw_bin8:
-            raw.assign(date_value_ptr + sizeof(uint8_t), date_value_ptr + sizeof(uint8_t) + *(uint8_t*)date_value_ptr);
-            val = std::move(raw);
-            data_next_ptr = date_value_ptr + sizeof(uint8_t) + *(uint8_t*)date_value_ptr;
-            break;
-        case json_raw_type::raw_bin16:
-            raw.assign(date_value_ptr + sizeof(uint16_t), date_value_ptr + sizeof(uint16_t) + *(uint16_t*)date_value_ptr);
-            val = std::move(raw);
-            data_next_ptr = date_value_ptr + sizeof(uint16_t) + *(uint16_t*)date_value_ptr;
-            break;
-        case json_raw_type::raw_bin32:
-            raw.assign(date_value_ptr + sizeof(uint32_t), date_value_ptr + sizeof(uint32_t) + *(uint32_t*)date_value_ptr);
-            val = std::move(raw);
-            data_next_ptr = date_value_ptr + sizeof(uint32_t) + *(uint32_t*)date_value_ptr;
-            break;
+        case json_raw_type::raw_bin_empty:
+            val = json_bin();
+            data_next_ptr += sizeof(json_raw_type);
+            break;
+        case json_raw_type::raw_bin8:
+            raw.assign(date_value_ptr + sizeof(uint8_t), date_value_ptr + sizeof(uint8_t) + *(uint8_t*)date_value_ptr);
+            val = std::move(raw);
+            data_next_ptr = date_value_ptr + sizeof(uint8_t) + *(uint8_t*)date_value_ptr;
+            break;
+        case json_raw_type::raw_bin16:
+            raw.assign(date_value_ptr + sizeof(uint16_t), date_value_ptr + sizeof(uint16_t) + *(uint16_t*)date_value_ptr);
+            val = std::move(raw);
+            data_next_ptr = date_value_ptr + sizeof(uint16_t) + *(uint16_t*)date_value_ptr;
+            break;
+        case json_raw_type::raw_bin32:
+            raw.assign(date_value_ptr + sizeof(uint32_t), date_value_ptr + sizeof(uint32_t) + *(uint32_t*)date_value_ptr);
+            val = std::move(raw);
+            data_next_ptr = date_value_ptr + sizeof(uint32_t) + *(uint32_t*)date_value_ptr;
+            break;
+        }
+
+        if (end_ptr)
+        {
+            *end_ptr = data_next_ptr;
+        }
+
+        return true;
+    }
+
+    bool json_value::_parse_raw(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val)
+    {
+        const uint8_t* date_value_ptr = data_ptr + sizeof(json_raw_type);
+        const uint8_t* data_next_ptr = data_ptr;
+        bool parse_result = true;
+
+        switch (*data_next_ptr)
+        {
+        case json_raw_type::raw_null:
+            val = json_type::json_type_null;
+            data_next_ptr += sizeof(json_raw_type);
+            break;
+        case json_raw_type::raw_false:
+            val = false;
+            data_next_ptr += sizeof(json_raw_type);
+            break;
+        case json_raw_type::raw_true:
+            val = true;
+            data_next_ptr += sizeof(json_raw_type);
+            break;
+        case json_raw_type::raw_int8:
+            val = *(int8_t*)date_value_ptr;
+            data_next_ptr += sizeof(json_raw_type) + sizeof(int8_t);
+            break;
+        case json_raw_type::raw_int16:
+            val = *(int16_t*)date_value_ptr;
+            data_next_ptr += sizeof(json_raw_type) + sizeof(int16_t);
+            break;
+        case json_raw_type::raw_int32:
+            val = *(int32_t*)date_value_ptr;
+            data_next_ptr += sizeof(json_raw_type) + sizeof(int32_t);
+            break;
+        case json_raw_type::raw_int64:
+            val = *(int64_t*)date_value_ptr;
+            data_next_ptr += sizeof(json_raw_type) + sizeof(int64_t);
+            break;
+        case json_raw_type::raw_uint8:
+            val = *(uint8_t*)date_value_ptr;
+            data_next_ptr += sizeof(json_raw_type) + sizeof(uint8_t);
+            break;
+        case json_raw_type::raw_uint16:
+            val = *(uint16_t*)date_value_ptr;
+            data_next_ptr += sizeof(json_raw_type) + sizeof(uint16_t);
+            break;
+        case json_raw_type::raw_uint32:
+            val = *(uint32_t*)date_value_ptr;
+            data_next_ptr += sizeof(json_raw_type) + sizeof(uint32_t);
+            break;
+        case json_raw_type::raw_uint64:
+            val = *(uint64_t*)date_value_ptr;
+            data_next_ptr += sizeof(json_raw_type) + sizeof(uint64_t);
+            break;
+        case json_raw_type::raw_float:
+            val = *(double*)date_value_ptr;
+            data_next_ptr += sizeof(json_raw_type) + sizeof(double);
+            break;
+        case json_raw_type::raw_string_empty:
+        case json_raw_type::raw_string8:
+        case json_raw_type::raw_string16:
+        case json_raw_type::raw_string32:
+            parse_result = _parse_raw_string(data_next_ptr, &data_next_ptr, val);
+            break;
+        case json_raw_type::raw_bin_empty:
+        case json_raw_type::raw_bin8:
+        case json_raw_type::raw_bin16:
+        case json_raw_type::raw_bin32:
+            parse_result = _parse_raw_bin(data_next_ptr, &data_next_ptr, val);
+            break;
+        case json_raw_type::raw_object_empty:
+            val._reset_type(json_type::json_type_object);
+            data_next_ptr += sizeof(json_raw_type);
+            break;
+        case json_raw_type::raw_object_beg:
+            parse_result = _parse_raw_object(date_value_ptr, &data_next_ptr, val);
+            break;
+        case json_raw_type::raw_object_end:
+            data_next_ptr += sizeof(json_raw_type);
+            break;
+        case json_raw_type::raw_array_empty:
+            val._reset_type(json_type::json_type_array);
+            data_next_ptr += sizeof(json_raw_type);
+            break;
+        case json_raw_type::raw_array_beg:
+            parse_result = _parse_raw_array(date_value_ptr, &data_next_ptr, val);
+            break;
+        case json_raw_type::raw_array_end:
+            data_next_ptr += sizeof(json_raw_type);
+            break;
+        default:
+            return false;
+        }
+
+        if (!parse_result)
+        {
+            return parse_result;
+        }
+
+        if (end_ptr)
+        {
+            *end_ptr = data_next_ptr;
+        }
+
+        return true;
+    }
+
+    std::vector<uint8_t> json_value::dump_to_binary()
+    {
+        std::vector<uint8_t> result;
+        _dump_raw(result);
+        return result;
+    }
+
+    bool json_value::dump_to_binary_file(const _tstring& strPath)
+    {
+        std::vector<uint8_t> result;
+        _dump_raw(result);
+
+        std::ofstream output_file(strPath, std::ios::binary | std::ios::out);
+        if (!output_file.is_open())
+        {
+            return false;
+        }
+
+        output_file.write((char*)result.data(), result.size());
+        output_file.close();
+
+        return true;
+    }
+
+    json_value& json_value::_get_none_value()
+    {
+        static json_value val(json_type::json_type_null);
+        return val;
+    }
+
+    bool _skip_digit(const _tchar* data_ptr, const _tchar* data_end, const _tchar** end_ptr)
+    {
+        if (data_ptr >= data_end || 0 == _json_istdigit(*data_ptr))
+        {
+            return false;
+        }
+
+        while (data_ptr < data_end && _json_istdigit(*data_ptr))
+        {
+            data_ptr++;
+        }
+
+        *end_ptr = data_ptr;
+
+        return true;
+    }
+
+    // 5^q for q in [-342, 326], normalized to 128 bits, high 64 bits first
+    // Truncated, except 5^-27 to 5^-1 which are rounded up, 5^0 to 5^55 are exact
+    static const uint64_t json_power_of_five_128[] =
+    {
+        0xEEF453D6923BD65AULL, 0x113FAA2906A13B3FULL,
+        0x9558B4661B6565F8ULL, 0x4AC7CA59A424C507ULL,
+        0xBAAEE17FA23EBF76ULL, 0x5D79BCF00D2DF649ULL,
+        0xE95A99DF8ACE6F53ULL, 0xF4D82C2C107973DCULL,
+        0x91D8A02BB6C10594ULL, 0x79071B9B8A4BE869ULL,
+        0xB64EC836A47146F9ULL, 0x9748E2826CDEE284ULL,
+        0xE3E27A444D8D98B7ULL, 0xFD1B1B2308169B25ULL,
+        0x8E6D8C6AB0787F72ULL, 0xFE30F0F5E50E20F7ULL,
+        0xB208EF855C969F4FULL, 0xBDBD2D335E51A935ULL,
+        0xDE8B2B66B3BC4723ULL, 0xAD2C788035E61382ULL,
+        0x8B16FB203055AC76ULL, 0x4C3BCB5021AFCC31ULL,
+        0xADDCB9E83C6B1793ULL, 0xDF4ABE242A1BBF3DULL,
+        0xD953E8624B85DD78ULL, 0xD71D6DAD34A2AF0DULL,
+        0x87D4713D6F33AA6BULL, 0x8672648C40E5AD68ULL,
+        0xA9C98D8CCB009506ULL, 0x680EFDAF511F18C2ULL,
+        0xD43BF0EFFDC0BA48ULL, 0x0212BD1B2566DEF2ULL,
+        0x84A57695FE98746DULL, 0x014BB630F7604B57ULL,
+        0xA5CED43B7E3E9188ULL, 0x419EA3BD35385E2DULL,
+        0xCF42894A5DCE35EAULL, 0x52064CAC828675B9ULL,
+        0x818995CE7AA0E1B2ULL, 0x7343EFEBD1940993ULL,
+        0xA1EBFB4219491A1FULL, 0x1014EBE6C5F90BF8ULL,
+        0xCA66FA129F9B60A6ULL, 0xD41A26E077774EF6ULL,
+        0xFD00B897478238D0ULL, 0x8920B098955522B4ULL,
+        0x9E20735E8CB16382ULL, 0x55B46E5F5D5535B0ULL,
+        0xC5A890362FDDBC62ULL, 0xEB2189F734AA831DULL,
+        0xF712B443BBD52B7BULL, 0xA5E9EC7501D523E4ULL,
+        0x9A6BB0AA55653B2DULL, 0x47B233C92125366EULL,
+        0xC1069CD4EABE89F8ULL, 0x999EC0BB696E840AULL,
+        0xF148440A256E2C76ULL, 0xC00670EA43CA250DULL,
+        0x96CD2A865764DBCAULL, 0x380406926A5E5728ULL,
+        0xBC807527ED3E12BCULL, 0xC605083704F5ECF2ULL,
+        0xEBA09271E88D976BULL, 0xF7864A44C633682EULL,
+        0x93445B8731587EA3ULL, 0x7AB3EE6AFBE0211DULL,
+        0xB8157268FDAE9E4CULL, 0x5960EA05BAD82964ULL,
+        0xE61ACF033D1A45DFULL, 0x6FB92487298E33BDULL,
+        0x8FD0C16206306BABULL, 0xA5D3B6D479F8E056ULL,
+        0xB3C4F1BA87BC8696ULL, 0x8F48A4899877186CULL,
+        0xE0B62E2929ABA83CULL, 0x331ACDABFE94DE87ULL,
+        0x8C71DCD9BA0B4925ULL, 0x9FF0C08B7F1D0B14ULL,
+        0xAF8E5410288E1B6FULL, 0x07ECF0AE5EE44DD9ULL,
+        0xDB71E91432B1A24AULL, 0xC9E82CD9F69D6150ULL,
+        0x892731AC9FAF056EULL, 0xBE311C083A225CD2ULL,
+        0xAB70FE17C79AC6CAULL, 0x6DBD630A48AAF406ULL,
+        0xD64D3D9DB981787DULL, 0x092CBBCCDAD5B108ULL,
+        0x85F0468293F0EB4EULL, 0x25BBF56008C58EA5ULL,
+        0xA76C582338ED2621ULL, 0xAF2AF2B80AF6F24EULL,
+        0xD1476E2C07286FAAULL, 0x1AF5AF660DB4AEE1ULL,
+        0x82CCA4DB847945CAULL, 0x50D98D9FC890ED4DULL,
+        0xA37FCE126597973CULL, 0xE50FF107BAB528A0ULL,
+        0xCC5FC196FEFD7D0CULL, 0x1E53ED49A96272C8ULL,
+        0xFF77B1FCBEBCDC4FULL, 0x25E8E89C13BB0F7AULL,
+        0x9FAACF3DF73609B1ULL, 0x77B191618C54E9ACULL,
+        0xC795830D75038C1DULL, 0xD59DF5B9EF6A2417ULL,
+        0xF97AE3D0D2446F25ULL, 0x4B0573286B44AD1DULL,
+        0x9BECCE62836AC577ULL, 0x4EE367F9430AEC32ULL,
+        0xC2E801FB244576D5ULL, 0x229C41F793CDA73FULL,
+        0xF3A20279ED56D48AULL, 0x6B43527578C1110FULL,
+        0x9845418C345644D6ULL, 0x830A13896B78AAA9ULL,
+        0xBE5691EF416BD60CULL, 0x23CC986BC656D553ULL,
+        0xEDEC366B11C6CB8FULL, 0x2CBFBE86B7EC8AA8ULL,
+        0x94B3A202EB1C3F39ULL, 0x7BF7D71432F3D6A9ULL,
+        0xB9E08A83A5E34F07ULL, 0xDAF5CCD93FB0CC53ULL,
+        0xE858AD248F5C22C9ULL, 0xD1B3400F8F9CFF68ULL,
+        0x91376C36D99995BEULL, 0x23100809B9C21FA1ULL,
+        0xB58547448FFFFB2DULL, 0xABD40A0C2832A78AULL,
+        0xE2E69915B3FFF9F9ULL, 0x16C90C8F323F516CULL,
+        0x8DD01FAD907FFC3BULL, 0xAE3DA7D97F6792E3ULL,
+        0xB1442798F49FFB4AULL, 0x99CD11CFDF41779CULL,
+        0xDD95317F31C7FA1DULL, 0x40405643D711D583ULL,
+        0x8A7D3EEF7F1CFC52ULL, 0x482835EA666B2572ULL,
+        0xAD1C8EAB5EE43B66ULL, 0xDA3243650005EECFULL,
+        0xD863B256369D4A40ULL, 0x90BED43E40076A82ULL,
+        0x873E4F75E2224E68ULL, 0x5A7744A6E804A291ULL,
+        0xA90DE3535AAAE202ULL, 0x711515D0A205CB36ULL,
+        0xD3515C2831559A83ULL, 0x0D5A5B44CA873E03ULL,
+        0x8412D9991ED58091ULL, 0xE858790AFE9486C2ULL,
+        0xA5178FFF668AE0B6ULL, 0x626E974DBE39A872ULL,
+        0xCE5D73FF402D98E3ULL, 0xFB0A3D212DC8128FULL,
+        0x80FA687F881C7F8EULL, 0x7CE66634BC9D0B99ULL,
+        0xA139029F6A239F72ULL, 0x1C1FFFC1EBC44E80ULL,
+        0xC987434744AC874EULL, 0xA327FFB266B56220ULL,
+        0xFBE9141915D7A922ULL, 0x4BF1FF9F0062BAA8ULL,
+        0x9D71AC8FADA6C9B5ULL, 0x6F773FC3603DB4A9ULL,
+        0xC4CE17B399107C22ULL, 0xCB550FB4384D21D3ULL,
+        0xF6019DA07F549B2BULL, 0x7E2A53A146606A48ULL,
+        0x99C102844F94E0FBULL, 0x2EDA7444CBFC426DULL,
+        0xC0314325637A1939ULL, 0xFA911155FEFB5308ULL,
+        0xF03D93EEBC589F88ULL, 0x793555AB7EBA27CAULL,
+        0x96267C7535B763B5ULL, 0x4BC1558B2F3458DEULL,
+        0xBBB01B9283253CA2ULL, 0x9EB1AAEDFB016F16ULL,
+        0xEA9C227723EE8BCBULL, 0x465E15A979C1CADCULL,
+        0x92A1958A7675175FULL, 0x0BFACD89EC191EC9ULL,
+        0xB749FAED14125D36ULL, 0xCEF980EC671F667BULL,
+        0xE51C79A85916F484ULL, 0x82B7E12780E7401AULL,
+        0x8F31CC0937AE58D2ULL, 0xD1B2ECB8B0908810ULL,
+        0xB2FE3F0B8599EF07ULL, 0x861FA7E6DCB4AA15ULL,
+        0xDFBDCECE67006AC9ULL, 0x67A791E093E1D49AULL,
+        0x8BD6A141006042BDULL, 0xE0C8BB2C5C6D24E0ULL,
+        0xAECC49914078536DULL, 0x58FAE9F773886E18ULL,
+        0xDA7F5BF590966848ULL, 0xAF39A475506A899EULL,
+        0x888F99797A5E012DULL, 0x6D8406C952429603ULL,
+        0xAAB37FD7D8F58178ULL, 0xC8E5087BA6D33B83ULL,
+        0xD5605FCDCF32E1D6ULL, 0xFB1E4A9A90880A64ULL,
+        0x855C3BE0A17FCD26ULL, 0x5CF2EEA09A55067FULL,
+        0xA6B34AD8C9DFC06FULL, 0xF42FAA48C0EA481EULL,
+        0xD0601D8EFC57B08BULL, 0xF13B94DAF124DA26ULL,
+        0x823C12795DB6CE57ULL, 0x76C53D08D6B70858ULL,
+        0xA2CB1717B52481EDULL, 0x54768C4B0C64CA6EULL,
+        0xCB7DDCDDA26DA268ULL, 0xA9942F5DCF7DFD09ULL,
+        0xFE5D54150B090B02ULL, 0xD3F93B35435D7C4CULL,
+        0x9EFA548D26E5A6E1ULL, 0xC47BC5014A1A6DAFULL,
+        0xC6B8E9B0709F109AULL, 0x359AB6419CA1091BULL,
+        0xF867241C8CC6D4C0ULL, 0xC30163D203C94B62ULL,
+        0x9B407691D7FC44F8ULL, 0x79E0DE63425DCF1DULL,
+        0xC21094364DFB5636ULL, 0x985915FC12F542E4ULL,
+        0xF294B943E17A2BC4ULL, 0x3E6F5B7B17B2939DULL,
+        0x979CF3CA6CEC5B5AULL, 0xA705992CEECF9C42ULL,
+        0xBD8430BD08277231ULL, 0x50C6FF782A838353ULL,
+        0xECE53CEC4A314EBDULL, 0xA4F8BF5635246428ULL,
+        0x940F4613AE5ED136ULL, 0x871B7795E136BE99ULL,
+        0xB913179899F68584ULL, 0x28E2557B59846E3FULL,
+        0xE757DD7EC07426E5ULL, 0x331AEADA2FE589CFULL,
+        0x9096EA6F3848984FULL, 0x3FF0D2C85DEF7621ULL,
+        0xB4BCA50B065ABE63ULL, 0x0FED077A756B53A9ULL,
+        0xE1EBCE4DC7F16DFBULL, 0xD3E8495912C62894ULL,
+        0x8D3360F09CF6E4BDULL, 0x64712DD7ABBBD95CULL,
+        0xB080392CC4349DECULL, 0xBD8D794D96AACFB3ULL,
+        0xDCA04777F541C567ULL, 0xECF0D7A0FC5583A0ULL,
+        0x89E42CAAF9491B60ULL, 0xF41686C49DB57244ULL,
+        0xAC5D37D5B79B6239ULL, 0x311C2875C522CED5ULL,
+        0xD77485CB25823AC7ULL, 0x7D633293366B828BULL,
+        0x86A8D39EF77164BCULL, 0xAE5DFF9C02033197ULL,
+        0xA8530886B54DBDEBULL, 0xD9F57F830283FDFCULL,
+        0xD267CAA862A12D66ULL, 0xD072DF63C324FD7BULL,
+        0x8380DEA93DA4BC60ULL, 0x4247CB9E59F71E6DULL,
+        0xA46116538D0DEB78ULL, 0x52D9BE85F074E608ULL,
+        0xCD795BE870516656ULL, 0x67902E276C921F8BULL,
+        0x806BD9714632DFF6ULL, 0x00BA1CD8A3DB53B6ULL,
+        0xA086CFCD97BF97F3ULL, 0x80E8A40ECCD228A4ULL,
+        0xC8A883C0FDAF7DF0ULL, 0x6122CD128006B2CDULL,
+        0xFAD2A4B13D1B5D6CULL, 0x796B805720085F81ULL,
+        0x9CC3A6EEC6311A63ULL, 0xCBE3303674053BB0ULL,
+        0xC3F490AA77BD60FCULL, 0xBEDBFC4411068A9CULL,
+        0xF4F1B4D515ACB93BULL, 0xEE92FB5515482D44ULL,
+        0x991711052D8BF3C5ULL, 0x751BDD152D4D1C4AULL,
+        0xBF5CD54678EEF0B6ULL, 0xD262D45A78A0635DULL,
+        0xEF340A98172AACE4ULL, 0x86FB897116C87C34ULL,
+        0x9580869F0E7AAC0EULL, 0xD45D35E6AE3D4DA0ULL,
+        0xBAE0A846D2195712ULL, 0x8974836059CCA109ULL,
+        0xE998D258869FACD7ULL, 0x2BD1A438703FC94BULL,
+        0x91FF83775423CC06ULL, 0x7B6306A34627DDCFULL,
+        0xB67F6455292CBF08ULL, 0x1A3BC84C17B1D542ULL,
+        0xE41F3D6A7377EECAULL, 0x20CABA5F1D9E4A93ULL,
+        0x8E938662882AF53EULL, 0x547EB47B7282EE9CULL,
+        0xB23867FB2A35B28DULL, 0xE99E619A4F23AA43ULL,
+        0xDEC681F9F4C31F31ULL, 0x6405FA00E2EC94D4ULL,
+        0x8B3C113C38F9F37EULL, 0xDE83BC408DD3DD04ULL,
+        0xAE0B158B4738705EULL, 0x9624AB50B148D445ULL,
+        0xD98DDAEE19068C76ULL, 0x3BADD624DD9B0957ULL,
+        0x87F8A8D4CFA417C9ULL, 0xE54CA5D70A80E5D6ULL,
+        0xA9F6D30A038D1DBCULL, 0x5E9FCF4CCD211F4CULL,
+        0xD47487CC8470652BULL, 0x7647C3200069671FULL,
+        0x84C8D4DFD2C63F3BULL, 0x29ECD9F40041E073ULL,
+        0xA5FB0A17C777CF09ULL, 0xF468107100525890ULL,
+        0xCF79CC9DB955C2CCULL, 0x7182148D4066EEB4ULL,
+        0x81AC1FE293D599BFULL, 0xC6F14CD848405530ULL,
+        0xA21727DB38CB002FULL, 0xB8ADA00E5A506A7CULL,
+        0xCA9CF1D206FDC03BULL, 0xA6D90811F0E4851CULL,
+        0xFD442E4688BD304AULL, 0x908F4A166D1DA663ULL,
+        0x9E4A9CEC15763E2EULL, 0x9A598E4E043287FEULL,
+        0xC5DD44271AD3CDBAULL, 0x40EFF1E1853F29FDULL,
+        0xF7549530E188C128ULL, 0xD12BEE59E68EF47CULL,
+        0x9A94DD3E8CF578B9ULL, 0x82BB74F8301958CEULL,
+        0xC13A148E3032D6E7ULL, 0xE36A52363C1FAF01ULL,
+        0xF18899B1BC3F8CA1ULL, 0xDC44E6C3CB279AC1ULL,
+        0x96F5600F15A7B7E5ULL, 0x29AB103A5EF8C0B9ULL,
+        0xBCB2B812DB11A5DEULL, 0x7415D448F6B6F0E7ULL,
+        0xEBDF661791D60F56ULL, 0x111B495B3464AD21ULL,
+        0x936B9FCEBB25C995ULL, 0xCAB10DD900BEEC34ULL,
+        0xB84687C269EF3BFBULL, 0x3D5D514F40EEA742ULL,
+        0xE65829B3046B0AFAULL, 0x0CB4A5A3112A5112ULL,
+        0x8FF71A0FE2C2E6DCULL, 0x47F0E785EABA72ABULL,
+        0xB3F4E093DB73A093ULL, 0x59ED216765690F56ULL,
+        0xE0F218B8D25088B8ULL, 0x306869C13EC3532CULL,
+        0x8C974F7383725573ULL, 0x1E414218C73A13FBULL,
+        0xAFBD2350644EEACFULL, 0xE5D1929EF90898FAULL,
+        0xDBAC6C247D62A583ULL, 0xDF45F746B74ABF39ULL,
+        0x894BC396CE5DA772ULL, 0x6B8BBA8C328EB783ULL,
+        0xAB9EB47C81F5114FULL, 0x066EA92F3F326564ULL,
+        0xD686619BA27255A2ULL, 0xC80A537B0EFEFEBDULL,
+        0x8613FD0145877585ULL, 0xBD06742CE95F5F36ULL,
+        0xA798FC4196E952E7ULL, 0x2C48113823B73704ULL,
+        0xD17F3B51FCA3A7A0ULL, 0xF75A15862CA504C5ULL,
+        0x82EF85133DE648C4ULL, 0x9A984D73DBE722FBULL,
+        0xA3AB66580D5FDAF5ULL, 0xC13E60D0D2E0EBBAULL,
+        0xCC963FEE10B7D1B3ULL, 0x318DF905079926A8ULL,
+        0xFFBBCFE994E5C61FULL, 0xFDF17746497F7052ULL,
+        0x9FD561F1FD0F9BD3ULL, 0xFEB6EA8BEDEFA633ULL,
+        0xC7CABA6E7C5382C8ULL, 0xFE64A52EE96B8FC0ULL,
+        0xF9BD690A1B68637BULL, 0x3DFDCE7AA3C673B0ULL,
+        0x9C1661A651213E2DULL, 0x06BEA10CA65C084EULL,
+        0xC31BFA0FE5698DB8ULL, 0x486E494FCFF30A62ULL,
+        0xF3E2F893DEC3F126ULL, 0x5A89DBA3C3EFCCFAULL,
+        0x986DDB5C6B3A76B7ULL, 0xF89629465A75E01CULL,
+        0xBE89523386091465ULL, 0xF6BBB397F1135823ULL,
+        0xEE2BA6C0678B597FULL, 0x746AA07DED582E2CULL,
+        0x94DB483840B717EFULL, 0xA8C2A44EB4571CDCULL,
+        0xBA121A4650E4DDEBULL, 0x92F34D62616CE413ULL,
+        0xE896A0D7E51E1566ULL, 0x77B020BAF9C81D17ULL,
+        0x915E2486EF32CD60ULL, 0x0ACE1474DC1D122EULL,
+        0xB5B5ADA8AAFF80B8ULL, 0x0D819992132456BAULL,
+        0xE3231912D5BF60E6ULL, 0x10E1FFF697ED6C69ULL,
+        0x8DF5EFABC5979C8FULL, 0xCA8D3FFA1EF463C1ULL,
+        0xB1736B96B6FD83B3ULL, 0xBD308FF8A6B17CB2ULL,
+        0xDDD0467C64BCE4A0ULL, 0xAC7CB3F6D05DDBDEULL,
+        0x8AA22C0DBEF60EE4ULL, 0x6BCDF07A423AA96BULL,
+        0xAD4AB7112EB3929DULL, 0x86C16C98D2C953C6ULL,
+        0xD89D64D57A607744ULL, 0xE871C7BF077BA8B7ULL,
+        0x87625F056C7C4A8BULL, 0x11471CD764AD4972ULL,
+        0xA93AF6C6C79B5D2DULL, 0xD598E40D3DD89BCFULL,
+        0xD389B47879823479ULL, 0x4AFF1D108D4EC2C3ULL,
+        0x843610CB4BF160CBULL, 0xCEDF722A585139BAULL,
+        0xA54394FE1EEDB8FEULL, 0xC2974EB4EE658828ULL,
+        0xCE947A3DA6A9273EULL, 0x733D226229FEEA32ULL,
+        0x811CCC668829B887ULL, 0x0806357D5A3F525FULL,
+        0xA163FF802A3426A8ULL, 0xCA07C2DCB0CF26F7ULL,
+        0xC9BCFF6034C13052ULL, 0xFC89B393DD02F0B5ULL,
+        0xFC2C3F3841F17C67ULL, 0xBBAC2078D443ACE2ULL,
+        0x9D9BA7832936EDC0ULL, 0xD54B944B84AA4C0DULL,
+        0xC5029163F384A931ULL, 0x0A9E795E65D4DF11ULL,
+        0xF64335BCF065D37DULL, 0x4D4617B5FF4A16D5ULL,
+        0x99EA0196163FA42EULL, 0x504BCED1BF8E4E45ULL,
+        0xC06481FB9BCF8D39ULL, 0xE45EC2862F71E1D6ULL,
+        0xF07DA27A82C37088ULL, 0x5D767327BB4E5A4CULL,
+        0x964E858C91BA2655ULL, 0x3A6A07F8D510F86FULL,
+        0xBBE226EFB628AFEAULL, 0x890489F70A55368BULL,
+        0xEADAB0ABA3B2DBE5ULL, 0x2B45AC74CCEA842EULL,
+        0x92C8AE6B464FC96FULL, 0x3B0B8BC90012929DULL,
+        0xB77ADA0617E3BBCBULL, 0x09CE6EBB40173744ULL,
+        0xE55990879DDCAABDULL, 0xCC420A6A101D0515ULL,
+        0x8F57FA54C2A9EAB6ULL, 0x9FA946824A12232DULL,
+        0xB32DF8E9F3546564ULL, 0x47939822DC96ABF9ULL,
+        0xDFF9772470297EBDULL, 0x59787E2B93BC56F7ULL,
+        0x8BFBEA76C619EF36ULL, 0x57EB4EDB3C55B65AULL,
+        0xAEFAE51477A06B03ULL, 0xEDE622920B6B23F1ULL,
+        0xDAB99E59958885C4ULL, 0xE95FAB368E45ECEDULL,
+        0x88B402F7FD75539BULL, 0x11DBCB0218EBB414ULL,
+        0xAAE103B5FCD2A881ULL, 0xD652BDC29F26A119ULL,
+        0xD59944A37C0752A2ULL, 0x4BE76D3346F0495FULL,
+        0x857FCAE62D8493A5ULL, 0x6F70A4400C562DDBULL,
+        0xA6DFBD9FB8E5B88EULL, 0xCB4CCD500F6BB952ULL,
+        0xD097AD07A71F26B2ULL, 0x7E2000A41346A7A7ULL,
+        0x825ECC24C873782FULL, 0x8ED400668C0C28C8ULL,
+        0xA2F67F2DFA90563BULL, 0x728900802F0F32FAULL,
+        0xCBB41EF979346BCAULL, 0x4F2B40A03AD2FFB9ULL,
+        0xFEA126B7D78186BCULL, 0xE2F610C84987BFA8ULL,
+        0x9F24B832E6B0F436ULL, 0x0DD9CA7D2DF4D7C9ULL,
+        0xC6EDE63FA05D3143ULL, 0x91503D1C79720DBBULL,
+        0xF8A95FCF88747D94ULL, 0x75A44C6397CE912AULL,
+        0x9B69DBE1B548CE7CULL, 0xC986AFBE3EE11ABAULL,
+        0xC24452DA229B021BULL, 0xFBE85BADCE996168ULL,
+        0xF2D56790AB41C2A2ULL, 0xFAE27299423FB9C3ULL,
+        0x97C560BA6B0919A5ULL, 0xDCCD879FC967D41AULL,
+        0xBDB6B8E905CB600FULL, 0x5400E987BBC1C920ULL,
+        0xED246723473E3813ULL, 0x290123E9AAB23B68ULL,
+        0x9436C0760C86E30BULL, 0xF9A0B6720AAF6521ULL,
+        0xB94470938FA89BCEULL, 0xF808E40E8D5B3E69ULL,
+        0xE7958CB87392C2C2ULL, 0xB60B1D1230B20E04ULL,
+        0x90BD77F3483BB9B9ULL, 0xB1C6F22B5E6F48C2ULL,
+        0xB4ECD5F01A4AA828ULL, 0x1E38AEB6360B1AF3ULL,
+        0xE2280B6C20DD5232ULL, 0x25C6DA63C38DE1B0ULL,
+        0x8D590723948A535FULL, 0x579C487E5A38AD0EULL,
+        0xB0AF48EC79ACE837ULL, 0x2D835A9DF0C6D851ULL,
+        0xDCDB1B2798182244ULL, 0xF8E431456CF88E65ULL,
+        0x8A08F0F8BF0F156BULL, 0x1B8E9ECB641B58FFULL,
+        0xAC8B2D36EED2DAC5ULL, 0xE272467E3D222F3FULL,
+        0xD7ADF884AA879177ULL, 0x5B0ED81DCC6ABB0FULL,
+        0x86CCBB52EA94BAEAULL, 0x98E947129FC2B4E9ULL,
+        0xA87FEA27A539E9A5ULL, 0x3F2398D747B36224ULL,
+        0xD29FE4B18E88640EULL, 0x8EEC7F0D19A03AADULL,
+        0x83A3EEEEF9153E89ULL, 0x1953CF68300424ACULL,
+        0xA48CEAAAB75A8E2BULL, 0x5FA8C3423C052DD7ULL,
+        0xCDB02555653131B6ULL, 0x3792F412CB06794DULL,
+        0x808E17555F3EBF11ULL, 0xE2BBD88BBEE40BD0ULL,
+        0xA0B19D2AB70E6ED6ULL, 0x5B6ACEAEAE9D0EC4ULL,
+        0xC8DE047564D20A8BULL, 0xF245825A5A445275ULL,
+        0xFB158592BE068D2EULL, 0xEED6E2F0F0D56712ULL,
+        0x9CED737BB6C4183DULL, 0x55464DD69685606BULL,
+        0xC428D05AA4751E4CULL, 0xAA97E14C3C26B886ULL,
+        0xF53304714D9265DFULL, 0xD53DD99F4B3066A8ULL,
+        0x993FE2C6D07B7FABULL, 0xE546A8038EFE4029ULL,
+        0xBF8FDB78849A5F96ULL, 0xDE98520472BDD033ULL,
+        0xEF73D256A5C0F77CULL, 0x963E66858F6D4440ULL,
+        0x95A8637627989AADULL, 0xDDE7001379A44AA8ULL,
+        0xBB127C53B17EC159ULL, 0x5560C018580D5D52ULL,
+        0xE9D71B689DDE71AFULL, 0xAAB8F01E6E10B4A6ULL,
+        0x9226712162AB070DULL, 0xCAB3961304CA70E8ULL,
+        0xB6B00D69BB55C8D1ULL, 0x3D607B97C5FD0D22ULL,
+        0xE45C10C42A2B3B05ULL, 0x8CB89A7DB77C506AULL,
+        0x8EB98A7A9A5B04E3ULL, 0x77F3608E92ADB242ULL,
+        0xB267ED1940F1C61CULL, 0x55F038B237591ED3ULL,
+        0xDF01E85F912E37A3ULL, 0x6B6C46DEC52F6688ULL,
+        0x8B61313BBABCE2C6ULL, 0x2323AC4B3B3DA015ULL,
+        0xAE397D8AA96C1B77ULL, 0xABEC975E0A0D081AULL,
+        0xD9C7DCED53C72255ULL, 0x96E7BD358C904A21ULL,
+        0x881CEA14545C7575ULL, 0x7E50D64177DA2E54ULL,
+        0xAA242499697392D2ULL, 0xDDE50BD1D5D0B9E9ULL,
+        0xD4AD2DBFC3D07787ULL, 0x955E4EC64B44E864ULL,
+        0x84EC3C97DA624AB4ULL, 0xBD5AF13BEF0B113EULL,
+        0xA6274BBDD0FADD61ULL, 0xECB1AD8AEACDD58EULL,
+        0xCFB11EAD453994BAULL, 0x67DE18EDA5814AF2ULL,
+        0x81CEB32C4B43FCF4ULL, 0x80EACF948770CED7ULL,
+        0xA2425FF75E14FC31ULL, 0xA1258379A94D028DULL,
+        0xCAD2F7F5359A3B3EULL, 0x096EE45813A04330ULL,
+        0xFD87B5F28300CA0DULL, 0x8BCA9D6E188853FCULL,
+        0x9E74D1B791E07E48ULL, 0x775EA264CF55347EULL,
+        0xC612062576589DDAULL, 0x95364AFE032A819EULL,
+        0xF79687AED3EEC551ULL, 0x3A83DDBD83F52205ULL,
+        0x9ABE14CD44753B52ULL, 0xC4926A9672793543ULL,
+        0xC16D9A0095928A27ULL, 0x75B7053C0F178294ULL,
+        0xF1C90080BAF72CB1ULL, 0x5324C68B12DD6339ULL,
+        0x971DA05074DA7BEEULL, 0xD3F6FC16EBCA5E04ULL,
+        0xBCE5086492111AEAULL, 0x88F4BB1CA6BCF585ULL,
+        0xEC1E4A7DB69561A5ULL, 0x2B31E9E3D06C32E6ULL,
+        0x9392EE8E921D5D07ULL, 0x3AFF322E62439FD0ULL,
+        0xB877AA3236A4B449ULL, 0x09BEFEB9FAD487C3ULL,
+        0xE69594BEC44DE15BULL, 0x4C2EBE687989A9B4ULL,
+        0x901D7CF73AB0ACD9ULL, 0x0F9D37014BF60A11ULL,
+        0xB424DC35095CD80FULL, 0x538484C19EF38C95ULL,
+        0xE12E13424BB40E13ULL, 0x2865A5F206B06FBAULL,
+        0x8CBCCC096F5088CBULL, 0xF93F87B7442E45D4ULL,
+        0xAFEBFF0BCB24AAFEULL, 0xF78F69A51539D749ULL,
+        0xDBE6FECEBDEDD5BEULL, 0xB573440E5A884D1CULL,
+        0x89705F4136B4A597ULL, 0x31680A88F8953031ULL,
+        0xABCC77118461CEFCULL, 0xFDC20D2B36BA7C3EULL,
+        0xD6BF94D5E57A42BCULL, 0x3D32907604691B4DULL,
+        0x8637BD05AF6C69B5ULL, 0xA63F9A49C2C1B110ULL,
+        0xA7C5AC471B478423ULL, 0x0FCF80DC33721D54ULL,
+        0xD1B71758E219652BULL, 0xD3C36113404EA4A9ULL,
+        0x83126E978D4FDF3BULL, 0x645A1CAC083126EAULL,
+        0xA3D70A3D70A3D70AULL, 0x3D70A3D70A3D70A4ULL,
+        0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCDULL,
+        0x8000000000000000ULL, 0x0000000000000000ULL,
+        0xA000000000000000ULL, 0x0000000000000000ULL,
+        0xC800000000000000ULL, 0x0000000000000000ULL,
+        0xFA00000000000000ULL, 0x0000000000000000ULL,
+        0x9C40000000000000ULL, 0x0000000000000000ULL,
+        0xC350000000000000ULL, 0x0000000000000000ULL,
+        0xF424000000000000ULL, 0x0000000000000000ULL,
+        0x9896800000000000ULL, 0x0000000000000000ULL,
+        0xBEBC200000000000ULL, 0x0000000000000000ULL,
+        0xEE6B280000000000ULL, 0x0000000000000000ULL,
+        0x9502F90000000000ULL, 0x0000000000000000ULL,
+        0xBA43B74000000000ULL, 0x0000000000000000ULL,
+        0xE8D4A51000000000ULL, 0x0000000000000000ULL,
+        0x9184E72A00000000ULL, 0x0000000000000000ULL,
+        0xB5E620F480000000ULL, 0x0000000000000000ULL,
+        0xE35FA931A0000000ULL, 0x0000000000000000ULL,
+        0x8E1BC9BF04000000ULL, 0x0000000000000000ULL,
+        0xB1A2BC2EC5000000ULL, 0x0000000000000000ULL,
+        0xDE0B6B3A76400000ULL, 0x0000000000000000ULL,
+        0x8AC7230489E80000ULL, 0x0000000000000000ULL,
+        0xAD78EBC5AC620000ULL, 0x0000000000000000ULL,
+        0xD8D726B7177A8000ULL, 0x0000000000000000ULL,
+        0x878678326EAC9000ULL, 0x0000000000000000ULL,
+        0xA968163F0A57B400ULL, 0x0000000000000000ULL,
+        0xD3C21BCECCEDA100ULL, 0x0000000000000000ULL,
+        0x84595161401484A0ULL, 0x0000000000000000ULL,
+        0xA56FA5B99019A5C8ULL, 0x0000000000000000ULL,
+        0xCECB8F27F4200F3AULL, 0x0000000000000000ULL,
+        0x813F3978F8940984ULL, 0x4000000000000000ULL,
+        0xA18F07D736B90BE5ULL, 0x5000000000000000ULL,
+        0xC9F2C9CD04674EDEULL, 0xA400000000000000ULL,
+        0xFC6F7C4045812296ULL, 0x4D00000000000000ULL,
+        0x9DC5ADA82B70B59DULL, 0xF020000000000000ULL,
+        0xC5371912364CE305ULL, 0x6C28000000000000ULL,
+        0xF684DF56C3E01BC6ULL, 0xC732000000000000ULL,
+        0x9A130B963A6C115CULL, 0x3C7F400000000000ULL,
+        0xC097CE7BC90715B3ULL, 0x4B9F100000000000ULL,
+        0xF0BDC21ABB48DB20ULL, 0x1E86D40000000000ULL,
+        0x96769950B50D88F4ULL, 0x1314448000000000ULL,
+        0xBC143FA4E250EB31ULL, 0x17D955A000000000ULL,
+        0xEB194F8E1AE525FDULL, 0x5DCFAB0800000000ULL,
+        0x92EFD1B8D0CF37BEULL, 0x5AA1CAE500000000ULL,
+        0xB7ABC627050305ADULL, 0xF14A3D9E40000000ULL,
+        0xE596B7B0C643C719ULL, 0x6D9CCD05D0000000ULL,
+        0x8F7E32CE7BEA5C6FULL, 0xE4820023A2000000ULL,
+        0xB35DBF821AE4F38BULL, 0xDDA2802C8A800000ULL,
+        0xE0352F62A19E306EULL, 0xD50B2037AD200000ULL,
+        0x8C213D9DA502DE45ULL, 0x4526F422CC340000ULL,
+        0xAF298D050E4395D6ULL, 0x9670B12B7F410000ULL,
+        0xDAF3F04651D47B4CULL, 0x3C0CDD765F114000ULL,
+        0x88D8762BF324CD0FULL, 0xA5880A69FB6AC800ULL,
+        0xAB0E93B6EFEE0053ULL, 0x8EEA0D047A457A00ULL,
+        0xD5D238A4ABE98068ULL, 0x72A4904598D6D880ULL,
+        0x85A36366EB71F041ULL, 0x47A6DA2B7F864750ULL,
+        0xA70C3C40A64E6C51ULL, 0x999090B65F67D924ULL,
+        0xD0CF4B50CFE20765ULL, 0xFFF4B4E3F741CF6DULL,
+        0x82818F1281ED449FULL, 0xBFF8F10E7A8921A4ULL,
+        0xA321F2D7226895C7ULL, 0xAFF72D52192B6A0DULL,
+        0xCBEA6F8CEB02BB39ULL, 0x9BF4F8A69F764490ULL,
+        0xFEE50B7025C36A08ULL, 0x02F236D04753D5B4ULL,
+        0x9F4F2726179A2245ULL, 0x01D762422C946590ULL,
+        0xC722F0EF9D80AAD6ULL, 0x424D3AD2B7B97EF5ULL,
+        0xF8EBAD2B84E0D58BULL, 0xD2E0898765A7DEB2ULL,
+        0x9B934C3B330C8577ULL, 0x63CC55F49F88EB2FULL,
+        0xC2781F49FFCFA6D5ULL, 0x3CBF6B71C76B25FBULL,
+        0xF316271C7FC3908AULL, 0x8BEF464E3945EF7AULL,
+        0x97EDD871CFDA3A56ULL, 0x97758BF0E3CBB5ACULL,
+        0xBDE94E8E43D0C8ECULL, 0x3D52EEED1CBEA317ULL,
+        0xED63A231D4C4FB27ULL, 0x4CA7AAA863EE4BDDULL,
+        0x945E455F24FB1CF8ULL, 0x8FE8CAA93E74EF6AULL,
+        0xB975D6B6EE39E436ULL, 0xB3E2FD538E122B44ULL,
+        0xE7D34C64A9C85D44ULL, 0x60DBBCA87196B616ULL,
+        0x90E40FBEEA1D3A4AULL, 0xBC8955E946FE31CDULL,
+        0xB51D13AEA4A488DDULL, 0x6BABAB6398BDBE41ULL,
+        0xE264589A4DCDAB14ULL, 0xC696963C7EED2DD1ULL,
+        0x8D7EB76070A08AECULL, 0xFC1E1DE5CF543CA2ULL,
+        0xB0DE65388CC8ADA8ULL, 0x3B25A55F43294BCBULL,
+        0xDD15FE86AFFAD912ULL, 0x49EF0EB713F39EBEULL,
+        0x8A2DBF142DFCC7ABULL, 0x6E3569326C784337ULL,
+        0xACB92ED9397BF996ULL, 0x49C2C37F07965404ULL,
+        0xD7E77A8F87DAF7FBULL, 0xDC33745EC97BE906ULL,
+        0x86F0AC99B4E8DAFDULL, 0x69A028BB3DED71A3ULL,
+        0xA8ACD7C0222311BCULL, 0xC40832EA0D68CE0CULL,
+        0xD2D80DB02AABD62BULL, 0xF50A3FA490C30190ULL,
+        0x83C7088E1AAB65DBULL, 0x792667C6DA79E0FAULL,
+        0xA4B8CAB1A1563F52ULL, 0x577001B891185938ULL,
+        0xCDE6FD5E09ABCF26ULL, 0xED4C0226B55E6F86ULL,
+        0x80B05E5AC60B6178ULL, 0x544F8158315B05B4ULL,
+        0xA0DC75F1778E39D6ULL, 0x696361AE3DB1C721ULL,
+        0xC913936DD571C84CULL, 0x03BC3A19CD1E38E9ULL,
+        0xFB5878494ACE3A5FULL, 0x04AB48A04065C723ULL,
+        0x9D174B2DCEC0E47BULL, 0x62EB0D64283F9C76ULL,
+        0xC45D1DF942711D9AULL, 0x3BA5D0BD324F8394ULL,
+        0xF5746577930D6500ULL, 0xCA8F44EC7EE36479ULL,
+        0x9968BF6ABBE85F20ULL, 0x7E998B13CF4E1ECBULL,
+        0xBFC2EF456AE276E8ULL, 0x9E3FEDD8C321A67EULL,
+        0xEFB3AB16C59B14A2ULL, 0xC5CFE94EF3EA101EULL,
+        0x95D04AEE3B80ECE5ULL, 0xBBA1F1D158724A12ULL,
+        0xBB445DA9CA61281FULL, 0x2A8A6E45AE8EDC97ULL,
+        0xEA1575143CF97226ULL, 0xF52D09D71A3293BDULL,
+        0x924D692CA61BE758ULL, 0x593C2626705F9C56ULL,
+        0xB6E0C377CFA2E12EULL, 0x6F8B2FB00C77836CULL,
+        0xE498F455C38B997AULL, 0x0B6DFB9C0F956447ULL,
+        0x8EDF98B59A373FECULL, 0x4724BD4189BD5EACULL,
+        0xB2977EE300C50FE7ULL, 0x58EDEC91EC2CB657ULL,
+        0xDF3D5E9BC0F653E1ULL, 0x2F2967B66737E3EDULL,
+        0x8B865B215899F46CULL, 0xBD79E0D20082EE74ULL,
+        0xAE67F1E9AEC07187ULL, 0xECD8590680A3AA11ULL,
+        0xDA01EE641A708DE9ULL, 0xE80E6F4820CC9495ULL,
+        0x884134FE908658B2ULL, 0x3109058D147FDCDDULL,
+        0xAA51823E34A7EEDEULL, 0xBD4B46F0599FD415ULL,
+        0xD4E5E2CDC1D1EA96ULL, 0x6C9E18AC7007C91AULL,
+        0x850FADC09923329EULL, 0x03E2CF6BC604DDB0ULL,
+        0xA6539930BF6BFF45ULL, 0x84DB8346B786151CULL,
+        0xCFE87F7CEF46FF16ULL, 0xE612641865679A63ULL,
+        0x81F14FAE158C5F6EULL, 0x4FCB7E8F3F60C07EULL,
+        0xA26DA3999AEF7749ULL, 0xE3BE5E330F38F09DULL,
+        0xCB090C8001AB551CULL, 0x5CADF5BFD3072CC5ULL,
+        0xFDCB4FA002162A63ULL, 0x73D9732FC7C8F7F6ULL,
+        0x9E9F11C4014DDA7EULL, 0x2867E7FDDCDD9AFAULL,
+        0xC646D63501A1511DULL, 0xB281E1FD541501B8ULL,
+        0xF7D88BC24209A565ULL, 0x1F225A7CA91A4226ULL,
+        0x9AE757596946075FULL, 0x3375788DE9B06958ULL,
+        0xC1A12D2FC3978937ULL, 0x0052D6B1641C83AEULL,
+        0xF209787BB47D6B84ULL, 0xC0678C5DBD23A49AULL,
+        0x9745EB4D50CE6332ULL, 0xF840B7BA963646E0ULL,
+        0xBD176620A501FBFFULL, 0xB650E5A93BC3D898ULL,
+        0xEC5D3FA8CE427AFFULL, 0xA3E51F138AB4CEBEULL,
+        0x93BA47C980E98CDFULL, 0xC66F336C36B10137ULL,
+        0xB8A8D9BBE123F017ULL, 0xB80B0047445D4184ULL,
+        0xE6D3102AD96CEC1DULL, 0xA60DC059157491E5ULL,
+        0x9043EA1AC7E41392ULL, 0x87C89837AD68DB2FULL,
+        0xB454E4A179DD1877ULL, 0x29BABE4598C311FBULL,
+        0xE16A1DC9D8545E94ULL, 0xF4296DD6FEF3D67AULL,
+        0x8CE2529E2734BB1DULL, 0x1899E4A65F58660CULL,
+        0xB01AE745B101E9E4ULL, 0x5EC05DCFF72E7F8FULL,
+        0xDC21A1171D42645DULL, 0x76707543F4FA1F73ULL,
+        0x899504AE72497EBAULL, 0x6A06494A791C53A8ULL,
+        0xABFA45DA0EDBDE69ULL, 0x0487DB9D17636892ULL,
+        0xD6F8D7509292D603ULL, 0x45A9D2845D3C42B6ULL,
+        0x865B86925B9BC5C2ULL, 0x0B8A2392BA45A9B2ULL,
+        0xA7F26836F282B732ULL, 0x8E6CAC7768D7141EULL,
+        0xD1EF0244AF2364FFULL, 0x3207D795430CD926ULL,
+        0x8335616AED761F1FULL, 0x7F44E6BD49E807B8ULL,
+        0xA402B9C5A8D3A6E7ULL, 0x5F16206C9C6209A6ULL,
+        0xCD036837130890A1ULL, 0x36DBA887C37A8C0FULL,
+        0x802221226BE55A64ULL, 0xC2494954DA2C9789ULL,
+        0xA02AA96B06DEB0FDULL, 0xF2DB9BAA10B7BD6CULL,
+        0xC83553C5C8965D3DULL, 0x6F92829494E5ACC7ULL,
+        0xFA42A8B73ABBF48CULL, 0xCB772339BA1F17F9ULL,
+        0x9C69A97284B578D7ULL, 0xFF2A760414536EFBULL,
+        0xC38413CF25E2D70DULL, 0xFEF5138519684ABAULL,
+        0xF46518C2EF5B8CD1ULL, 0x7EB258665FC25D69ULL,
+        0x98BF2F79D5993802ULL, 0xEF2F773FFBD97A61ULL,
+        0xBEEEFB584AFF8603ULL, 0xAAFB550FFACFD8FAULL,
+        0xEEAABA2E5DBF6784ULL, 0x95BA2A53F983CF38ULL,
+        0x952AB45CFA97A0B2ULL, 0xDD945A747BF26183ULL,
+        0xBA756174393D88DFULL, 0x94F971119AEEF9E4ULL,
+        0xE912B9D1478CEB17ULL, 0x7A37CD5601AAB85DULL,
+        0x91ABB422CCB812EEULL, 0xAC62E055C10AB33AULL,
+        0xB616A12B7FE617AAULL, 0x577B986B314D6009ULL,
+        0xE39C49765FDF9D94ULL, 0xED5A7E85FDA0B80BULL,
+        0x8E41ADE9FBEBC27DULL, 0x14588F13BE847307ULL,
+        0xB1D219647AE6B31CULL, 0x596EB2D8AE258FC8ULL,
+        0xDE469FBD99A05FE3ULL, 0x6FCA5F8ED9AEF3BBULL,
+        0x8AEC23D680043BEEULL, 0x25DE7BB9480D5854ULL,
+        0xADA72CCC20054AE9ULL, 0xAF561AA79A10AE6AULL,
+        0xD910F7FF28069DA4ULL, 0x1B2BA1518094DA04ULL,
+        0x87AA9AFF79042286ULL, 0x90FB44D2F05D0842ULL,
+        0xA99541BF57452B28ULL, 0x353A1607AC744A53ULL,
+        0xD3FA922F2D1675F2ULL, 0x42889B8997915CE8ULL,
+        0x847C9B5D7C2E09B7ULL, 0x69956135FEBADA11ULL,
+        0xA59BC234DB398C25ULL, 0x43FAB9837E699095ULL,
+        0xCF02B2C21207EF2EULL, 0x94F967E45E03F4BBULL,
+        0x8161AFB94B44F57DULL, 0x1D1BE0EEBAC278F5ULL,
+        0xA1BA1BA79E1632DCULL, 0x6462D92A69731732ULL,
+        0xCA28A291859BBF93ULL, 0x7D7B8F7503CFDCFEULL,
+        0xFCB2CB35E702AF78ULL, 0x5CDA735244C3D43EULL,
+        0x9DEFBF01B061ADABULL, 0x3A0888136AFA64A7ULL,
+        0xC56BAEC21C7A1916ULL, 0x088AAA1845B8FDD0ULL,
+        0xF6C69A72A3989F5BULL, 0x8AAD549E57273D45ULL,
+        0x9A3C2087A63F6399ULL, 0x36AC54E2F678864BULL,
+        0xC0CB28A98FCF3C7FULL, 0x84576A1BB416A7DDULL,
+        0xF0FDF2D3F3C30B9FULL, 0x656D44A2A11C51D5ULL,
+        0x969EB7C47859E743ULL, 0x9F644AE5A4B1B325ULL,
+        0xBC4665B596706114ULL, 0x873D5D9F0DDE1FEEULL,
+        0xEB57FF22FC0C7959ULL, 0xA90CB506D155A7EAULL,
+        0x9316FF75DD87CBD8ULL, 0x09A7F12442D588F2ULL,
+        0xB7DCBF5354E9BECEULL, 0x0C11ED6D538AEB2FULL,
+        0xE5D3EF282A242E81ULL, 0x8F1668C8A86DA5FAULL,
+        0x8FA475791A569D10ULL, 0xF96E017D694487BCULL,
+        0xB38D92D760EC4455ULL, 0x37C981DCC395A9ACULL,
+        0xE070F78D3927556AULL, 0x85BBE253F47B1417ULL,
+        0x8C469AB843B89562ULL, 0x93956D7478CCEC8EULL,
+        0xAF58416654A6BABBULL, 0x387AC8D1970027B2ULL,
+        0xDB2E51BFE9D0696AULL, 0x06997B05FCC0319EULL,
+        0x88FCF317F22241E2ULL, 0x441FECE3BDF81F03ULL,
+        0xAB3C2FDDEEAAD25AULL, 0xD527E81CAD7626C3ULL,
+        0xD60B3BD56A5586F1ULL, 0x8A71E223D8D3B074ULL,
+        0x85C7056562757456ULL, 0xF6872D5667844E49ULL,
+        0xA738C6BEBB12D16CULL, 0xB428F8AC016561DBULL,
+        0xD106F86E69D785C7ULL, 0xE13336D701BEBA52ULL,
+        0x82A45B450226B39CULL, 0xECC0024661173473ULL,
+        0xA34D721642B06084ULL, 0x27F002D7F95D0190ULL,
+        0xCC20CE9BD35C78A5ULL, 0x31EC038DF7B441F4ULL,
+        0xFF290242C83396CEULL, 0x7E67047175A15271ULL,
+        0x9F79A169BD203E41ULL, 0x0F0062C6E984D386ULL,
+        0xC75809C42C684DD1ULL, 0x52C07B78A3E60868ULL,
+        0xF92E0C3537826145ULL, 0xA7709A56CCDF8A82ULL,
+        0x9BBCC7A142B17CCBULL, 0x88A66076400BB691ULL,
+        0xC2ABF989935DDBFEULL, 0x6ACFF893D00EA435ULL,
+        0xF356F7EBF83552FEULL, 0x0583F6B8C4124D43ULL,
+        0x98165AF37B2153DEULL, 0xC3727A337A8B704AULL,
+        0xBE1BF1B059E9A8D6ULL, 0x744F18C0592E4C5CULL,
+        0xEDA2EE1C7064130CULL, 0x1162DEF06F79DF73ULL,
+        0x9485D4D1C63E8BE7ULL, 0x8ADDCB5645AC2BA8ULL,
+        0xB9A74A0637CE2EE1ULL, 0x6D953E2BD7173692ULL,
+        0xE8111C87C5C1BA99ULL, 0xC8FA8DB6CCDD0437ULL,
+        0x910AB1D4DB9914A0ULL, 0x1D9C9892400A22A2ULL,
+        0xB54D5E4A127F59C8ULL, 0x2503BEB6D00CAB4BULL,
+        0xE2A0B5DC971F303AULL, 0x2E44AE64840FD61DULL,
+        0x8DA471A9DE737E24ULL, 0x5CEAECFED289E5D2ULL,
+        0xB10D8E1456105DADULL, 0x7425A83E872C5F47ULL,
+        0xDD50F1996B947518ULL, 0xD12F124E28F77719ULL,
+        0x8A5296FFE33CC92FULL, 0x82BD6B70D99AAA6FULL,
+        0xACE73CBFDC0BFB7BULL, 0x636CC64D1001550BULL,
+        0xD8210BEFD30EFA5AULL, 0x3C47F7E05401AA4EULL,
+        0x8714A775E3E95C78ULL, 0x65ACFAEC34810A71ULL,
+        0xA8D9D1535CE3B396ULL, 0x7F1839A741A14D0DULL,
+        0xD31045A8341CA07CULL, 0x1EDE48111209A050ULL,
+        0x83EA2B892091E44DULL, 0x934AED0AAB460432ULL,
+        0xA4E4B66B68B65D60ULL, 0xF81DA84D5617853FULL,
+        0xCE1DE40642E3F4B9ULL, 0x36251260AB9D668EULL,
+        0x80D2AE83E9CE78F3ULL, 0xC1D72B7C6B426019ULL,
+        0xA1075A24E4421730ULL, 0xB24CF65B8612F81FULL,
+        0xC94930AE1D529CFCULL, 0xDEE033F26797B627ULL,
+        0xFB9B7CD9A4A7443CULL, 0x169840EF017DA3B1ULL,
+        0x9D412E0806E88AA5ULL, 0x8E1F289560EE864EULL,
+        0xC491798A08A2AD4EULL, 0xF1A6F2BAB92A27E2ULL,
+        0xF5B5D7EC8ACB58A2ULL, 0xAE10AF696774B1DBULL,
+        0x9991A6F3D6BF1765ULL, 0xACCA6DA1E0A8EF29ULL,
+        0xBFF610B0CC6EDD3FULL, 0x17FD090A58D32AF3ULL,
+        0xEFF394DCFF8A948EULL, 0xDDFC4B4CEF07F5B0ULL,
+        0x95F83D0A1FB69CD9ULL, 0x4ABDAF101564F98EULL,
+        0xBB764C4CA7A4440FULL, 0x9D6D1AD41ABE37F1ULL,
+        0xEA53DF5FD18D5513ULL, 0x84C86189216DC5EDULL,
+        0x92746B9BE2F8552CULL, 0x32FD3CF5B4E49BB4ULL,
+        0xB7118682DBB66A77ULL, 0x3FBC8C33221DC2A1ULL,
+        0xE4D5E82392A40515ULL, 0x0FABAF3FEAA5334AULL,
+        0x8F05B1163BA6832DULL, 0x29CB4D87F2A7400EULL,
+        0xB2C71D5BCA9023F8ULL, 0x743E20E9EF511012ULL,
+        0xDF78E4B2BD342CF6ULL, 0x914DA9246B255416ULL,
+        0x8BAB8EEFB6409C1AULL, 0x1AD089B6C2F7548EULL,
+        0xAE9672ABA3D0C320ULL, 0xA184AC2473B529B1ULL,
+        0xDA3C0F568CC4F3E8ULL, 0xC9E5D72D90A2741EULL,
+        0x8865899617FB1871ULL, 0x7E2FA67C7A658892ULL,
+        0xAA7EEBFB9DF9DE8DULL, 0xDDBB901B98FEEAB7ULL,
+        0xD51EA6FA85785631ULL, 0x552A74227F3EA565ULL,
+        0x8533285C936B35DEULL, 0xD53A88958F87275FULL,
+        0xA67FF273B8460356ULL, 0x8A892ABAF368F137ULL,
+        0xD01FEF10A657842CULL, 0x2D2B7569B0432D85ULL,
+        0x8213F56A67F6B29BULL, 0x9C3B29620E29FC73ULL,
+        0xA298F2C501F45F42ULL, 0x8349F3BA91B47B8FULL,
+        0xCB3F2F7642717713ULL, 0x241C70A936219A73ULL,
+        0xFE0EFB53D30DD4D7ULL, 0xED238CD383AA0110ULL,
+        0x9EC95D1463E8A506ULL, 0xF4363804324A40AAULL,
+        0xC67BB4597CE2CE48ULL, 0xB143C6053EDCD0D5ULL,
+        0xF81AA16FDC1B81DAULL, 0xDD94B7868E94050AULL,
+        0x9B10A4E5E9913128ULL, 0xCA7CF2B4191C8326ULL,
+        0xC1D4CE1F63F57D72ULL, 0xFD1C2F611F63A3F0ULL,
+        0xF24A01A73CF2DCCFULL, 0xBC633B39673C8CECULL,
+        0x976E41088617CA01ULL, 0xD5BE0503E085D813ULL,
+        0xBD49D14AA79DBC82ULL, 0x4B2D8644D8A74E18ULL,
+        0xEC9C459D51852BA2ULL, 0xDDF8E7D60ED1219EULL,
+        0x93E1AB8252F33B45ULL, 0xCABB90E5C942B503ULL,
+        0xB8DA1662E7B00A17ULL, 0x3D6A751F3B936243ULL,
+        0xE7109BFBA19C0C9DULL, 0x0CC512670A783AD4ULL,
+        0x906A617D450187E2ULL, 0x27FB2B80668B24C5ULL,
+        0xB484F9DC9641E9DAULL, 0xB1F9F660802DEDF6ULL,
+        0xE1A63853BBD26451ULL, 0x5E7873F8A0396973ULL,
+        0x8D07E33455637EB2ULL, 0xDB0B487B6423E1E8ULL,
+        0xB049DC016ABC5E5FULL, 0x91CE1A9A3D2CDA62ULL,
+        0xDC5C5301C56B75F7ULL, 0x7641A140CC7810FBULL,
+        0x89B9B3E11B6329BAULL, 0xA9E904C87FCB0A9DULL,
+        0xAC2820D9623BF429ULL, 0x546345FA9FBDCD44ULL,
+        0xD732290FBACAF133ULL, 0xA97C177947AD4095ULL,
+        0x867F59A9D4BED6C0ULL, 0x49ED8EABCCCC485DULL,
+        0xA81F301449EE8C70ULL, 0x5C68F256BFFF5A74ULL,
+        0xD226FC195C6A2F8CULL, 0x73832EEC6FFF3111ULL,
+        0x83585D8FD9C25DB7ULL, 0xC831FD53C5FF7EABULL,
+        0xA42E74F3D032F525ULL, 0xBA3E7CA8B77F5E55ULL,
+        0xCD3A1230C43FB26FULL, 0x28CE1BD2E55F35EBULL,
+        0x80444B5E7AA7CF85ULL, 0x7980D163CF5B81B3ULL,
+        0xA0555E361951C366ULL, 0xD7E105BCC332621FULL,
+        0xC86AB5C39FA63440ULL, 0x8DD9472BF3FEFAA7ULL,
+        0xFA856334878FC150ULL, 0xB14F98F6F0FEB951ULL,
+        0x9C935E00D4B9D8D2ULL, 0x6ED1BF9A569F33D3ULL,
+        0xC3B8358109E84F07ULL, 0x0A862F80EC4700C8ULL,
+        0xF4A642E14C6262C8ULL, 0xCD27BB612758C0FAULL,
+        0x98E7E9CCCFBD7DBDULL, 0x8038D51CB897789CULL,
+        0xBF21E44003ACDD2CULL, 0xE0470A63E6BD56C3ULL,
+        0xEEEA5D5004981478ULL, 0x1858CCFCE06CAC74ULL,
+        0x95527A5202DF0CCBULL, 0x0F37801E0C43EBC8ULL,
+        0xBAA718E68396CFFDULL, 0xD30560258F54E6BAULL,
+        0xE950DF20247C83FDULL, 0x47C6B82EF32A2069ULL,
+        0x91D28B7416CDD27EULL, 0x4CDC331D57FA5441ULL,
+        0xB6472E511C81471DULL, 0xE0133FE4ADF8E952ULL,
+        0xE3D8F9E563A198E5ULL, 0x58180FDDD97723A6ULL,
+        0x8E679C2F5E44FF8FULL, 0x570F09EAA7EA7648ULL,
+        0xB201833B35D63F73ULL, 0x2CD2CC6551E513DAULL,
+        0xDE81E40A034BCF4FULL, 0xF8077F7EA65E58D1ULL,
+        0x8B112E86420F6191ULL, 0xFB04AFAF27FAF782ULL,
+        0xADD57A27D29339F6ULL, 0x79C5DB9AF1F9B563ULL,
+        0xD94AD8B1C7380874ULL, 0x18375281AE7822BCULL,
+        0x87CEC76F1C830548ULL, 0x8F2293910D0B15B5ULL,
+        0xA9C2794AE3A3C69AULL, 0xB2EB3875504DDB22ULL,
+        0xD433179D9C8CB841ULL, 0x5FA60692A46151EBULL,
+        0x849FEEC281D7F328ULL, 0xDBC7C41BA6BCD333ULL,
+        0xA5C7EA73224DEFF3ULL, 0x12B9B522906C0800ULL,
+        0xCF39E50FEAE16BEFULL, 0xD768226B34870A00ULL,
+        0x81842F29F2CCE375ULL, 0xE6A1158300D46640ULL,
+        0xA1E53AF46F801C53ULL, 0x60495AE3C1097FD0ULL,
+        0xCA5E89B18B602368ULL, 0x385BB19CB14BDFC4ULL,
+        0xFCF62C1DEE382C42ULL, 0x46729E03DD9ED7B5ULL,
+        0x9E19DB92B4E31BA9ULL, 0x6C07A2C26A8346D1ULL,
+        0xC5A05277621BE293ULL, 0xC7098B7305241885ULL,
+        0xF70867153AA2DB38ULL, 0xB8CBEE4FC66D1EA7ULL,
+    };
+
+    // Left shift cheats for json_decimal: digits added by a shift of k bits, one less if the digits are below 5^k
+    static const struct
+    {
+        int32_t     delta;              // New digits
+        const char* cutoff;             // 5^k
+    } json_decimal_left_cheats[] =
+    {
+        { 0, "" },
+        { 1, "5" },
+        { 1, "25" },
+        { 1, "125" },
+        { 2, "625" },
+        { 2, "3125" },
+        { 2, "15625" },
+        { 3, "78125" },
+        { 3, "390625" },
+        { 3, "1953125" },
+        { 4, "9765625" },
+        { 4, "48828125" },
+        { 4, "244140625" },
+        { 4, "1220703125" },
+        { 5, "6103515625" },
+        { 5, "30517578125" },
+        { 5, "152587890625" },
+        { 6, "762939453125" },
+        { 6, "3814697265625" },
+        { 6, "19073486328125" },
+        { 7, "95367431640625" },
+        { 7, "476837158203125" },
+        { 7, "2384185791015625" },
+        { 7, "11920928955078125" },
+        { 8, "59604644775390625" },
+        { 8, "298023223876953125" },
+        { 8, "1490116119384765625" },
+        { 9, "7450580596923828125" },
+        { 9, "37252902984619140625" },
+        { 9, "186264514923095703125" },
+        { 10, "931322574615478515625" },
+        { 10, "4656612873077392578125" },
+        { 10, "23283064365386962890625" },
+        { 10, "116415321826934814453125" },
+        { 11, "582076609134674072265625" },
+        { 11, "2910383045673370361328125" },
+        { 11, "14551915228366851806640625" },
+        { 12, "72759576141834259033203125" },
+        { 12, "363797880709171295166015625" },
+        { 12, "1818989403545856475830078125" },
+        { 13, "9094947017729282379150390625" },
+        { 13, "45474735088646411895751953125" },
+        { 13, "227373675443232059478759765625" },
+        { 13, "1136868377216160297393798828125" },
+        { 14, "5684341886080801486968994140625" },
+        { 14, "28421709430404007434844970703125" },
+        { 14, "142108547152020037174224853515625" },
+        { 15, "710542735760100185871124267578125" },
+        { 15, "3552713678800500929355621337890625" },
+        { 15, "17763568394002504646778106689453125" },
+        { 16, "88817841970012523233890533447265625" },
+        { 16, "444089209850062616169452667236328125" },
+        { 16, "2220446049250313080847263336181640625" },
+        { 16, "11102230246251565404236316680908203125" },
+        { 17, "55511151231257827021181583404541015625" },
+        { 17, "277555756156289135105907917022705078125" },
+        { 17, "1387778780781445675529539585113525390625" },
+        { 18, "6938893903907228377647697925567626953125" },
+        { 18, "34694469519536141888238489627838134765625" },
+        { 18, "173472347597680709441192448139190673828125" },
+        { 19, "867361737988403547205962240695953369140625" },
+    };
+
+    // Decimal with up to 800 digits, used when the fast paths can not round correctly
+    struct json_decimal
+    {
+        char        digits[800];        // Digits '0' - '9', most significant first
+        int32_t     count;              // Digit count
+        int32_t     point;              // Decimal point position
+        bool        truncated;          // Nonzero digits were dropped
+    };
+
+    static const int32_t json_decimal_max_shift = 60;
+
+    inline uint64_t _json_umul128(uint64_t a, uint64_t b, uint64_t* high_ptr)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return _umul128(a, b, high_ptr);
+#elif defined(__SIZEOF_INT128__)
+        unsigned __int128 product = (unsigned __int128)a * b;
+        *high_ptr = (uint64_t)(product >> 64);
+        return (uint64_t)product;
+#else
+        uint64_t a_low = (uint32_t)a;
+        uint64_t a_high = a >> 32;
+        uint64_t b_low = (uint32_t)b;
+        uint64_t b_high = b >> 32;
+        uint64_t low_low = a_low * b_low;
+        uint64_t high_low = a_high * b_low;
+        uint64_t low_high = a_low * b_high;
+        uint64_t cross = (low_low >> 32) + (uint32_t)high_low + low_high;
+        *high_ptr = (high_low >> 32) + (cross >> 32) + a_high * b_high;
+        return (cross << 32) | (uint32_t)low_low;
+#endif
+    }
+
+    // Eisel-Lemire: w * 10^q (w > 0) rounded to the nearest double, false if the product is too close to call
+    static bool _eisel_lemire(int64_t q, uint64_t w, uint64_t* bits_ptr)
+    {
+        const int32_t mantissa_bits = 52;
+
+        if (q < -342)
+        {
+            *bits_ptr = 0;
+            return true;
+        }
+
+        if (q > 308)
+        {
+            *bits_ptr = 0x7FF0000000000000ULL;
+            return true;
+        }
+
+        int32_t leading_zeros = (int32_t)_json_clz64(w);
+        w <<= leading_zeros;
+
+        const uint64_t* power_ptr = json_power_of_five_128 + 2 * (q + 342);
+        uint64_t high = 0;
+        uint64_t low = _json_umul128(w, power_ptr[0], &high);
+
+        // The ignored low bits of the power may carry into the mantissa
+        if (0x1FF == (high & 0x1FF))
+        {
+            uint64_t second_high = 0;
+            _json_umul128(w, power_ptr[1], &second_high);
+            low += second_high;
+            if (second_high > low)
+            {
+                high++;
+            }
+
+            if (UINT64_MAX == low && (q < -27 || q > 55))
+            {
+                return false;
+            }
+        }
+
+        int32_t upper_bit = (int32_t)(high >> 63);
+        int32_t shift = upper_bit + 64 - mantissa_bits - 3;
+        uint64_t mantissa = high >> shift;
+        int32_t power2 = (int32_t)(((217706 * q) >> 16) + 63 + upper_bit - leading_zeros + 1023);
+
+        // Subnormal
+        if (power2 <= 0)
+        {
+            if (-power2 + 1 >= 64)
+            {
+                *bits_ptr = 0;
+                return true;
+            }
+
+            mantissa >>= -power2 + 1;
+            mantissa += mantissa & 1;
+            mantissa >>= 1;
+            power2 = mantissa < ((uint64_t)1 << mantissa_bits) ? 0 : 1;
+            *bits_ptr = mantissa | ((uint64_t)power2 << mantissa_bits);
+            return true;
+        }
+
+        // Exactly halfway between two doubles, round to even
+        if (low <= 1 && q >= -4 && q <= 23 && 1 == (mantissa & 3))
+        {
+            if ((mantissa << shift) == high)
+            {
+                mantissa &= ~(uint64_t)1;
+            }
+        }
+
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        if (mantissa >= ((uint64_t)2 << mantissa_bits))
+        {
+            mantissa = (uint64_t)1 << mantissa_bits;
+            power2++;
+        }
+
+        mantissa &= ~((uint64_t)1 << mantissa_bits);
+        if (power2 >= 0x7FF)
+        {
+            *bits_ptr = 0x7FF0000000000000ULL;
+            return true;
+        }
+
+        *bits_ptr = mantissa | ((uint64_t)power2 << mantissa_bits);
+        return true;
+    }
+
+    static void _decimal_trim(json_decimal& dec)
+    {
+        while (dec.count > 0 && '0' == dec.digits[dec.count - 1])
+        {
+            dec.count--;
+        }
+
+        if (0 == dec.count)
+        {
+            dec.point = 0;
+        }
+    }
+
+    // Divide by 2^k, k <= json_decimal_max_shift
+    static void _decimal_right_shift(json_decimal& dec, int32_t k)
+    {
+        int32_t read_pos = 0;
+        int32_t write_pos = 0;
+        uint64_t n = 0;
+
+        // Pick up enough leading digits for the first output digit
+        for (; 0 == (n >> k); read_pos++)
+        {
+            if (read_pos >= dec.count)
+            {
+                if (0 == n)
+                {
+                    dec.count = 0;
+                    return;
+                }
+
+                while (0 == (n >> k))
+                {
+                    n = n * 10;
+                    read_pos++;
+                }
+                break;
+            }
+
+            n = n * 10 + (uint64_t)(dec.digits[read_pos] - '0');
+        }
+
+        dec.point -= read_pos - 1;
+
+        uint64_t mask = ((uint64_t)1 << k) - 1;
+        for (; read_pos < dec.count; read_pos++)
+        {
+            uint64_t digit = n >> k;
+            n &= mask;
+            dec.digits[write_pos++] = (char)('0' + digit);
+            n = n * 10 + (uint64_t)(dec.digits[read_pos] - '0');
+        }
+
+        while (n > 0)
+        {
+            uint64_t digit = n >> k;
+            n &= mask;
+            if (write_pos < (int32_t)sizeof(dec.digits))
+            {
+                dec.digits[write_pos++] = (char)('0' + digit);
+            }
+            else if (digit > 0)
+            {
+                dec.truncated = true;
+            }
+            n = n * 10;
+        }
+
+        dec.count = write_pos;
+        _decimal_trim(dec);
+    }
+
+    // Multiply by 2^k, k <= json_decimal_max_shift
+    static void _decimal_left_shift(json_decimal& dec, int32_t k)
+    {
+        int32_t delta = json_decimal_left_cheats[k].delta;
+        const char* cutoff = json_decimal_left_cheats[k].cutoff;
+
+        for (int32_t i = 0; '\0' != cutoff[i]; i++)
+        {
+            if (i >= dec.count)
+            {
+                delta--;
+                break;
+            }
+
+            if (dec.digits[i] != cutoff[i])
+            {
+                if (dec.digits[i] < cutoff[i])
+                {
+                    delta--;
+                }
+                break;
+            }
+        }
+
+        int32_t read_pos = dec.count - 1;
+        int32_t write_pos = dec.count + delta;
+        uint64_t n = 0;
+
+        for (; read_pos >= 0; read_pos--)
+        {
+            n += (uint64_t)(dec.digits[read_pos] - '0') << k;
+            uint64_t quotient = n / 10;
+            uint64_t remainder = n - 10 * quotient;
+            write_pos--;
+            if (write_pos < (int32_t)sizeof(dec.digits))
+            {
+                dec.digits[write_pos] = (char)('0' + remainder);
+            }
+            else if (0 != remainder)
+            {
+                dec.truncated = true;
+            }
+            n = quotient;
+        }
+
+        while (n > 0)
+        {
+            uint64_t quotient = n / 10;
+            uint64_t remainder = n - 10 * quotient;
+            write_pos--;
+            if (write_pos < (int32_t)sizeof(dec.digits))
+            {
+                dec.digits[write_pos] = (char)('0' + remainder);
+            }
+            else if (0 != remainder)
+            {
+                dec.truncated = true;
+            }
+            n = quotient;
+        }
+
+        dec.count += delta;
+        if (dec.count >= (int32_t)sizeof(dec.digits))
+        {
+            dec.count = (int32_t)sizeof(dec.digits);
+        }
+
+        dec.point += delta;
+        _decimal_trim(dec);
+    }
+
+    static void _decimal_shift(json_decimal& dec, int32_t k)
+    {
+        if (0 == dec.count)
+        {
+            return;
+        }
+
+        if (k > 0)
+        {
+            for (; k > json_decimal_max_shift; k -= json_decimal_max_shift)
+            {
+                _decimal_left_shift(dec, json_decimal_max_shift);
+            }
+            _decimal_left_shift(dec, k);
+        }
+        else if (k < 0)
+        {
+            for (; k < -json_decimal_max_shift; k += json_decimal_max_shift)
+            {
+                _decimal_right_shift(dec, json_decimal_max_shift);
+            }
+            _decimal_right_shift(dec, -k);
+        }
+    }
+
+    // Integer part, rounded half to even
+    static uint64_t _decimal_rounded_integer(const json_decimal& dec)
+    {
+        uint64_t n = 0;
+        int32_t i = 0;
+
+        if (dec.point > 20)
+        {
+            return UINT64_MAX;
+        }
+
+        for (; i < dec.point && i < dec.count; i++)
+        {
+            n = n * 10 + (uint64_t)(dec.digits[i] - '0');
+        }
+
+        for (; i < dec.point; i++)
+        {
+            n *= 10;
+        }
+
+        if (dec.point >= 0 && dec.point < dec.count)
+        {
+            char ch = dec.digits[dec.point];
+            if ('5' == ch && dec.point + 1 == dec.count)
+            {
+                if (dec.truncated || (dec.point > 0 && 0 != ((dec.digits[dec.point - 1] - '0') & 1)))
+                {
+                    n++;
+                }
+            }
+            else if (ch >= '5')
+            {
+                n++;
+            }
+        }
+
+        return n;
+    }
+
+    // Digits and decimal point of a JSON number
+    static void _decimal_assign(json_decimal& dec, const _tchar* data_ptr, const _tchar* data_end)
+    {
+        int32_t digit_total = 0;
+        bool flag_dot = false;
+
+        dec.count = 0;
+        dec.point = 0;
+        dec.truncated = false;
+
+        if (data_ptr < data_end && _T('-') == *data_ptr)
+        {
+            data_ptr++;
+        }
+
+        for (; data_ptr < data_end; data_ptr++)
+        {
+            _tchar ch = *data_ptr;
+            if (_T('.') == ch)
+            {
+                flag_dot = true;
+                dec.point = digit_total;
+                continue;
+            }
+
+            if (ch < _T('0') || ch > _T('9'))
+            {
+                break;
+            }
+
+            // Leading zeros only move the decimal point
+            if (_T('0') == ch && 0 == dec.count)
+            {
+                dec.point--;
+                continue;
+            }
+
+            digit_total++;
+            if (dec.count < (int32_t)sizeof(dec.digits))
+            {
+                dec.digits[dec.count++] = (char)ch;
+            }
+            else if (_T('0') != ch)
+            {
+                dec.truncated = true;
+            }
+        }
+
+        if (!flag_dot)
+        {
+            dec.point = digit_total;
+        }
+
+        if (data_ptr < data_end && (_T('e') == *data_ptr || _T('E') == *data_ptr))
+        {
+            int32_t exp_sign = 1;
+            int32_t exp_value = 0;
+
+            data_ptr++;
+            if (data_ptr < data_end && (_T('-') == *data_ptr || _T('+') == *data_ptr))
+            {
+                exp_sign = _T('-') == *data_ptr ? -1 : 1;
+                data_ptr++;
+            }
+
+            for (; data_ptr < data_end && *data_ptr >= _T('0') && *data_ptr <= _T('9'); data_ptr++)
+            {
+                if (exp_value < 10000)
+                {
+                    exp_value = exp_value * 10 + (int32_t)(*data_ptr - _T('0'));
+                }
+            }
+
+            dec.point += exp_sign * exp_value;
+        }
+    }
+
+    static uint64_t _decimal_to_double_bits(json_decimal& dec)
+    {
+        static const int32_t power_table[] = { 1, 3, 6, 9, 13, 16, 19, 23, 26 };
+        const int32_t mantissa_bits = 52;
+        const int32_t bias = -1023;
+        const uint64_t infinity_bits = 0x7FF0000000000000ULL;
+        int32_t exp2 = 0;
+
+        if (0 == dec.count || dec.point < -330)
+        {
+            return 0;
+        }
+
+        if (dec.point > 310)
+        {
+            return infinity_bits;
+        }
+
+        // Scale by powers of two into [0.5, 1)
+        while (dec.point > 0)
+        {
+            int32_t n = dec.point >= 9 ? 27 : power_table[dec.point];
+            _decimal_shift(dec, -n);
+            exp2 += n;
+        }
+
+        while (dec.point < 0 || (0 == dec.point && dec.digits[0] < '5'))
+        {
+            int32_t n = -dec.point >= 9 ? 27 : power_table[-dec.point];
+            _decimal_shift(dec, n);
+            exp2 -= n;
+        }
+
+        // [0.5, 1) to [1, 2)
+        exp2--;
+
+        // Subnormal
+        if (exp2 < bias + 1)
+        {
+            int32_t n = bias + 1 - exp2;
+            _decimal_shift(dec, -n);
+            exp2 += n;
+        }
+
+        if (exp2 - bias >= 0x7FF)
+        {
+            return infinity_bits;
+        }
+
+        _decimal_shift(dec, 1 + mantissa_bits);
+        uint64_t mantissa = _decimal_rounded_integer(dec);
+
+        // Rounding carried into a new bit
+        if (mantissa == ((uint64_t)2 << mantissa_bits))
+        {
+            mantissa >>= 1;
+            exp2++;
+            if (exp2 - bias >= 0x7FF)
+            {
+                return infinity_bits;
+            }
+        }
+
+        if (0 == (mantissa & ((uint64_t)1 << mantissa_bits)))
+        {
+            exp2 = bias;
+        }
+
+        return (mantissa & (((uint64_t)1 << mantissa_bits) - 1)) | ((uint64_t)((exp2 - bias) & 0x7FF) << mantissa_bits);
+    }
+
+    // Correctly rounded, locale independent conversion of a valid JSON number
+    double _parse_double(const _tchar* data_ptr, const _tchar* data_end)
+    {
+        static const double power_of_ten[] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+        };
+
+        const _tchar* start_ptr = data_ptr;
+        uint64_t mantissa = 0;
+        int64_t exponent = 0;
+        int32_t digit_count = 0;
+        uint64_t bits = 0;
+        bool flag_negative = false;
+        bool flag_truncated = false;
+        bool flag_fraction = false;
+
+        if (data_ptr < data_end && _T('-') == *data_ptr)
+        {
+            flag_negative = true;
+            data_ptr++;
+        }
+
+        // Keep the first 19 significant digits
+        for (; data_ptr < data_end; data_ptr++)
+        {
+            _tchar ch = *data_ptr;
+            if (_T('.') == ch)
+            {
+                flag_fraction = true;
+                continue;
+            }
+
+            if (ch < _T('0') || ch > _T('9'))
+            {
+                break;
+            }
+
+            uint32_t digit = (uint32_t)(ch - _T('0'));
+            if (digit_count < 19 && (0 != mantissa || 0 != digit))
+            {
+                mantissa = mantissa * 10 + digit;
+                digit_count++;
+                if (flag_fraction)
+                {
+                    exponent--;
+                }
+            }
+            else if (0 == mantissa)
+            {
+                if (flag_fraction)
+                {
+                    exponent--;
+                }
+            }
+            else
+            {
+                if (0 != digit)
+                {
+                    flag_truncated = true;
+                }
+
+                if (!flag_fraction)
+                {
+                    exponent++;
+                }
+            }
+        }
+
+        if (data_ptr < data_end && (_T('e') == *data_ptr || _T('E') == *data_ptr))
+        {
+            int64_t exp_sign = 1;
+            int64_t exp_value = 0;
+
+            data_ptr++;
+            if (data_ptr < data_end && (_T('-') == *data_ptr || _T('+') == *data_ptr))
+            {
+                exp_sign = _T('-') == *data_ptr ? -1 : 1;
+                data_ptr++;
+            }
+
+            for (; data_ptr < data_end && *data_ptr >= _T('0') && *data_ptr <= _T('9'); data_ptr++)
+            {
+                if (exp_value < 0x10000000)
+                {
+                    exp_value = exp_value * 10 + (int64_t)(*data_ptr - _T('0'));
+                }
+            }
+
+            exponent += exp_sign * exp_value;
+        }
+
+        do
+        {
+            if (0 == mantissa)
+            {
+                break;
+            }
+
+            // Clinger: both operands are exact doubles, one rounding
+            if (!flag_truncated && exponent >= -22 && exponent <= 22 && mantissa <= ((uint64_t)1 << 53))
+            {
+                double val = (double)mantissa;
+                val = exponent < 0 ? val / power_of_ten[-exponent] : val * power_of_ten[exponent];
+                return flag_negative ? -val : val;
+            }
+
+            // The dropped digits lie between mantissa and mantissa + 1
+            uint64_t bits_upper = 0;
+            if (_eisel_lemire(exponent, mantissa, &bits))
+            {
+                if (!flag_truncated || (_eisel_lemire(exponent, mantissa + 1, &bits_upper) && bits_upper == bits))
+                {
+                    break;
+                }
+            }
+
+            json_decimal dec;
+            _decimal_assign(dec, start_ptr, data_end);
+            bits = _decimal_to_double_bits(dec);
+
+        } while (false);
+
+        if (flag_negative)
+        {
+            bits |= (uint64_t)1 << 63;
+        }
+
+        double val = 0;
+        memcpy(&val, &bits, sizeof(val));
+        return val;
+    }
+
+    // "00" to "99", two digits are written per division
+    static const char json_digit_pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    static const uint64_t json_power_of_ten[] =
+    {
+        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+        1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+        100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+        1000000000000000000ULL, 10000000000000000000ULL,
+    };
+
+    static uint32_t _count_digits(uint64_t val)
+    {
+        // log10(2) ~ 1233 / 4096, zero counts as one digit
+        val |= 1;
+        uint32_t count = ((64 - _json_clz64(val)) * 1233) >> 12;
+        return count + (val >= json_power_of_ten[count] ? 1 : 0);
+    }
+
+    // Locale independent, out_ptr holds at least 20 characters, returns the length written
+    size_t _format_uint(_tchar* out_ptr, uint64_t val)
+    {
+        uint32_t length = _count_digits(val);
+        _tchar* ch_ptr = out_ptr + length;
+
+        while (val >= 0x100000000ULL)
+        {
+            uint32_t pos = (uint32_t)(val % 100) * 2;
+            val /= 100;
+            *--ch_ptr = (_tchar)json_digit_pairs[pos + 1];
+            *--ch_ptr = (_tchar)json_digit_pairs[pos];
+        }
+
+        // 32-bit division is cheaper for the remaining digits
+        uint32_t low = (uint32_t)val;
+        while (low >= 100)
+        {
+            uint32_t pos = (low % 100) * 2;
+            low /= 100;
+            *--ch_ptr = (_tchar)json_digit_pairs[pos + 1];
+            *--ch_ptr = (_tchar)json_digit_pairs[pos];
+        }
+
+        if (low >= 10)
+        {
+            *--ch_ptr = (_tchar)json_digit_pairs[low * 2 + 1];
+            *--ch_ptr = (_tchar)json_digit_pairs[low * 2];
+        }
+        else
+        {
+            *--ch_ptr = (_tchar)(_T('0') + low);
+        }
+
+        return length;
+    }
+
+    // out_ptr holds at least 21 characters
+    size_t _format_int(_tchar* out_ptr, int64_t val)
+    {
+        if (val < 0)
+        {
+            *out_ptr = _T('-');
+            return 1 + _format_uint(out_ptr + 1, 0 - (uint64_t)val);
+        }
+
+        return _format_uint(out_ptr, (uint64_t)val);
+    }
+
+    struct json_uint128
+    {
+        uint64_t high;
+        uint64_t low;
+    };
+
+    inline int32_t _floor_log10_pow2(int32_t e)
+    {
+        return (e * 315653) >> 20;
+    }
+
+    inline int32_t _floor_log2_pow10(int32_t e)
+    {
+        return (e * 1741647) >> 19;
+    }
+
+    // 10^k normalized to 128 bits and rounded up, k in [-292, 326]
+    static json_uint128 _get_pow10_cache(int32_t k)
+    {
+        const uint64_t* power_ptr = json_power_of_five_128 + 2 * (k + 342);
+        json_uint128 cache = { power_ptr[0], power_ptr[1] };
+
+        if (k < -27 || k > 55)
+        {
+            cache.low++;
+            cache.high += 0 == cache.low ? 1 : 0;
+        }
+
+        return cache;
+    }
+
+    // Upper 128 bits of the 192 bits product
+    static json_uint128 _umul192_upper128(uint64_t x, const json_uint128& y)
+    {
+        json_uint128 result = { 0, 0 };
+        uint64_t middle = 0;
+
+        result.low = _json_umul128(x, y.high, &result.high);
+        _json_umul128(x, y.low, &middle);
+        result.low += middle;
+        result.high += result.low < middle ? 1 : 0;
+        return result;
+    }
+
+    // Lower 128 bits of the 192 bits product
+    static json_uint128 _umul192_lower128(uint64_t x, const json_uint128& y)
+    {
+        json_uint128 result = { 0, 0 };
+        uint64_t middle = 0;
+
+        result.low = _json_umul128(x, y.low, &middle);
+        result.high = x * y.high + middle;
+        return result;
+    }
+
+    // Parity of the integer part of two_f * 2^beta * 10^k, and whether it is an integer
+    static bool _mul_parity(uint64_t two_f, const json_uint128& cache, int32_t beta, bool* integer_ptr)
+    {
+        json_uint128 product = _umul192_lower128(two_f, cache);
+        *integer_ptr = 0 == ((product.high << beta) | (product.low >> (64 - beta)));
+        return 0 != ((product.high >> (64 - beta)) & 1);
+    }
+
+    static void _remove_trailing_zeros(uint64_t& significand, int32_t& exponent)
+    {
+        while (0 == significand % 10)
+        {
+            significand /= 10;
+            exponent++;
+        }
+    }
+
+    // Dragonbox (Junekey Jeon): shortest decimal significand * 10^exponent that reads back to the
+    // positive, finite, nonzero double bits, the one closest to the value when several are as short
+    static void _to_shortest_decimal(uint64_t bits, uint64_t& significand, int32_t& exponent)
+    {
+        const int32_t kappa = 2;
+        uint64_t two_fc = (bits & 0xFFFFFFFFFFFFFULL) << 1;
+        int32_t exponent_bits = (int32_t)((bits >> 52) & 0x7FF);
+        int32_t binary_exponent = -1074;
+
+        // Round to nearest even: the interval includes its endpoints when the significand is even
+        bool flag_even = 0 == (bits & 1);
+
+        if (0 != exponent_bits)
+        {
+            binary_exponent = exponent_bits - 1075;
+
+            // Powers of two, the interval below is half as wide as the one above
+            if (0 == two_fc)
+            {
+                int32_t minus_k = (binary_exponent * 631305 - 261663) >> 21;
+                int32_t beta = binary_exponent + _floor_log2_pow10(-minus_k);
+                json_uint128 cache = _get_pow10_cache(-minus_k);
+                uint64_t xi = (cache.high - (cache.high >> 54)) >> (11 - beta);
+                uint64_t zi = (cache.high + (cache.high >> 53)) >> (11 - beta);
+
+                if (binary_exponent < 2 || binary_exponent > 3)
+                {
+                    xi++;
+                }
+
+                significand = zi / 10;
+                if (significand * 10 >= xi)
+                {
+                    exponent = minus_k + 1;
+                    _remove_trailing_zeros(significand, exponent);
+                    return;
+                }
+
+                significand = ((cache.high >> (10 - beta)) + 1) / 2;
+                exponent = minus_k;
+                if ((significand & 1) && -77 == binary_exponent)
+                {
+                    significand--;
+                }
+                else if (significand < xi)
+                {
+                    significand++;
+                }
+
+                return;
+            }
+
+            two_fc |= 1ULL << 53;
+        }
+
+        int32_t minus_k = _floor_log10_pow2(binary_exponent) - kappa;
+        json_uint128 cache = _get_pow10_cache(-minus_k);
+        int32_t beta = binary_exponent + _floor_log2_pow10(-minus_k);
+        uint32_t deltai = (uint32_t)(cache.high >> (63 - beta));
+        json_uint128 z_result = _umul192_upper128((two_fc | 1) << beta, cache);
+        bool flag_small_divisor = false;
+        bool flag_integer = false;
+
+        // Try 10^(kappa + 1) first
+        significand = z_result.high / 1000;
+        uint32_t r = (uint32_t)(z_result.high - 1000 * significand);
+
+        if (r < deltai)
+        {
+            // The right endpoint is excluded
+            if (0 == r && 0 == z_result.low && !flag_even)
+            {
+                significand--;
+                r = 1000;
+                flag_small_divisor = true;
+            }
+        }
+        else if (r > deltai)
+        {
+            flag_small_divisor = true;
+        }
+        else
+        {
+            bool x_parity = _mul_parity(two_fc - 1, cache, beta, &flag_integer);
+            if (!(x_parity || (flag_integer && flag_even)))
+            {
+                flag_small_divisor = true;
+            }
+        }
+
+        if (!flag_small_divisor)
+        {
+            exponent = minus_k + kappa + 1;
+            _remove_trailing_zeros(significand, exponent);
+            return;
+        }
+
+        // Then 10^kappa, the result is rounded to the nearest
+        significand *= 10;
+        exponent = minus_k + kappa;
+
+        uint32_t dist = r - (deltai / 2) + 50;
+        bool approx_y_parity = 0 != ((dist ^ 50) & 1);
+        bool flag_divisible = 0 == dist % 100;
+
+        dist /= 100;
+        significand += dist;
+
+        if (flag_divisible)
+        {
+            bool y_parity = _mul_parity(two_fc, cache, beta, &flag_integer);
+            if (y_parity != approx_y_parity)
+            {
+                significand--;
+            }
+            else if ((significand & 1) && flag_integer)
+            {
+                significand--;
+            }
+        }
+    }
+
+    // Shortest round trip text, fixed notation for exponents in [-5, 15] as %.16g did, with ".0" for integers
+    // out_ptr holds at least 32 characters, NaN and infinity have no JSON form and are written as null
+    size_t _format_double(_tchar* out_ptr, double val)
+    {
+        _tchar* ch_ptr = out_ptr;
+        uint64_t bits = 0;
+
+        memcpy(&bits, &val, sizeof(bits));
+        if (0x7FF0000000000000ULL == (bits & 0x7FF0000000000000ULL))
+        {
+            memcpy(out_ptr, _T("null"), 4 * sizeof(_tchar));
+            return 4;
+        }
+
+        if (bits >> 63)
+        {
+            *ch_ptr++ = _T('-');
+            bits &= 0x7FFFFFFFFFFFFFFFULL;
+        }
+
+        if (0 == bits)
+        {
+            memcpy(ch_ptr, _T("0.0"), 3 * sizeof(_tchar));
+            return ch_ptr - out_ptr + 3;
+        }
+
+        uint64_t significand = 0;
+        int32_t exponent = 0;
+        _to_shortest_decimal(bits, significand, exponent);
+
+        _tchar digits[24];
+        int32_t count = (int32_t)_format_uint(digits, significand);
+        int32_t point = exponent + count - 1;
+
+        if (point >= 0 && point < 16)
+        {
+            // ddd.ddd, or ddd000.0
+            if (count <= point + 1)
+            {
+                memcpy(ch_ptr, digits, count * sizeof(_tchar));
+                ch_ptr += count;
+                for (int32_t i = count; i <= point; i++)
+                {
+                    *ch_ptr++ = _T('0');
+                }
+                *ch_ptr++ = _T('.');
+                *ch_ptr++ = _T('0');
+            }
+            else
+            {
+                memcpy(ch_ptr, digits, (point + 1) * sizeof(_tchar));
+                ch_ptr += point + 1;
+                *ch_ptr++ = _T('.');
+                memcpy(ch_ptr, digits + point + 1, (count - point - 1) * sizeof(_tchar));
+                ch_ptr += count - point - 1;
+            }
+        }
+        else if (point < 0 && point >= -5)
+        {
+            // 0.000ddd
+            *ch_ptr++ = _T('0');
+            *ch_ptr++ = _T('.');
+            for (int32_t i = point + 1; i < 0; i++)
+            {
+                *ch_ptr++ = _T('0');
+            }
+            memcpy(ch_ptr, digits, count * sizeof(_tchar));
+            ch_ptr += count;
+        }
+        else
+        {
+            // d.ddde+XX, at least two exponent digits
+            *ch_ptr++ = digits[0];
+            if (count > 1)
+            {
+                *ch_ptr++ = _T('.');
+                memcpy(ch_ptr, digits + 1, (count - 1) * sizeof(_tchar));
+                ch_ptr += count - 1;
+            }
+
+            *ch_ptr++ = _T('e');
+            *ch_ptr++ = point < 0 ? _T('-') : _T('+');
+
+            uint32_t exp_value = point < 0 ? -point : point;
+            if (exp_value >= 100)
+            {
+                *ch_ptr++ = (_tchar)(_T('0') + exp_value / 100);
+                exp_value %= 100;
+            }
+            *ch_ptr++ = (_tchar)json_digit_pairs[exp_value * 2];
+            *ch_ptr++ = (_tchar)json_digit_pairs[exp_value * 2 + 1];
+        }
+
+        return ch_ptr - out_ptr;
+    }
+
+    bool json_value::_parse(const _tchar* data_ptr, const _tchar* data_end, json_value& val, const _tchar** end_ptr, json_arena* arena/* = nullptr*/)
+    {
+        json_dom_handler handler(val, arena);
+        json_sax_reader<json_dom_handler> reader(handler);
+        bool result_flag = reader.parse(data_ptr, data_end, &data_ptr);
+
+        if (!result_flag)
+        {
+            _reset_type(json_type::json_type_null);
+        }
+
+        if (end_ptr)
+        {
+            *end_ptr = data_ptr;
+        }
+
+        return result_flag;
+    }
+
+    bool json_value::_parse_parallel(const _tchar* data_ptr, size_t size, json_value& val, size_t thread_count)
+    {
+        const _tchar* data_end = data_ptr + size;
+        const _tchar* end_ptr = nullptr;
+
+        json_parallel_context context(thread_count);
+
+        data_ptr = _skip_whitespace(_skip_bom(data_ptr, data_end), data_end);
+        if (!_parse_parallel_value(data_ptr, data_end, val, context, 0, &end_ptr) ||
+            _skip_whitespace(end_ptr, data_end) != data_end)
+        {
+            val._reset_type(json_type::json_type_null);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool json_value::_parse_parallel_value(const _tchar* data_ptr, const _tchar* data_end, json_value& val, json_parallel_context& context, size_t depth, const _tchar** end_ptr)
+    {
+        if (data_ptr < data_end && depth < json_parallel_max_descent)
+        {
+            if (_T('[') == *data_ptr)
+            {
+                return _parse_parallel_array(data_ptr, data_end, val, context, depth, end_ptr);
+            }
+
+            if (_T('{') == *data_ptr)
+            {
+                return _parse_parallel_object(data_ptr, data_end, val, context, depth, end_ptr);
+            }
+        }
+
+        // Scalars, and the levels below the ones walked, take the serial parser
+        const _tchar* value_end = json_ondemand::_skip_value(data_ptr, data_end);
+        if (nullptr == value_end)
+        {
+            return false;
+        }
+
+        *end_ptr = value_end;
+        return _parse_span(data_ptr, value_end, val, context, depth);
+    }
+
+    bool json_value::_parse_parallel_array(const _tchar* data_ptr, const _tchar* data_end, json_value& val, json_parallel_context& context, size_t depth, const _tchar** end_ptr)
+    {
+        std::vector<std::pair<const _tchar*, const _tchar*>> element_spans;
+        const _tchar* array_ptr = data_ptr;
+
+        if (depth >= FC_JSON_MAX_DEPTH)
+        {
+            return false;
+        }
+
+        // Structural pass: element boundaries by bracket matching, elements are validated when parsed
+        data_ptr = _skip_whitespace(data_ptr + 1, data_end);
+        while (data_ptr < data_end && _T(']') != *data_ptr)
+        {
+            const _tchar* element_end = json_ondemand::_skip_value(data_ptr, data_end);
+            if (nullptr == element_end)
+            {
+                return false;
+            }
+
+            element_spans.emplace_back(data_ptr, element_end);
+            data_ptr = _skip_whitespace(element_end, data_end);
+            if (data_ptr < data_end && _T(',') == *data_ptr)
+            {
+                data_ptr = _skip_whitespace(data_ptr + 1, data_end);
+            }
+            else if (data_ptr >= data_end || _T(']') != *data_ptr)
+            {
+                return false;
+            }
+        }
+
+        if (data_ptr >= data_end)
+        {
+            return false;
+        }
+
+        *end_ptr = data_ptr + 1;
+
+        // Too small to be worth the threads
+        if ((size_t)(data_ptr - array_ptr) < json_parallel_min_size)
+        {
+            return _parse_span(array_ptr, data_ptr + 1, val, context, depth);
+        }
+
+        val._reset_type(json_type::json_type_array);
+        if (nullptr == val.m_long.data._array_ptr)
+        {
+            return false;
+        }
+
+        json_array& array = *val.m_long.data._array_ptr;
+        array.assign(element_spans.size(), json_value(json_type::json_type_null));
+
+        // A single large element, split inside it
+        if (1 == element_spans.size())
+        {
+            const _tchar* element_end = nullptr;
+            return _parse_parallel_value(element_spans[0].first, element_spans[0].second, array[0], context, depth + 1, &element_end) &&
+                element_end == element_spans[0].second;
+        }
+
+        // Slices of about the same length, taken by the threads in turn
+        size_t slice_count = std::min(element_spans.size(), context.thread_count * 4);
+        size_t slice_size = (size_t)(data_ptr - element_spans[0].first) / slice_count + 1;
+        std::vector<size_t> slice_begins(1, 0);
+        for (size_t i = 1; i < element_spans.size(); i++)
+        {
+            if ((size_t)(element_spans[i].first - element_spans[slice_begins.back()].first) >= slice_size)
+            {
+                slice_begins.push_back(i);
+            }
+        }
+        slice_begins.push_back(element_spans.size());
+
+        std::atomic<size_t> next_slice(0);
+        std::atomic<bool> flag_failed(false);
+        auto parse_slices = [&]()
+        {
+            // Key pools are not shared between threads
+            json_parallel_context slice_context(1);
+            size_t slice = 0;
+            while (!flag_failed && (slice = next_slice++) + 1 < slice_begins.size())
+            {
+                for (size_t i = slice_begins[slice]; i < slice_begins[slice + 1]; i++)
+                {
+                    if (!_parse_span(element_spans[i].first, element_spans[i].second, array[i], slice_context, depth + 1))
+                    {
+                        flag_failed = true;
+                        break;
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < context.thread_count && i + 1 < slice_begins.size(); i++)
+        {
+            threads.emplace_back(parse_slices);
+        }
+
+        parse_slices();
+        for (auto& item : threads)
+        {
+            item.join();
+        }
+
+        return !flag_failed;
+    }
+
+    bool json_value::_parse_parallel_object(const _tchar* data_ptr, const _tchar* data_end, json_value& val, json_parallel_context& context, size_t depth, const _tchar** end_ptr)
+    {
+        if (depth >= FC_JSON_MAX_DEPTH)
+        {
+            return false;
+        }
+
+        val._reset_type(json_type::json_type_object);
+        if (nullptr == val.m_long.data._object_ptr)
+        {
+            return false;
+        }
+
+        // Walked member by member without a structural pass, so each level is scanned once
+        json_object& object = *val.m_long.data._object_ptr;
+        data_ptr = _skip_whitespace(data_ptr + 1, data_end);
+        while (data_ptr < data_end && _T('}') != *data_ptr)
+        {
+            _tstring value_name;
+            if (!_parse_string(data_ptr, data_end, value_name, &data_ptr))
+            {
+                return false;
+            }
+
+            data_ptr = _skip_whitespace(data_ptr, data_end);
+            if (data_ptr >= data_end || _T(':') != *data_ptr)
+            {
+                return false;
+            }
+
+            json_value value_data(json_type::json_type_null);
+            data_ptr = _skip_whitespace(data_ptr + 1, data_end);
+            if (!_parse_parallel_value(data_ptr, data_end, value_data, context, depth + 1, &data_ptr))
+            {
+                return false;
+            }
+
+            // The first of duplicate keys wins
+#ifdef FC_JSON_INTERN_KEYS
+            object.emplace(context.key_pool.intern(value_name), std::move(value_data));
+#else
+            object.emplace(std::move(value_name), std::move(value_data));
+#endif
+
+            data_ptr = _skip_whitespace(data_ptr, data_end);
+            if (data_ptr < data_end && _T(',') == *data_ptr)
+            {
+                data_ptr = _skip_whitespace(data_ptr + 1, data_end);
+            }
+            else if (data_ptr >= data_end || _T('}') != *data_ptr)
+            {
+                return false;
+            }
+        }
+
+        if (data_ptr >= data_end)
+        {
+            return false;
+        }
+
+        *end_ptr = data_ptr + 1;
+        return true;
+    }
+
+    bool json_value::_parse_span(const _tchar* data_ptr, const _tchar* data_end, json_value& val, json_parallel_context& context, size_t depth)
+    {
+#ifdef FC_JSON_INTERN_KEYS
+        json_dom_handler handler(val, context.key_pool);
+#else
+        (void)context;
+        json_dom_handler handler(val);
+#endif
+        json_sax_reader<json_dom_handler> reader(handler, FC_JSON_MAX_DEPTH > depth ? FC_JSON_MAX_DEPTH - depth : 0);
+
+        if (!reader.parse(data_ptr, data_end, nullptr))
+        {
+            val._reset_type(json_type::json_type_null);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool json_value::_parse_indexed_string(json_index& index, size_t begin_pos, _tstring& val)
+    {
+        const _tchar* data_ptr = index.text();
+        size_t end_pos = 0;
+
+        // The closing quote is the next structural
+        if (!index.next(&end_pos) || _T('\"') != data_ptr[end_pos])
+        {
+            return false;
+        }
+
+        if (!index.has_escape(begin_pos, end_pos))
+        {
+            val.assign(data_ptr + begin_pos + 1, end_pos - begin_pos - 1);
+            return true;
+        }
+
+        const _tchar* end_ptr = nullptr;
+        if (!_parse_string(data_ptr + begin_pos, index.text_end(), val, &end_ptr))
+        {
+            return false;
+        }
+
+        return end_ptr == data_ptr + end_pos + 1;
+    }
+
+    bool json_value::_parse_indexed_scalar(json_index& index, size_t begin_pos, json_value& val)
+    {
+        const _tchar* data_ptr = index.text() + begin_pos;
+        const _tchar* data_end = index.text_end();
+        _tchar ch = *data_ptr;
+
+        if (_T('-') == ch || _json_istdigit(ch))
+        {
+            if (!_parse_number(data_ptr, data_end, val, &data_ptr))
+            {
+                return false;
+            }
+        }
+        else if (_skip_literal(data_ptr, data_end, _T("null"), 4))
+        {
+            val = json_value(json_type::json_type_null);
+            data_ptr += 4;
+        }
+        else if (_skip_literal(data_ptr, data_end, _T("true"), 4))
+        {
+            val = true;
+            data_ptr += 4;
+        }
+        else if (_skip_literal(data_ptr, data_end, _T("false"), 5))
+        {
+            val = false;
+            data_ptr += 5;
+        }
+        else
+        {
+            return false;
+        }
+
+        // Only whitespace may lie between the token and the next structural
+        return _skip_whitespace(data_ptr, data_end) == index.text() + index.peek();
+    }
+
+    bool json_value::_parse_indexed_object(json_index& index, json_value& val)
+    {
+        const _tchar* data_ptr = index.text();
+        _tstring value_name;
+        size_t pos = 0;
+
+        // The header is allocated with the first member
+        val._reset_type(json_type::json_type_null);
+        val.m_long.type = json_type::json_type_object;
+        while (index.next(&pos))
+        {
+            if (_T('}') == data_ptr[pos])
+            {
+                return true;
+            }
+
+            if (_T('\"') != data_ptr[pos])
+            {
+                break;
+            }
+
+            value_name.clear();
+            if (!_parse_indexed_string(index, pos, value_name))
+            {
+                break;
+            }
+
+            if (!index.next(&pos) || _T(':') != data_ptr[pos])
+            {
+                break;
+            }
+
+            json_value value_data(json_type::json_type_null);
+            if (!_parse_indexed_value(index, value_data))
+            {
+                break;
+            }
+
+            if (nullptr == val.m_long.data._object_ptr)
+            {
+                val._reset_type(json_type::json_type_object, index.arena());
+            }
+
+            if (val.m_long.data._object_ptr)
+            {
+#ifdef FC_JSON_INTERN_KEYS
+                val.m_long.data._object_ptr->emplace(index.key_pool().intern(value_name), std::move(value_data));
+#else
+                val.m_long.data._object_ptr->emplace(value_name, std::move(value_data));
+#endif
+            }
+
+            if (!index.next(&pos))
+            {
+                break;
+            }
+
+            if (_T('}') == data_ptr[pos])
+            {
+                return true;
+            }
+
+            if (_T(',') != data_ptr[pos])
+            {
+                break;
+            }
+        }
+
+        return false;
+    }
+
+    bool json_value::_parse_indexed_array(json_index& index, json_value& val)
+    {
+        const _tchar* data_ptr = index.text();
+        size_t pos = 0;
+
+        val._reset_type(json_type::json_type_null);
+        val.m_long.type = json_type::json_type_array;
+        while (!index.is_end())
+        {
+            if (_T(']') == data_ptr[index.peek()])
+            {
+                index.next(&pos);
+                return true;
+            }
+
+            json_value value_data(json_type::json_type_null);
+            if (!_parse_indexed_value(index, value_data))
+            {
+                break;
+            }
+
+            if (nullptr == val.m_long.data._array_ptr)
+            {
+                val._reset_type(json_type::json_type_array, index.arena());
+            }
+
+            if (val.m_long.data._array_ptr)
+            {
+                val.m_long.data._array_ptr->emplace_back(std::move(value_data));
+            }
+
+            if (!index.next(&pos))
+            {
+                break;
+            }
+
+            if (_T(']') == data_ptr[pos])
+            {
+                return true;
+            }
+
+            if (_T(',') != data_ptr[pos])
+            {
+                break;
+            }
+        }
+
+        return false;
+    }
+
+    bool json_value::_parse_indexed_value(json_index& index, json_value& val)
+    {
+        size_t pos = 0;
+        if (!index.next(&pos))
+        {
+            return false;
+        }
+
+        switch (index.text()[pos])
+        {
+        case _T('{'):
+        case _T('['):
+        {
+            bool result_flag = index.enter() && (_T('{') == index.text()[pos] ? _parse_indexed_object(index, val) : _parse_indexed_array(index, val));
+            index.leave();
+            return result_flag;
+        }
+        break;
+        case _T('\"'):
+        {
+            _tstring text;
+            if (!_parse_indexed_string(index, pos, text))
+            {
+                return false;
+            }
+
+            val._reset_string(std::move(text), index.arena());
+            return true;
+        }
+        break;
+        default:
+        {
+            return _parse_indexed_scalar(index, pos, val);
+        }
+        break;
+        }
+
+        return true;
+    }
+
+    bool json_value::_parse_indexed(const _tchar* data_ptr, size_t size, json_value& val, json_arena* arena/* = nullptr*/)
+    {
+        const _tchar* begin_ptr = _skip_bom(data_ptr, data_ptr + size);
+        bool result_flag = false;
+
+        // Positions are stored as 32 bits
+        if (size >= UINT32_MAX)
+        {
+            const _tchar* end_ptr = nullptr;
+            return _parse(data_ptr, data_ptr + size, val, &end_ptr, arena);
+        }
+
+        size -= begin_ptr - data_ptr;
+
+        json_index index(begin_ptr, size, arena);
+        if (index.build() && _parse_indexed_value(index, val) && index.is_end())
+        {
+            result_flag = true;
+        }
+
+        if (!result_flag)
+        {
+            _reset_type(json_type::json_type_null);
+        }
+
+        return result_flag;
+    }
+
+    json_stream_parser::json_stream_parser() :
+        m_value(json_type::json_type_null),
+        m_handler(m_value),
+        m_state(json_stream_state::json_stream_bom),
+        m_escape(false)
+    {
+    }
+
+    bool json_stream_parser::feed(const _tstring& text)
+    {
+        return feed(text.data(), text.size());
+    }
+
+    bool json_stream_parser::feed(const _tchar* data, size_t size)
+    {
+        const _tchar* data_ptr = data;
+        const _tchar* data_end = data + size;
+
+        // Opening quote of a string that started in this chunk
+        const _tchar* string_ptr = nullptr;
+
+        if (nullptr == data && size > 0)
+        {
+            m_state = json_stream_state::json_stream_error;
+        }
+
+        while (data_ptr < data_end && json_stream_state::json_stream_error != m_state)
+        {
+            switch (m_state)
+            {
+            case json_stream_state::json_stream_bom:
+            {
+#ifdef _UNICODE
+                if (0xFEFF == *data_ptr)
+                {
+                    data_ptr++;
+                    continue;
+                }
+#else
+                // The BOM may be split between chunks
+                static const _tchar bom_text[] = "\xEF\xBB\xBF";
+                if (bom_text[m_token.size()] == *data_ptr)
+                {
+                    m_token.push_back(*data_ptr++);
+                    if (3 == m_token.size())
+                    {
+                        m_token.clear();
+                    }
+                    continue;
+                }
+#endif
+                m_state = json_stream_state::json_stream_value;
+
+#ifndef _UNICODE
+                // Not a BOM, the held bytes are read as text like parse() reads what _skip_bom leaves
+                if (!m_token.empty())
+                {
+                    _tstring held_text;
+                    held_text.swap(m_token);
+                    feed(held_text.data(), held_text.size());
+                }
+#endif
+            }
+            break;
+            case json_stream_state::json_stream_string:
+            case json_stream_state::json_stream_key:
+            {
+                const _tchar* begin_ptr = data_ptr;
+                bool flag_end = false;
+
+                while (data_ptr < data_end)
+                {
+                    _tchar ch = *data_ptr++;
+                    if (m_escape)
+                    {
+                        m_escape = false;
+                    }
+                    else if (_T('\\') == ch)
+                    {
+                        m_escape = true;
+                    }
+                    else if (_T('\"') == ch)
+                    {
+                        flag_end = true;
+                        break;
+                    }
+                    else if (_T('\0') == ch)
+                    {
+                        m_state = json_stream_state::json_stream_error;
+                        break;
+                    }
+                }
+
+                if (json_stream_state::json_stream_error == m_state)
+                {
+                    break;
+                }
+
+                bool flag_key = json_stream_state::json_stream_key == m_state;
+
+                // The whole string is in this chunk
+                if (flag_end && nullptr != string_ptr)
+                {
+                    if (!_parse_string(string_ptr, data_ptr - string_ptr, flag_key))
+                    {
+                        m_state = json_stream_state::json_stream_error;
+                    }
+                    string_ptr = nullptr;
+                    break;
+                }
+
+                m_token.append(nullptr != string_ptr ? string_ptr : begin_ptr, data_ptr);
+                string_ptr = nullptr;
+
+                if (flag_end)
+                {
+                    if (!_parse_string(m_token.data(), m_token.size(), flag_key))
+                    {
+                        m_state = json_stream_state::json_stream_error;
+                    }
+                    m_token.clear();
+                }
+            }
+            break;
+            case json_stream_state::json_stream_number:
+            case json_stream_state::json_stream_literal:
+            {
+                const _tchar* begin_ptr = data_ptr;
+                if (json_stream_state::json_stream_number == m_state)
+                {
+                    while (data_ptr < data_end && (_json_istdigit(*data_ptr) || _T('.') == *data_ptr ||
+                        _T('-') == *data_ptr || _T('+') == *data_ptr || _T('e') == *data_ptr || _T('E') == *data_ptr))
+                    {
+                        data_ptr++;
+                    }
+                }
+                else
+                {
+                    while (data_ptr < data_end && *data_ptr >= _T('a') && *data_ptr <= _T('z'))
+                    {
+                        data_ptr++;
+                    }
+                }
+
+                m_token.append(begin_ptr, data_ptr);
+
+                // The token ends before the chunk does
+                if (data_ptr < data_end && !_parse_scalar())
+                {
+                    m_state = json_stream_state::json_stream_error;
+                }
+            }
+            break;
+            default:
+            {
+                data_ptr = _skip_whitespace(data_ptr, data_end);
+                if (data_ptr >= data_end)
+                {
+                    break;
+                }
+
+                _tchar ch = *data_ptr;
+
+                if (json_stream_state::json_stream_colon == m_state)
+                {
+                    if (_T(':') != ch)
+                    {
+                        m_state = json_stream_state::json_stream_error;
+                        break;
+                    }
+
+                    m_state = json_stream_state::json_stream_value;
+                    data_ptr++;
+                }
+                else if (json_stream_state::json_stream_comma == m_state)
+                {
+                    if (_T(',') == ch)
+                    {
+                        m_state = m_handler.in_array() ? json_stream_state::json_stream_array_value : json_stream_state::json_stream_object_key;
+                    }
+                    else if (_T('}') == ch ? m_handler.end_object() : _T(']') == ch && m_handler.end_array())
+                    {
+                        _next_state();
+                    }
+                    else
+                    {
+                        m_state = json_stream_state::json_stream_error;
+                        break;
+                    }
+
+                    data_ptr++;
+                }
+                else if (json_stream_state::json_stream_object_key == m_state)
+                {
+                    if (_T('\"') == ch)
+                    {
+                        m_state = json_stream_state::json_stream_key;
+                        m_escape = false;
+                        string_ptr = data_ptr;
+                    }
+                    else if (_T('}') == ch && m_handler.end_object())
+                    {
+                        _next_state();
+                    }
+                    else
+                    {
+                        m_state = json_stream_state::json_stream_error;
+                        break;
+                    }
+
+                    data_ptr++;
+                }
+                else if (json_stream_state::json_stream_value == m_state || json_stream_state::json_stream_array_value == m_state)
+                {
+                    if ((_T('{') == ch || _T('[') == ch) && m_handler.depth() >= FC_JSON_MAX_DEPTH)
+                    {
+                        m_state = json_stream_state::json_stream_error;
+                    }
+                    else if (_T('{') == ch)
+                    {
+                        m_handler.start_object();
+                        m_state = json_stream_state::json_stream_object_key;
+                        data_ptr++;
+                    }
+                    else if (_T('[') == ch)
+                    {
+                        m_handler.start_array();
+                        m_state = json_stream_state::json_stream_array_value;
+                        data_ptr++;
+                    }
+                    else if (_T('\"') == ch)
+                    {
+                        m_state = json_stream_state::json_stream_string;
+                        m_escape = false;
+                        string_ptr = data_ptr;
+                        data_ptr++;
+                    }
+                    else if (_T('-') == ch || _json_istdigit(ch))
+                    {
+                        m_state = json_stream_state::json_stream_number;
+                    }
+                    else if (ch >= _T('a') && ch <= _T('z'))
+                    {
+                        m_state = json_stream_state::json_stream_literal;
+                    }
+                    else if (_T(']') == ch && json_stream_state::json_stream_array_value == m_state)
+                    {
+                        m_handler.end_array();
+                        _next_state();
+                        data_ptr++;
+                    }
+                    else
+                    {
+                        m_state = json_stream_state::json_stream_error;
+                    }
+                }
+                else
+                {
+                    // Only whitespace may follow the value
+                    m_state = json_stream_state::json_stream_error;
+                }
+            }
+            break;
+            }
+        }
+
+        // The chunk ends right after an opening quote
+        if (nullptr != string_ptr && json_stream_state::json_stream_error != m_state)
+        {
+            m_token.append(string_ptr, data_end);
+        }
+
+        return json_stream_state::json_stream_error != m_state;
+    }
+
+    bool json_stream_parser::finish()
+    {
+        if (json_stream_state::json_stream_number == m_state || json_stream_state::json_stream_literal == m_state)
+        {
+            if (!_parse_scalar())
+            {
+                m_state = json_stream_state::json_stream_error;
+            }
+        }
+
+        if (json_stream_state::json_stream_end != m_state)
+        {
+            m_handler = json_dom_handler(m_value);
+            m_token.clear();
+            m_value = json_type::json_type_null;
+            m_state = json_stream_state::json_stream_error;
+            return false;
+        }
+
+        return true;
+    }
+
+    json_value& json_stream_parser::value()
+    {
+        return m_value;
+    }
+
+    void json_stream_parser::reset()
+    {
+        m_handler = json_dom_handler(m_value);
+        m_token.clear();
+        m_value = json_type::json_type_null;
+        m_state = json_stream_state::json_stream_bom;
+        m_escape = false;
+    }
+
+    bool json_stream_parser::_parse_string(const _tchar* data_ptr, size_t size, bool flag_key)
+    {
+        const _tchar* data_end = data_ptr + size;
+        const _tchar* end_ptr = nullptr;
+
+        m_string.clear();
+        if (!json_value::_parse_string(data_ptr, data_end, m_string, &end_ptr) || end_ptr != data_end)
+        {
+            return false;
+        }
+
+        if (flag_key)
+        {
+            m_handler.key(m_string);
+            m_state = json_stream_state::json_stream_colon;
+        }
+        else
+        {
+            m_handler.string_value(m_string);
+            _next_state();
+        }
+
+        return true;
+    }
+
+    bool json_stream_parser::_parse_scalar()
+    {
+        if (json_stream_state::json_stream_number == m_state)
+        {
+            const _tchar* data_end = m_token.data() + m_token.size();
+            const _tchar* end_ptr = nullptr;
+            json_value::json_data number_data;
+            json_type number_type = json_type::json_type_null;
+
+            if (!json_value::_parse_number(m_token.data(), data_end, number_type, number_data, &end_ptr) || end_ptr != data_end)
+            {
+                return false;
+            }
+
+            if (json_type::json_type_int == number_type)
+            {
+                m_handler.int_value(number_data._int);
+            }
+            else if (json_type::json_type_uint == number_type)
+            {
+                m_handler.uint_value(number_data._uint);
+            }
+            else
+            {
+                m_handler.float_value(number_data._float);
+            }
+        }
+        else if (_T("true") == m_token)
+        {
+            m_handler.bool_value(true);
+        }
+        else if (_T("false") == m_token)
+        {
+            m_handler.bool_value(false);
+        }
+        else if (_T("null") == m_token)
+        {
+            m_handler.null_value();
+        }
+        else
+        {
+            return false;
+        }
+
+        m_token.clear();
+        _next_state();
+        return true;
+    }
+
+    void json_stream_parser::_next_state()
+    {
+        m_state = 0 == m_handler.depth() ? json_stream_state::json_stream_end : json_stream_state::json_stream_comma;
+    }
+
+    json_dom_handler::json_dom_handler(json_value& root, json_arena* arena/* = nullptr*/) :
+        m_root(&root),
+        m_arena(arena)
+#ifdef FC_JSON_INTERN_KEYS
+        , m_shared_key_pool(nullptr)
+#endif
+    {
+    }
+
+#ifdef FC_JSON_INTERN_KEYS
+    json_dom_handler::json_dom_handler(json_value& root, json_key_pool& key_pool) :
+        m_root(&root),
+        m_arena(nullptr),
+        m_shared_key_pool(&key_pool)
+    {
+    }
+#endif
+
+    bool json_dom_handler::null_value()
+    {
+        return _add_value(json_value(json_type::json_type_null));
+    }
+
+    bool json_dom_handler::bool_value(json_bool val)
+    {
+        return _add_value(json_value(val));
+    }
+
+    bool json_dom_handler::int_value(json_int val)
+    {
+        return _add_value(json_value(val));
+    }
+
+    bool json_dom_handler::uint_value(json_uint val)
+    {
+        return _add_value(json_value(val));
+    }
+
+    bool json_dom_handler::float_value(json_float val)
+    {
+        return _add_value(json_value(val));
+    }
+
+    bool json_dom_handler::string_value(_tstring& val)
+    {
+        // A short string is copied and val keeps its buffer for the reader
+        json_value value_data(json_type::json_type_null);
+        value_data._reset_string(std::move(val), m_arena);
+        return _add_value(std::move(value_data));
+    }
+
+    bool json_dom_handler::key(_tstring& val)
+    {
+        if (m_stack.empty() || m_stack.back().value.is_array())
+        {
+            return false;
+        }
+
+        // The old key's buffer goes back to the reader
+        m_stack.back().key.swap(val);
+        return true;
+    }
+
+    bool json_dom_handler::start_object()
+    {
+        // The header is allocated by end_object, and only for a non-empty object
+        json_dom_frame frame = { json_value(json_type::json_type_null), _tstring(), m_values.size(), m_keys.size() };
+        frame.value.m_long.type = json_type::json_type_object;
+        m_stack.push_back(std::move(frame));
+        return true;
+    }
+
+    bool json_dom_handler::end_object()
+    {
+        if (m_stack.empty() || !m_stack.back().value.is_object())
+        {
+            return false;
+        }
+
+        json_dom_frame& frame = m_stack.back();
+        if (m_values.size() > frame.value_begin)
+        {
+            frame.value._reset_type(json_type::json_type_object, m_arena);
+            json_object* object_ptr = frame.value.m_long.data._object_ptr;
+            if (nullptr == object_ptr)
+            {
+                return false;
+            }
+
+#if defined(FC_JSON_FLAT_OBJECT) || defined(FC_JSON_HASH_OBJECT)
+            object_ptr->reserve(m_values.size() - frame.value_begin);
+#endif
+
+            // The first of duplicate keys wins
+            for (size_t i = frame.value_begin, key_pos = frame.key_begin; i < m_values.size(); i++, key_pos++)
+            {
+                object_ptr->emplace(std::move(m_keys[key_pos]), std::move(m_values[i]));
+            }
+
+            m_values.erase(m_values.begin() + frame.value_begin, m_values.end());
+            m_keys.erase(m_keys.begin() + frame.key_begin, m_keys.end());
+        }
+
+        json_value value_data(std::move(frame.value));
+        m_stack.pop_back();
+        return _add_value(std::move(value_data));
+    }
+
+    bool json_dom_handler::start_array()
+    {
+        json_dom_frame frame = { json_value(json_type::json_type_null), _tstring(), m_values.size(), m_keys.size() };
+        frame.value.m_long.type = json_type::json_type_array;
+        m_stack.push_back(std::move(frame));
+        return true;
+    }
+
+    bool json_dom_handler::end_array()
+    {
+        if (m_stack.empty() || !m_stack.back().value.is_array())
+        {
+            return false;
+        }
+
+        json_dom_frame& frame = m_stack.back();
+        if (m_values.size() > frame.value_begin)
+        {
+            frame.value._reset_type(json_type::json_type_array, m_arena);
+            json_array* array_ptr = frame.value.m_long.data._array_ptr;
+            if (nullptr == array_ptr)
+            {
+                return false;
+            }
+
+            // One block of exactly the element count
+            array_ptr->assign(std::make_move_iterator(m_values.begin() + frame.value_begin), std::make_move_iterator(m_values.end()));
+            m_values.erase(m_values.begin() + frame.value_begin, m_values.end());
+        }
+
+        json_value value_data(std::move(frame.value));
+        m_stack.pop_back();
+        return _add_value(std::move(value_data));
+    }
+
+    size_t json_dom_handler::depth() const
+    {
+        return m_stack.size();
+    }
+
+    bool json_dom_handler::in_array() const
+    {
+        return !m_stack.empty() && m_stack.back().value.is_array();
+    }
+
+    bool json_dom_handler::_add_value(json_value&& val)
+    {
+        if (m_stack.empty())
+        {
+            *m_root = std::move(val);
+            return true;
+        }
+
+        // Members wait on m_values until their container ends
+        json_dom_frame& frame = m_stack.back();
+        if (!frame.value.is_array())
+        {
+#ifdef FC_JSON_INTERN_KEYS
+            m_keys.push_back((nullptr != m_shared_key_pool ? *m_shared_key_pool : m_key_pool).intern(frame.key));
+#else
+            m_keys.push_back(frame.key);
+#endif
+        }
+
+        m_values.push_back(std::move(val));
+
+        return true;
+    }
+
+    json_ondemand::iterator::iterator(const _tchar* data_ptr, const _tchar* data_end) :
+        m_data(data_ptr),
+        m_end(data_end)
+    {
+    }
+
+    json_ondemand json_ondemand::iterator::operator * () const
+    {
+        return json_ondemand::_make_value(m_data, m_end);
+    }
+
+    json_ondemand::iterator& json_ondemand::iterator::operator ++ ()
+    {
+        const _tchar* data_ptr = json_ondemand::_skip_value(m_data, m_end);
+        m_data = nullptr;
+
+        if (nullptr == data_ptr)
+        {
+            return *this;
+        }
+
+        data_ptr = _skip_whitespace(data_ptr, m_end);
+        if (data_ptr >= m_end || _T(',') != *data_ptr)
+        {
+            return *this;
+        }
+
+        // Trailing comma
+        data_ptr = _skip_whitespace(data_ptr + 1, m_end);
+        if (data_ptr < m_end && _T(']') != *data_ptr)
+        {
+            m_data = data_ptr;
+        }
+
+        return *this;
+    }
+
+    bool json_ondemand::iterator::operator == (const iterator& r) const
+    {
+        return m_data == r.m_data;
+    }
+
+    bool json_ondemand::iterator::operator != (const iterator& r) const
+    {
+        return m_data != r.m_data;
+    }
+
+    json_ondemand::json_ondemand() :
+        m_data(nullptr),
+        m_end(nullptr)
+    {
+    }
+
+    json_ondemand::json_ondemand(const _tchar* data, size_t size) :
+        m_data(nullptr),
+        m_end(nullptr)
+    {
+        if (nullptr == data)
+        {
+            return;
+        }
+
+        m_end = data + size;
+        const _tchar* data_ptr = _skip_whitespace(_skip_bom(data, m_end), m_end);
+        if (data_ptr < m_end)
+        {
+            m_data = data_ptr;
+        }
+    }
+
+    json_ondemand::json_ondemand(const _tstring& text) :
+        json_ondemand(text.data(), text.size())
+    {
+    }
+
+    json_type json_ondemand::type() const
+    {
+        if (nullptr == m_data)
+        {
+            return json_type::json_type_null;
+        }
+
+        switch (*m_data)
+        {
+        case _T('{'):
+            return json_type::json_type_object;
+        case _T('['):
+            return json_type::json_type_array;
+        case _T('\"'):
+            return json_type::json_type_string;
+        case _T('t'):
+        case _T('f'):
+            return json_type::json_type_bool;
+        default:
+            break;
+        }
+
+        json_value::json_data number_data;
+        json_type number_type = json_type::json_type_null;
+        if (_get_number(number_type, number_data))
+        {
+            return number_type;
+        }
+
+        return json_type::json_type_null;
+    }
+
+    bool json_ondemand::is_valid() const
+    {
+        return nullptr != m_data;
+    }
+
+    bool json_ondemand::is_null() const
+    {
+        return nullptr != m_data && _skip_literal(m_data, m_end, _T("null"), 4);
+    }
+
+    json_ondemand json_ondemand::find_field(const _tstring& name) const
+    {
+        if (nullptr == m_data || _T('{') != *m_data)
+        {
+            return json_ondemand();
+        }
+
+        const _tchar* data_ptr = _skip_whitespace(m_data + 1, m_end);
+        while (data_ptr < m_end && _T('\"') == *data_ptr)
+        {
+            const _tchar* key_end = _skip_string(data_ptr, m_end);
+            if (nullptr == key_end)
+            {
+                break;
+            }
+
+            // Keys without escapes are compared in place
+            const _tchar* key_ptr = data_ptr + 1;
+            size_t key_length = key_end - key_ptr - 1;
+            bool flag_match = false;
+            if (nullptr == std::char_traits<_tchar>::find(key_ptr, key_length, _T('\\')))
+            {
+                flag_match = key_length == name.size() && 0 == std::char_traits<_tchar>::compare(key_ptr, name.data(), key_length);
+            }
+            else
+            {
+                _tstring key_name;
+                const _tchar* end_ptr = nullptr;
+                flag_match = json_value::_parse_string(data_ptr, key_end, key_name, &end_ptr) && key_name == name;
+            }
+
+            data_ptr = _skip_whitespace(key_end, m_end);
+            if (data_ptr >= m_end || _T(':') != *data_ptr)
+            {
+                break;
+            }
+
+            data_ptr = _skip_whitespace(data_ptr + 1, m_end);
+            if (flag_match)
+            {
+                return _make_value(data_ptr, m_end);
+            }
+
+            data_ptr = _skip_value(data_ptr, m_end);
+            if (nullptr == data_ptr)
+            {
+                break;
+            }
+
+            data_ptr = _skip_whitespace(data_ptr, m_end);
+            if (data_ptr >= m_end || _T(',') != *data_ptr)
+            {
+                break;
+            }
+
+            data_ptr = _skip_whitespace(data_ptr + 1, m_end);
+        }
+
+        return json_ondemand();
+    }
+
+    json_ondemand json_ondemand::operator [] (const _tstring& name) const
+    {
+        return find_field(name);
+    }
+
+    json_ondemand json_ondemand::at(size_t index) const
+    {
+        iterator it = begin();
+        iterator it_end = end();
+
+        for (size_t i = 0; i < index && it != it_end; i++)
+        {
+            ++it;
+        }
+
+        if (it == it_end)
+        {
+            return json_ondemand();
+        }
+
+        return *it;
+    }
+
+    json_ondemand::iterator json_ondemand::begin() const
+    {
+        if (nullptr == m_data || _T('[') != *m_data)
+        {
+            return end();
+        }
+
+        const _tchar* data_ptr = _skip_whitespace(m_data + 1, m_end);
+        if (data_ptr >= m_end || _T(']') == *data_ptr)
+        {
+            return end();
+        }
+
+        return iterator(data_ptr, m_end);
+    }
+
+    json_ondemand::iterator json_ondemand::end() const
+    {
+        return iterator(nullptr, m_end);
+    }
+
+    bool json_ondemand::get_bool(json_bool& val) const
+    {
+        if (nullptr == m_data)
+        {
+            return false;
+        }
+
+        if (_skip_literal(m_data, m_end, _T("true"), 4))
+        {
+            val = true;
+            return true;
+        }
+
+        if (_skip_literal(m_data, m_end, _T("false"), 5))
+        {
+            val = false;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool json_ondemand::get_int64(json_int& val) const
+    {
+        json_value::json_data number_data;
+        json_type number_type = json_type::json_type_null;
+
+        if (!_get_number(number_type, number_data))
+        {
+            return false;
+        }
+
+        if (json_type::json_type_int == number_type)
+        {
+            val = number_data._int;
+            return true;
+        }
+
+        if (json_type::json_type_uint == number_type && number_data._uint <= (json_uint)INT64_MAX)
+        {
+            val = (json_int)number_data._uint;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool json_ondemand::get_uint64(json_uint& val) const
+    {
+        json_value::json_data number_data;
+        json_type number_type = json_type::json_type_null;
+
+        if (!_get_number(number_type, number_data) || json_type::json_type_uint != number_type)
+        {
+            return false;
+        }
+
+        val = number_data._uint;
+        return true;
+    }
+
+    bool json_ondemand::get_double(json_float& val) const
+    {
+        json_value::json_data number_data;
+        json_type number_type = json_type::json_type_null;
+
+        if (!_get_number(number_type, number_data))
+        {
+            return false;
+        }
+
+        if (json_type::json_type_int == number_type)
+        {
+            val = (json_float)number_data._int;
+        }
+        else if (json_type::json_type_uint == number_type)
+        {
+            val = (json_float)number_data._uint;
+        }
+        else
+        {
+            val = number_data._float;
+        }
+
+        return true;
+    }
+
+    bool json_ondemand::get_string(_tstring& val) const
+    {
+        const _tchar* end_ptr = nullptr;
+
+        if (nullptr == m_data || _T('\"') != *m_data)
+        {
+            return false;
+        }
+
+        val.clear();
+        return json_value::_parse_string(m_data, m_end, val, &end_ptr);
+    }
+
+    bool json_ondemand::get_value(json_value& val) const
+    {
+        const _tchar* end_ptr = _skip_value(m_data, m_end);
+
+        if (nullptr == end_ptr)
+        {
+            return false;
+        }
+
+        return val.parse(m_data, end_ptr - m_data);
+    }
+
+    json_ondemand json_ondemand::_make_value(const _tchar* data_ptr, const _tchar* data_end)
+    {
+        json_ondemand value_data;
+
+        if (nullptr != data_ptr && data_ptr < data_end)
+        {
+            value_data.m_data = data_ptr;
+            value_data.m_end = data_end;
+        }
+
+        return value_data;
+    }
+
+    const _tchar* json_ondemand::_skip_string(const _tchar* data_ptr, const _tchar* data_end)
+    {
+        data_ptr++;
+
+        while (data_ptr < data_end)
+        {
+            data_ptr = _find_quote_or_backslash(data_ptr, data_end);
+            if (data_ptr >= data_end)
+            {
+                break;
+            }
+
+            if (_T('\"') == *data_ptr)
+            {
+                return data_ptr + 1;
+            }
+
+            data_ptr += 2;
+        }
+
+        return nullptr;
+    }
+
+    const _tchar* json_ondemand::_skip_value(const _tchar* data_ptr, const _tchar* data_end)
+    {
+        if (nullptr == data_ptr || data_ptr >= data_end)
+        {
+            return nullptr;
+        }
+
+        _tchar ch = *data_ptr;
+        if (_T('\"') == ch)
+        {
+            return _skip_string(data_ptr, data_end);
+        }
+
+        // Match brackets, only strings need to be looked into
+        if (_T('{') == ch || _T('[') == ch)
+        {
+            size_t depth = 0;
+
+            while (data_ptr < data_end)
+            {
+                data_ptr = _find_bracket_or_quote(data_ptr, data_end);
+                if (data_ptr >= data_end)
+                {
+                    break;
+                }
+
+                ch = *data_ptr;
+                if (_T('\"') == ch)
+                {
+                    data_ptr = _skip_string(data_ptr, data_end);
+                    if (nullptr == data_ptr)
+                    {
+                        return nullptr;
+                    }
+                    continue;
+                }
+
+                if (_T('{') == ch || _T('[') == ch)
+                {
+                    depth++;
+                }
+                else if (_T('}') == ch || _T(']') == ch)
+                {
+                    if (0 == --depth)
+                    {
+                        return data_ptr + 1;
+                    }
+                }
+
+                data_ptr++;
+            }
+
+            return nullptr;
+        }
+
+        // Number or literal
+        const _tchar* begin_ptr = data_ptr;
+        while (data_ptr < data_end)
+        {
+            ch = *data_ptr;
+            if (ch <= _T(' ') || _T(',') == ch || _T('}') == ch || _T(']') == ch || _T(':') == ch)
+            {
+                break;
+            }
+
+            data_ptr++;
+        }
+
+        return data_ptr == begin_ptr ? nullptr : data_ptr;
+    }
+
+    bool json_ondemand::_get_number(json_type& type, json_value::json_data& data) const
+    {
+        const _tchar* end_ptr = nullptr;
+
+        if (nullptr == m_data || !(_T('-') == *m_data || _json_istdigit(*m_data)))
+        {
+            return false;
+        }
+
+        return json_value::_parse_number(m_data, m_end, type, data, &end_ptr);
+    }
+
+    json_element::iterator::iterator(const json_document* doc, size_t pos, bool flag_object) :
+        m_doc(doc),
+        m_pos(pos),
+        m_object(flag_object)
+    {
+    }
+
+    json_element json_element::iterator::operator * () const
+    {
+        return value();
+    }
+
+    json_element json_element::iterator::value() const
+    {
+        return json_element(m_doc, m_object ? m_pos + 2 : m_pos);
+    }
+
+    _tstring json_element::iterator::key() const
+    {
+        if (!m_object)
+        {
+            return _tstring();
+        }
+
+        return json_element(m_doc, m_pos).as_string();
+    }
+
+    json_element::iterator& json_element::iterator::operator ++ ()
+    {
+        m_pos = m_doc->_skip(m_object ? m_pos + 2 : m_pos);
+        return *this;
+    }
+
+    bool json_element::iterator::operator == (const iterator& r) const
+    {
+        return m_doc == r.m_doc && m_pos == r.m_pos;
+    }
+
+    bool json_element::iterator::operator != (const iterator& r) const
+    {
+        return !(*this == r);
+    }
+
+    json_element::json_element() :
+        m_doc(nullptr),
+        m_pos(0)
+    {
+    }
+
+    json_element::json_element(const json_document* doc, size_t pos) :
+        m_doc(doc),
+        m_pos(pos)
+    {
+    }
+
+    inline uint64_t json_element::_entry() const
+    {
+        return m_doc->m_tape[m_pos];
+    }
+
+    json_type json_element::type() const
+    {
+        if (nullptr == m_doc)
+        {
+            return json_type::json_type_null;
+        }
+
+        switch (json_document::_tag(_entry()))
+        {
+        case json_document::json_tape_true:
+        case json_document::json_tape_false:
+            return json_type::json_type_bool;
+        case json_document::json_tape_int:
+            return json_type::json_type_int;
+        case json_document::json_tape_uint:
+            return json_type::json_type_uint;
+        case json_document::json_tape_float:
+            return json_type::json_type_float;
+        case json_document::json_tape_string:
+            return json_type::json_type_string;
+        case json_document::json_tape_object:
+            return json_type::json_type_object;
+        case json_document::json_tape_array:
+            return json_type::json_type_array;
+        default:
+            break;
+        }
+
+        return json_type::json_type_null;
+    }
+
+    bool json_element::is_valid() const
+    {
+        return nullptr != m_doc;
+    }
+
+    bool json_element::is_null() const
+    {
+        return json_type::json_type_null == type();
+    }
+
+    bool json_element::is_bool() const
+    {
+        return json_type::json_type_bool == type();
+    }
+
+    bool json_element::is_int() const
+    {
+        json_type val_type = type();
+        return json_type::json_type_int == val_type || json_type::json_type_uint == val_type;
+    }
+
+    bool json_element::is_float() const
+    {
+        return json_type::json_type_float == type();
+    }
+
+    bool json_element::is_number() const
+    {
+        json_type val_type = type();
+        return json_type::json_type_int == val_type || json_type::json_type_uint == val_type || json_type::json_type_float == val_type;
+    }
+
+    bool json_element::is_string() const
+    {
+        return json_type::json_type_string == type();
+    }
+
+    bool json_element::is_object() const
+    {
+        return json_type::json_type_object == type();
+    }
+
+    bool json_element::is_array() const
+    {
+        return json_type::json_type_array == type();
+    }
+
+    json_bool json_element::as_bool() const
+    {
+        if (!is_bool())
+        {
+            throw json_exception(__JSON_FUNCTION__);
+        }
+
+        return json_document::json_tape_true == json_document::_tag(_entry());
+    }
+
+    json_bool json_element::as_bool(json_bool default_val) const
+    {
+        if (!is_bool())
+        {
+            return default_val;
+        }
+
+        return json_document::json_tape_true == json_document::_tag(_entry());
+    }
+
+    json_int json_element::as_int() const
+    {
+        if (!is_int())
+        {
+            throw json_exception(__JSON_FUNCTION__);
+        }
+
+        return (json_int)m_doc->m_tape[m_pos + 1];
+    }
+
+    json_int json_element::as_int(json_int default_val) const
+    {
+        if (!is_int())
+        {
+            return default_val;
+        }
+
+        return (json_int)m_doc->m_tape[m_pos + 1];
+    }
+
+    json_uint json_element::as_uint() const
+    {
+        if (!is_int())
+        {
+            throw json_exception(__JSON_FUNCTION__);
+        }
+
+        return (json_uint)m_doc->m_tape[m_pos + 1];
+    }
+
+    json_uint json_element::as_uint(json_uint default_val) const
+    {
+        if (!is_int())
+        {
+            return default_val;
+        }
+
+        return (json_uint)m_doc->m_tape[m_pos + 1];
+    }
+
+    json_float json_element::as_float() const
+    {
+        json_float val = 0;
+
+        if (!is_float())
+        {
+            throw json_exception(__JSON_FUNCTION__);
+        }
+
+        memcpy(&val, &m_doc->m_tape[m_pos + 1], sizeof(val));
+        return val;
+    }
+
+    json_float json_element::as_float(json_float default_val) const
+    {
+        if (!is_float())
+        {
+            return default_val;
+        }
+
+        return as_float();
+    }
+
+    json_float json_element::as_number() const
+    {
+        if (!is_number())
+        {
+            throw json_exception(__JSON_FUNCTION__);
+        }
+
+        switch (json_document::_tag(_entry()))
+        {
+        case json_document::json_tape_int:
+            return (json_float)(json_int)m_doc->m_tape[m_pos + 1];
+        case json_document::json_tape_uint:
+            return (json_float)m_doc->m_tape[m_pos + 1];
+        default:
+            break;
+        }
+
+        return as_float();
+    }
+
+    json_float json_element::as_number(json_float default_val) const
+    {
+        if (!is_number())
+        {
+            return default_val;
+        }
+
+        return as_number();
+    }
+
+    _tstring json_element::as_string() const
+    {
+        if (!is_string())
+        {
+            throw json_exception(__JSON_FUNCTION__);
+        }
+
+        return _tstring(string_data(), string_size());
+    }
+
+    _tstring json_element::as_string(const _tstring& default_val) const
+    {
+        if (!is_string())
+        {
+            return default_val;
+        }
+
+        return _tstring(string_data(), string_size());
+    }
+
+    const _tchar* json_element::string_data() const
+    {
+        if (!is_string())
+        {
+            return nullptr;
+        }
+
+        return m_doc->m_strings.data() + json_document::_payload(_entry());
+    }
+
+    size_t json_element::string_size() const
+    {
+        if (!is_string())
+        {
+            return 0;
+        }
+
+        return (size_t)m_doc->m_tape[m_pos + 1];
+    }
+
+    json_element json_element::operator [] (const _tstring& name) const
+    {
+        return find_field(name);
+    }
+
+    json_element json_element::operator [] (size_t index) const
+    {
+        return at(index);
+    }
+
+    json_element json_element::find_field(const _tstring& name) const
+    {
+        if (!is_object())
+        {
+            return json_element();
+        }
+
+        // Linear scan, the first of duplicate keys wins like json_value::parse
+        const uint64_t* tape_ptr = m_doc->m_tape.data();
+        const _tchar* string_ptr = m_doc->m_strings.data();
+        size_t end_pos = json_document::_payload(tape_ptr[m_pos]);
+        size_t pos = m_pos + 2;
+
+        while (pos < end_pos)
+        {
+            if (name.size() == tape_ptr[pos + 1] &&
+                0 == std::char_traits<_tchar>::compare(name.data(), string_ptr + json_document::_payload(tape_ptr[pos]), name.size()))
+            {
+                return json_element(m_doc, pos + 2);
+            }
+
+            pos = m_doc->_skip(pos + 2);
+        }
+
+        return json_element();
+    }
+
+    json_element json_element::at(size_t index) const
+    {
+        if (!is_array() || index >= count())
+        {
+            return json_element();
+        }
+
+        size_t pos = m_pos + 2;
+        while (index--)
+        {
+            pos = m_doc->_skip(pos);
         }
 
-        if (end_ptr)
+        return json_element(m_doc, pos);
+    }
+
+    json_element::iterator json_element::begin() const
+    {
+        if (!(is_object() || is_array()))
         {
-            *end_ptr = data_next_ptr;
+            return end();
+        }
+
+        return iterator(m_doc, m_pos + 2, is_object());
+    }
+
+    json_element::iterator json_element::end() const
+    {
+        if (!(is_object() || is_array()))
+        {
+            return iterator(m_doc, m_pos, false);
+        }
+
+        return iterator(m_doc, json_document::_payload(_entry()), is_object());
+    }
+
+    size_t json_element::count() const
+    {
+        if (!(is_object() || is_array()))
+        {
+            return 0;
+        }
+
+        return (size_t)m_doc->m_tape[m_pos + 1];
+    }
+
+    json_value json_element::to_value() const
+    {
+        json_value val(json_type::json_type_null);
+        get_value(val);
+        return val;
+    }
+
+    bool json_element::get_value(json_value& val) const
+    {
+        if (nullptr == m_doc)
+        {
+            return false;
         }
 
+#ifdef FC_JSON_INTERN_KEYS
+        json_key_pool key_pool;
+        return m_doc->_get_value(m_pos, val, key_pool);
+#else
+        return m_doc->_get_value(m_pos, val);
+#endif
+    }
+
+    json_document::json_tape_handler::json_tape_handler(json_document& doc) :
+        m_doc(doc)
+    {
+    }
+
+    bool json_document::json_tape_handler::null_value()
+    {
+        _add_value();
+        m_doc.m_tape.push_back(_make_entry(json_tape_null, 0));
         return true;
     }
 
-    bool json_value::_parse_raw(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val)
+    bool json_document::json_tape_handler::bool_value(json_bool val)
     {
-        const uint8_t* date_value_ptr = data_ptr + sizeof(json_raw_type);
-        const uint8_t* data_next_ptr = data_ptr;
-        bool parse_result = true;
+        _add_value();
+        m_doc.m_tape.push_back(_make_entry(val ? json_tape_true : json_tape_false, 0));
+        return true;
+    }
 
-        switch (*data_next_ptr)
+    bool json_document::json_tape_handler::int_value(json_int val)
+    {
+        _add_value();
+        m_doc.m_tape.push_back(_make_entry(json_tape_int, 0));
+        m_doc.m_tape.push_back((uint64_t)val);
+        return true;
+    }
+
+    bool json_document::json_tape_handler::uint_value(json_uint val)
+    {
+        _add_value();
+        m_doc.m_tape.push_back(_make_entry(json_tape_uint, 0));
+        m_doc.m_tape.push_back(val);
+        return true;
+    }
+
+    bool json_document::json_tape_handler::float_value(json_float val)
+    {
+        uint64_t bits = 0;
+
+        memcpy(&bits, &val, sizeof(bits));
+        _add_value();
+        m_doc.m_tape.push_back(_make_entry(json_tape_float, 0));
+        m_doc.m_tape.push_back(bits);
+        return true;
+    }
+
+    bool json_document::json_tape_handler::string_value(_tstring& val)
+    {
+        _add_value();
+        _append_string(val);
+        return true;
+    }
+
+    bool json_document::json_tape_handler::key(_tstring& val)
+    {
+        _append_string(val);
+        return true;
+    }
+
+    bool json_document::json_tape_handler::start_object()
+    {
+        return _start(json_tape_object);
+    }
+
+    bool json_document::json_tape_handler::end_object()
+    {
+        return _end(json_tape_object, json_tape_object_end);
+    }
+
+    bool json_document::json_tape_handler::start_array()
+    {
+        return _start(json_tape_array);
+    }
+
+    bool json_document::json_tape_handler::end_array()
+    {
+        return _end(json_tape_array, json_tape_array_end);
+    }
+
+    inline void json_document::json_tape_handler::_add_value()
+    {
+        // Member count of the innermost container, kept in the entry after its start
+        if (!m_doc.m_stack.empty())
         {
-        case json_raw_type::raw_null:
-            val = json_type::json_type_null;
-            data_next_ptr += sizeof(json_raw_type);
-            break;
-        case json_raw_type::raw_false:
-            val = false;
-            data_next_ptr += sizeof(json_raw_type);
-            break;
-        case json_raw_type::raw_true:
-            val = true;
-            data_next_ptr += sizeof(json_raw_type);
-            break;
-        case json_raw_type::raw_int8:
-            val = *(int8_t*)date_value_ptr;
-            data_next_ptr += sizeof(json_raw_type) + sizeof(int8_t);
-            break;
-        case json_raw_type::raw_int16:
-            val = *(int16_t*)date_value_ptr;
-            data_next_ptr += sizeof(json_raw_type) + sizeof(int16_t);
-            break;
-        case json_raw_type::raw_int32:
-            val = *(int32_t*)date_value_ptr;
-            data_next_ptr += sizeof(json_raw_type) + sizeof(int32_t);
-            break;
-        case json_raw_type::raw_int64:
-            val = *(int64_t*)date_value_ptr;
-            data_next_ptr += sizeof(json_raw_type) + sizeof(int64_t);
-            break;
-        case json_raw_type::raw_uint8:
-            val = *(uint8_t*)date_value_ptr;
-            data_next_ptr += sizeof(json_raw_type) + sizeof(uint8_t);
-            break;
-        case json_raw_type::raw_uint16:
-            val = *(uint16_t*)date_value_ptr;
-            data_next_ptr += sizeof(json_raw_type) + sizeof(uint16_t);
-            break;
-        case json_raw_type::raw_uint32:
-            val = *(uint32_t*)date_value_ptr;
-            data_next_ptr += sizeof(json_raw_type) + sizeof(uint32_t);
-            break;
-        case json_raw_type::raw_uint64:
-            val = *(uint64_t*)date_value_ptr;
-            data_next_ptr += sizeof(json_raw_type) + sizeof(uint64_t);
-            break;
-        case json_raw_type::raw_float:
-            val = *(double*)date_value_ptr;
-            data_next_ptr += sizeof(json_raw_type) + sizeof(double);
-            break;
-        case json_raw_type::raw_string_empty:
-        case json_raw_type::raw_string8:
-        case json_raw_type::raw_string16:
-        case json_raw_type::raw_string32:
-            parse_result = _parse_raw_string(data_next_ptr, &data_next_ptr, val);
-            break;
-        case json_raw_type::raw_bin_empty:
-        case json_raw_type::raw_bin8:
-        case json_raw_type::raw_bin16:
-        case json_raw_type::raw_bin32:
-            parse_result = _parse_raw_bin(data_next_ptr, &data_next_ptr, val);
-            break;
-        case json_raw_type::raw_object_empty:
-            val._reset_type(json_type::json_type_object);
-            data_next_ptr += sizeof(json_raw_type);
+            m_doc.m_tape[m_doc.m_stack.back() + 1]++;
+        }
+    }
+
+    inline void json_document::json_tape_handler::_append_string(const _tstring& val)
+    {
+        m_doc.m_tape.push_back(_make_entry(json_tape_string, m_doc.m_strings.size()));
+        m_doc.m_tape.push_back(val.size());
+        m_doc.m_strings.insert(m_doc.m_strings.end(), val.begin(), val.end());
+        m_doc.m_strings.push_back(_T('\0'));
+    }
+
+    bool json_document::json_tape_handler::_start(json_tape_tag tag)
+    {
+        _add_value();
+        m_doc.m_stack.push_back(m_doc.m_tape.size());
+        m_doc.m_tape.push_back(_make_entry(tag, 0));
+        m_doc.m_tape.push_back(0);
+        return true;
+    }
+
+    bool json_document::json_tape_handler::_end(json_tape_tag start_tag, json_tape_tag end_tag)
+    {
+        if (m_doc.m_stack.empty())
+        {
+            return false;
+        }
+
+        size_t start_pos = m_doc.m_stack.back();
+        if (start_tag != _tag(m_doc.m_tape[start_pos]))
+        {
+            return false;
+        }
+
+        m_doc.m_stack.pop_back();
+        m_doc.m_tape[start_pos] = _make_entry(start_tag, m_doc.m_tape.size());
+        m_doc.m_tape.push_back(_make_entry(end_tag, start_pos));
+        return true;
+    }
+
+    json_document::json_document()
+    {
+    }
+
+    bool json_document::parse(const _tstring& text)
+    {
+        return parse(text.data(), text.size());
+    }
+
+    bool json_document::parse(const _tchar* data, size_t size)
+    {
+        clear();
+        if (nullptr == data)
+        {
+            return false;
+        }
+
+        // Unescaped strings with their terminators never outgrow the quoted text,
+        // the tape is a guess and grows if a document is denser than that
+        m_strings.reserve(size);
+        m_tape.reserve(size / 8 + 16);
+
+        json_tape_handler handler(*this);
+        json_sax_reader<json_tape_handler> reader(handler);
+        if (!reader.parse(data, data + size, nullptr))
+        {
+            clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    json_element json_document::root() const
+    {
+        if (m_tape.empty())
+        {
+            return json_element();
+        }
+
+        return json_element(this, 0);
+    }
+
+    json_element json_document::operator [] (const _tstring& name) const
+    {
+        return root()[name];
+    }
+
+    json_element json_document::operator [] (size_t index) const
+    {
+        return root()[index];
+    }
+
+    json_value json_document::to_value() const
+    {
+        return root().to_value();
+    }
+
+    size_t json_document::tape_size() const
+    {
+        return m_tape.size() * sizeof(uint64_t);
+    }
+
+    size_t json_document::string_size() const
+    {
+        return m_strings.size() * sizeof(_tchar);
+    }
+
+    void json_document::clear()
+    {
+        m_tape.clear();
+        m_strings.clear();
+        m_stack.clear();
+    }
+
+    inline uint8_t json_document::_tag(uint64_t entry)
+    {
+        return (uint8_t)(entry >> 56);
+    }
+
+    inline size_t json_document::_payload(uint64_t entry)
+    {
+        return (size_t)(entry & json_tape_payload_mask);
+    }
+
+    inline uint64_t json_document::_make_entry(json_tape_tag tag, size_t payload)
+    {
+        return ((uint64_t)tag << 56) | (uint64_t)payload;
+    }
+
+    size_t json_document::_skip(size_t pos) const
+    {
+        uint64_t entry = m_tape[pos];
+
+        switch (_tag(entry))
+        {
+        case json_tape_int:
+        case json_tape_uint:
+        case json_tape_float:
+        case json_tape_string:
+            return pos + 2;
+        case json_tape_object:
+        case json_tape_array:
+            return _payload(entry) + 1;
+        default:
             break;
-        case json_raw_type::raw_object_beg:
-            parse_result = _parse_raw_object(date_value_ptr, &data_next_ptr, val);
+        }
+
+        return pos + 1;
+    }
+
+#ifdef FC_JSON_INTERN_KEYS
+    bool json_document::_get_value(size_t pos, json_value& val, json_key_pool& key_pool) const
+#else
+    bool json_document::_get_value(size_t pos, json_value& val) const
+#endif
+    {
+        uint64_t entry = m_tape[pos];
+        size_t end_pos = 0;
+
+        switch (_tag(entry))
+        {
+        case json_tape_true:
+        case json_tape_false:
+            val = json_tape_true == _tag(entry);
             break;
-        case json_raw_type::raw_object_end:
-            data_next_ptr += sizeof(json_raw_type);
+        case json_tape_int:
+            val = (json_int)m_tape[pos + 1];
             break;
-        case json_raw_type::raw_array_empty:
-            val._reset_type(json_type::json_type_array);
-            data_next_ptr += sizeof(json_raw_type);
+        case json_tape_uint:
+            val = (json_uint)m_tape[pos + 1];
             break;
-        case json_raw_type::raw_array_beg:
-            parse_result = _parse_raw_array(date_value_ptr, &data_next_ptr, val);
+        case json_tape_float:
+            val = json_element(this, pos).as_float();
             break;
-        case json_raw_type::raw_array_end:
-            data_next_ptr += sizeof(json_raw_type);
+        case json_tape_string:
+            val._reset_string(m_strings.data() + _payload(entry), (size_t)m_tape[pos + 1]);
             break;
-        default:
-            return false;
-        }
-
-        if (!parse_result)
+        case json_tape_array:
         {
-            return parse_result;
-        }
+            val._reset_type(json_type::json_type_array);
+            if (nullptr == val.m_long.data._array_ptr)
+            {
+                return false;
+            }
 
-        if (end_ptr)
+            json_array& array = *val.m_long.data._array_ptr;
+            array.reserve((size_t)m_tape[pos + 1]);
+            end_pos = _payload(entry);
+            for (pos += 2; pos < end_pos; pos = _skip(pos))
+            {
+                array.emplace_back(json_type::json_type_null);
+#ifdef FC_JSON_INTERN_KEYS
+                if (!_get_value(pos, array.back(), key_pool))
+#else
+                if (!_get_value(pos, array.back()))
+#endif
+                {
+                    return false;
+                }
+            }
+        }
+        break;
+        case json_tape_object:
         {
-            *end_ptr = data_next_ptr;
+            val._reset_type(json_type::json_type_object);
+            if (nullptr == val.m_long.data._object_ptr)
+            {
+                return false;
+            }
+
+            json_object& object = *val.m_long.data._object_ptr;
+#if defined(FC_JSON_FLAT_OBJECT) || defined(FC_JSON_HASH_OBJECT)
+            object.reserve((size_t)m_tape[pos + 1]);
+#endif
+            end_pos = _payload(entry);
+            for (pos += 2; pos < end_pos; pos = _skip(pos + 2))
+            {
+                _tstring name(m_strings.data() + _payload(m_tape[pos]), (size_t)m_tape[pos + 1]);
+                json_value value_data(json_type::json_type_null);
+#ifdef FC_JSON_INTERN_KEYS
+                if (!_get_value(pos + 2, value_data, key_pool))
+                {
+                    return false;
+                }
+
+                object.emplace(key_pool.intern(name), std::move(value_data));
+#else
+                if (!_get_value(pos + 2, value_data))
+                {
+                    return false;
+                }
+
+                object.emplace(std::move(name), std::move(value_data));
+#endif
+            }
+        }
+        break;
+        default:
+            val = nullptr;
+            break;
         }
 
         return true;
     }
 
-    std::vector<uint8_t> json_value::dump_to_binary()
+    // A run of whole lines, split and parsed by one thread
+    struct json_ndjson_batch
+    {
+        const uint8_t*                      data;           // First character
+        size_t                              size;           // Bytes
+        size_t                              line_count;     // Newlines in the batch
+        size_t                              line_base;      // Lines before the batch
+        bool                                counted;        // line_count is set
+        bool                                based;          // line_base is set
+        bool                                parsed;         // records are complete
+        std::vector<json_ndjson_record>     records;        // Parsed lines, line numbers within the batch
+    };
+
+    struct json_ndjson_reader::json_ndjson_state
+    {
+        json_file_view                                  file_view;      // Mapped file of open_file
+        const uint8_t*                                  data;           // Text
+        size_t                                          size;           // Text bytes
+        size_t                                          unit;           // Bytes per character, 1 for a UTF-8 file
+        size_t                                          cursor;         // Bytes split into batches so far
+        size_t                                          batch_count;    // Batches split and not yet read through
+        size_t                                          max_batches;    // Limit of batch_count
+        size_t                                          next_base;      // Lines before the first batch without a base
+        json_ndjson_options                             options;        // Options
+        std::mutex                                      mutex;          // Guards everything above but the text
+        std::condition_variable                         worker_cond;    // A batch was released, or stop
+        std::condition_variable                         reader_cond;    // A batch was counted or parsed
+        std::deque<std::unique_ptr<json_ndjson_batch>>  batches;        // In text order, not handed to the reader yet
+        std::vector<std::thread>                        threads;        // Parse threads
+        std::unique_ptr<json_ndjson_batch>              current;        // Batch being read
+        size_t                                          record_pos;     // Next record of current
+        bool                                            stop;           // close() was called
+    };
+
+    json_ndjson_reader::json_ndjson_reader() :
+        m_state(nullptr)
     {
-        std::vector<uint8_t> result;
-        _dump_raw(result);
-        return result;
     }
 
-    bool json_value::dump_to_binary_file(const _tstring& strPath)
+    json_ndjson_reader::~json_ndjson_reader()
     {
-        std::vector<uint8_t> result;
-        _dump_raw(result);
+        close();
+    }
 
-        std::ofstream output_file(strPath, std::ios::binary | std::ios::out);
-        if (!output_file.is_open())
+    bool json_ndjson_reader::open(const _tchar* data, size_t size, const json_ndjson_options& options/* = json_ndjson_options()*/)
+    {
+        close();
+
+        if (nullptr == data)
         {
             return false;
         }
 
-        output_file.write((char*)result.data(), result.size());
-        output_file.close();
+        m_state = new (std::nothrow) json_ndjson_state;
+        if (nullptr == m_state)
+        {
+            return false;
+        }
 
-        return true;
+        m_state->data = (const uint8_t*)data;
+        m_state->size = size * sizeof(_tchar);
+        m_state->unit = sizeof(_tchar);
+        return _start(options);
     }
 
-    json_value& json_value::_get_none_value()
+    bool json_ndjson_reader::open(const _tstring& text, const json_ndjson_options& options/* = json_ndjson_options()*/)
     {
-        static json_value val(json_type::json_type_null);
-        return val;
+        return open(text.data(), text.size(), options);
     }
 
-    bool _skip_digit(const _tchar* data_ptr, const _tchar** end_ptr)
+    bool json_ndjson_reader::open_file(const _tstring& file_path, const json_ndjson_options& options/* = json_ndjson_options()*/)
     {
-        if (0 == _json_istdigit(*data_ptr))
+        close();
+
+        m_state = new (std::nothrow) json_ndjson_state;
+        if (nullptr == m_state)
         {
             return false;
         }
 
-        while (_json_istdigit(*data_ptr))
+        if (!m_state->file_view.open(file_path))
         {
-            data_ptr++;
+            close();
+            return false;
         }
 
-        *end_ptr = data_ptr;
-
-        return true;
+        m_state->data = m_state->file_view.data();
+        m_state->size = m_state->file_view.size();
+        m_state->unit = 1;
+        return _start(options);
     }
 
-    bool json_value::_parse_object(const _tchar* data_ptr, json_value& val, const _tchar** end_ptr)
+    bool json_ndjson_reader::next(json_ndjson_record& record)
     {
-        bool result_flag = false;
-
-        if (_T('{') == *data_ptr)
+        if (nullptr == m_state)
         {
-            data_ptr++;
+            return false;
         }
 
-        val._reset_type(json_type::json_type_object);
-        _tstring value_name;
-        while (_T('\0') != *data_ptr)
+        json_ndjson_state& state = *m_state;
+        while (true)
         {
-            data_ptr = _skip_whitespace(data_ptr);
-            if (_T('}') == *data_ptr)
+            if (state.current && state.record_pos < state.current->records.size())
             {
-                result_flag = true;
-                data_ptr++;
-                break;
+                record = std::move(state.current->records[state.record_pos++]);
+                record.line += state.current->line_base;
+                return true;
             }
 
-            value_name.clear();
-            if (!_parse_string(data_ptr, value_name, &data_ptr))
-            {
-                break;
-            }
+            // Freed after the lock is released
+            std::unique_ptr<json_ndjson_batch> done_batch(std::move(state.current));
+            std::unique_lock<std::mutex> lock(state.mutex);
 
-            data_ptr = _skip_whitespace(data_ptr);
-            if (_T(':') != *data_ptr)
+            if (done_batch)
             {
-                break;
+                state.batch_count--;
+                state.worker_cond.notify_one();
             }
-            data_ptr++;
 
-            json_value value_data;
-            if (!_parse_value(data_ptr, value_data, &data_ptr))
+            while (true)
             {
-                break;
-            }
+                // A batch's first line number is known once all batches before it are counted
+                for (auto& batch : state.batches)
+                {
+                    if (batch->based)
+                    {
+                        continue;
+                    }
 
-            if (val.m_data._object_ptr)
-            {
-                val.m_data._object_ptr->emplace(value_name, std::move(value_data));
-            }
+                    if (!batch->counted)
+                    {
+                        break;
+                    }
 
-            data_ptr = _skip_whitespace(data_ptr);
-            if (_T(',') == *data_ptr)
-            {
-                data_ptr++;
-            }
-            else if (_T('}') == *data_ptr)
-            {
-                result_flag = true;
-                data_ptr++;
-                break;
-            }
-            else
-            {
-                break;
-            }
-        }
+                    batch->line_base = state.next_base;
+                    batch->based = true;
+                    state.next_base += batch->line_count;
+                }
 
-        if (end_ptr)
-        {
-            *end_ptr = data_ptr;
-        }
+                auto it = state.batches.begin();
+                if (!state.options.ordered)
+                {
+                    while (it != state.batches.end() && !((*it)->parsed && (*it)->based))
+                    {
+                        it++;
+                    }
+                }
 
-        return result_flag;
+                if (it != state.batches.end() && (*it)->parsed && (*it)->based)
+                {
+                    state.current = std::move(*it);
+                    state.batches.erase(it);
+                    state.record_pos = 0;
+                    break;
+                }
+
+                if (state.stop || (state.batches.empty() && state.cursor >= state.size))
+                {
+                    return false;
+                }
+
+                state.reader_cond.wait(lock);
+            }
+        }
     }
 
-    bool json_value::_parse_array(const _tchar* data_ptr, json_value& val, const _tchar** end_ptr)
+    void json_ndjson_reader::close()
     {
-        bool result_flag = false;
+        if (nullptr == m_state)
+        {
+            return;
+        }
 
-        if (_T('[') == *data_ptr)
         {
-            data_ptr++;
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            m_state->stop = true;
         }
 
-        val._reset_type(json_type::json_type_array);
-        while (_T('\0') != *data_ptr)
+        m_state->worker_cond.notify_all();
+        for (auto& item : m_state->threads)
         {
-            data_ptr = _skip_whitespace(data_ptr);
-            if (_T(']') == *data_ptr)
-            {
-                result_flag = true;
-                data_ptr++;
-                break;
-            }
+            item.join();
+        }
 
-            json_value value_data;
-            if (!_parse_value(data_ptr, value_data, &data_ptr))
-            {
-                break;
-            }
+        delete m_state;
+        m_state = nullptr;
+    }
 
-            if (val.m_data._array_ptr)
-            {
-                val.m_data._array_ptr->emplace_back(std::move(value_data));
-            }
+    bool json_ndjson_reader::_start(const json_ndjson_options& options)
+    {
+        size_t thread_count = options.thread_count;
+        if (0 == thread_count)
+        {
+            thread_count = std::thread::hardware_concurrency();
+        }
 
-            data_ptr = _skip_whitespace(data_ptr);
-            if (_T(',') == *data_ptr)
-            {
-                data_ptr++;
-            }
-            else if (_T(']') == *data_ptr)
-            {
-                result_flag = true;
-                data_ptr++;
-                break;
-            }
-            else
-            {
-                break;
-            }
+        if (0 == thread_count)
+        {
+            thread_count = 1;
         }
 
-        if (end_ptr)
+        m_state->options = options;
+        m_state->options.batch_size = options.batch_size ? options.batch_size : 1;
+        m_state->cursor = 0;
+        m_state->batch_count = 0;
+        m_state->max_batches = options.max_batches ? options.max_batches : thread_count * 4;
+        m_state->next_base = 0;
+        m_state->record_pos = 0;
+        m_state->stop = false;
+
+        for (size_t i = 0; i < thread_count; i++)
         {
-            *end_ptr = data_ptr;
+            m_state->threads.emplace_back(_worker, m_state);
         }
 
-        return result_flag;
+        return true;
     }
 
-    bool json_value::_parse_value(const _tchar* data_ptr, json_value& val, const _tchar** end_ptr)
+    void json_ndjson_reader::_worker(json_ndjson_state* state)
     {
-        data_ptr = _skip_whitespace(data_ptr);
-        bool result_flag = false;
-        bool abort_flag = false;
+        std::unique_lock<std::mutex> lock(state->mutex);
 
-        do
+        while (!state->stop && state->cursor < state->size)
         {
-            _tchar ch = *data_ptr;
-
-            switch (ch)
+            if (state->batch_count >= state->max_batches)
             {
-            case _T('{'):
+                state->worker_cond.wait(lock);
+                continue;
+            }
+
+            // Take whole lines, the cut is the first newline past batch_size
+            size_t begin_pos = state->cursor;
+            size_t end_pos = begin_pos + std::min(state->options.batch_size * state->unit, state->size - begin_pos);
+            if (end_pos < state->size)
             {
-                if (!_parse_object(data_ptr, val, &data_ptr))
+                if (1 == state->unit)
                 {
-                    abort_flag = true;
-                    break;
+                    const void* found_ptr = memchr(state->data + end_pos, '\n', state->size - end_pos);
+                    end_pos = found_ptr ? (const uint8_t*)found_ptr - state->data + 1 : state->size;
                 }
-            }
-            break;
-            case _T('['):
-            {
-                if (!_parse_array(data_ptr, val, &data_ptr))
+                else
                 {
-                    abort_flag = true;
-                    break;
+                    const _tchar* text_ptr = (const _tchar*)(state->data + end_pos);
+                    const _tchar* found_ptr = std::char_traits<_tchar>::find(text_ptr, (state->size - end_pos) / sizeof(_tchar), _T('\n'));
+                    end_pos = found_ptr ? (const uint8_t*)(found_ptr + 1) - state->data : state->size;
                 }
             }
-            break;
-            case _T('\"'):
+
+            json_ndjson_batch* batch = new (std::nothrow) json_ndjson_batch();
+            if (nullptr == batch)
             {
-                _tstring str_value;
-                if (!_parse_string(data_ptr, str_value, &data_ptr))
-                {
-                    abort_flag = true;
-                    break;
-                }
-                val = std::move(str_value);
+                break;
             }
-            break;
-            case _T('-'):
+
+            batch->data = state->data + begin_pos;
+            batch->size = end_pos - begin_pos;
+            state->cursor = end_pos;
+            state->batch_count++;
+            state->batches.emplace_back(batch);
+            if (state->cursor >= state->size)
             {
-                if (!_parse_number(data_ptr, val, &data_ptr))
-                {
-                    abort_flag = true;
-                    break;
-                }
+                // Nothing left to split, let waiting threads exit
+                state->worker_cond.notify_all();
             }
-            break;
-            default:
+            lock.unlock();
+
+            const _tchar* text_ptr = (const _tchar*)batch->data;
+            size_t text_size = batch->size / sizeof(_tchar);
+            bool flag_text = true;
+
+#ifdef _UNICODE
+            std::wstring text;
+            if (1 == state->unit)
             {
-                if (_json_istdigit(ch))
-                {
-                    if (!_parse_number(data_ptr, val, &data_ptr))
-                    {
-                        abort_flag = true;
-                        break;
-                    }
-                }
-                else if (0 == _json_tcsncmp(_T("null"), data_ptr, 4))
-                {
-                    val = json_value(json_type::json_type_null);
-                    data_ptr += 4;
-                }
-                else if (0 == _json_tcsncmp(_T("true"), data_ptr, 4))
-                {
-                    val = true;
-                    data_ptr += 4;
-                }
-                else if (0 == _json_tcsncmp(_T("false"), data_ptr, 5))
+                flag_text = _utf8_to_utf16(batch->data, batch->size, &text);
+                text_ptr = text.data();
+                text_size = text.size();
+            }
+#endif
+
+            // Counted first so that later batches get their line numbers early in unordered mode
+            size_t line_count = flag_text ? std::count(text_ptr, text_ptr + text_size, _T('\n')) : std::count(batch->data, batch->data + batch->size, '\n');
+            lock.lock();
+            batch->line_count = line_count;
+            batch->counted = true;
+            state->reader_cond.notify_one();
+            lock.unlock();
+
+            if (!flag_text)
+            {
+                // Not UTF-8, reported on the first line of the batch
+                batch->records.emplace_back();
+                batch->records.back().line = 1;
+            }
+
+            const _tchar* line_ptr = text_ptr;
+            const _tchar* text_end = text_ptr + text_size;
+            size_t line = 1;
+            while (flag_text && line_ptr < text_end)
+            {
+                const _tchar* line_end = std::char_traits<_tchar>::find(line_ptr, text_end - line_ptr, _T('\n'));
+                if (nullptr == line_end)
                 {
-                    val = false;
-                    data_ptr += 5;
+                    line_end = text_end;
                 }
-                else
+
+                if (_skip_whitespace(line_ptr, line_end) < line_end)
                 {
-                    abort_flag = true;
-                    break;
+                    batch->records.emplace_back();
+                    json_ndjson_record& record = batch->records.back();
+                    record.line = line;
+                    record.valid = record.value.parse(line_ptr, line_end - line_ptr, state->options.flags);
                 }
-            }
-            break;
-            }
 
-            if (!abort_flag)
-            {
-                result_flag = true;
+                line_ptr = line_end + 1;
+                line++;
             }
 
-        } while (false);
+            lock.lock();
+            batch->parsed = true;
+            state->reader_cond.notify_one();
+        }
+    }
 
-        data_ptr = _skip_whitespace(data_ptr);
+    static bool _read_ndjson(json_ndjson_reader& reader, const std::function<bool(json_ndjson_record& record)>& callback)
+    {
+        json_ndjson_record record;
+        bool result_flag = true;
 
-        if (*end_ptr)
+        while (reader.next(record))
         {
-            *end_ptr = data_ptr;
+            result_flag = record.valid && result_flag;
+            if (!callback(record))
+            {
+                return false;
+            }
         }
 
         return result_flag;
     }
 
-    bool json_value::_parse(const _tchar* data_ptr, json_value& val, const _tchar** end_ptr)
+    bool parse_ndjson(const _tchar* data, size_t size, const std::function<bool(json_ndjson_record& record)>& callback, const json_ndjson_options& options/* = json_ndjson_options()*/)
     {
-        bool result_flag = false;
-        data_ptr = _skip_bom(data_ptr);
-        if (_parse_value(data_ptr, val, &data_ptr))
-        {
-            if (_T('\0') != *data_ptr)
-            {
-                val = json_type::json_type_null;
-            }
-            else
-            {
-                result_flag = true;
-            }
-        }
+        json_ndjson_reader reader;
 
-        if (!result_flag)
+        if (!reader.open(data, size, options))
         {
-            _reset_type(json_type::json_type_null);
+            return false;
         }
 
-        if (end_ptr)
+        return _read_ndjson(reader, callback);
+    }
+
+    bool parse_ndjson(const _tstring& text, const std::function<bool(json_ndjson_record& record)>& callback, const json_ndjson_options& options/* = json_ndjson_options()*/)
+    {
+        return parse_ndjson(text.data(), text.size(), callback, options);
+    }
+
+    bool parse_ndjson_file(const _tstring& file_path, const std::function<bool(json_ndjson_record& record)>& callback, const json_ndjson_options& options/* = json_ndjson_options()*/)
+    {
+        json_ndjson_reader reader;
+
+        if (!reader.open_file(file_path, options))
         {
-            *end_ptr = data_ptr;
+            return false;
         }
 
-        return result_flag;
+        return _read_ndjson(reader, callback);
     }
 
-    bool _get_utf16_code_point(const _tchar* data_ptr, uint32_t* code_point_ptr, const _tchar** end_ptr)
+    bool _get_utf16_code_point(const _tchar* data_ptr, const _tchar* data_end, uint32_t* code_point_ptr, const _tchar** end_ptr)
     {
         _tchar text_buffer[16] = { 0 };
         _tchar* ch_end_ptr = nullptr;
@@ -2643,7 +8758,7 @@ namespace fcjson
         do
         {
             int count = 0;
-            for (count = 0; count < 4; count++)
+            for (count = 0; count < 4 && data_ptr < data_end; count++)
             {
                 _tchar ch = *data_ptr;
                 if (0 == _json_istxdigit(ch))
@@ -2677,86 +8792,100 @@ namespace fcjson
         return result_flag;
     }
 
-    bool _get_unicode_string(_tstring& append_str, const _tchar* data_ptr, const _tchar** end_ptr)
+    // Code point of the non-ASCII character at data_ptr for \u escaping, returns the characters it
+    // takes, or 0 for a byte that does not start a valid UTF-8 sequence
+    size_t _get_escape_code_point(const _tchar* data_ptr, const _tchar* data_end, uint32_t* code_point_ptr)
     {
-        _utchar ch = *data_ptr;
+        uint32_t cp32 = (_utchar)*data_ptr;
+        size_t byte_count = 1;
 
-#ifdef _UNICODE
-        _tchar text_buffer[32] = { 0 };
-        _json_stprintf_s(text_buffer, sizeof(text_buffer) / sizeof(_tchar), _T(R"(\u%.4x)"), ch);
-        append_str += text_buffer;
-        data_ptr++;
+#ifndef _UNICODE
+        if (cp32 >= 0xF8)
+        {
+            return 0;
+        }
+        else if (cp32 >= 0xF0)
+        {
+            byte_count = 4;
+            cp32 &= 0x07;
+        }
+        else if (cp32 >= 0xE0)
+        {
+            byte_count = 3;
+            cp32 &= 0x0F;
+        }
+        else if (cp32 >= 0xC0)
+        {
+            byte_count = 2;
+            cp32 &= 0x1F;
+        }
+        else
+        {
+            return 0;
+        }
 
-#else
-        if (ch >= 0xC0)
+        if ((size_t)(data_end - data_ptr) < byte_count)
         {
-            // The number of bytes used to obtain characters.
-            size_t byte_count = 0;
-            uint32_t cp32 = 0;
+            return 0;
+        }
 
-            if (ch >= 0xE0 && ch <= 0xEF)
-            {
-                byte_count = 3;
-                cp32 = ch & 0x0F;
-            }
-            else if (ch >= 0xC0 && ch <= 0xDF)
-            {
-                byte_count = 2;
-                cp32 = ch & 0x1F;
-            }
-            else if (ch >= 0xF0 && ch <= 0xF7)
-            {
-                byte_count = 4;
-                cp32 = ch & 0x07;
-            }
-            else if (ch >= 0xF8 && ch <= 0xFB)
-            {
-                byte_count = 5;
-                cp32 = ch & 0x03;
-            }
-            else if (ch >= 0xFC && ch <= 0xFD)
+        for (size_t i = 1; i < byte_count; i++)
+        {
+            uint8_t ch = (uint8_t)data_ptr[i];
+            if (0x80 != (ch & 0xC0))
             {
-                byte_count = 6;
-                cp32 = ch & 0x01;
+                return 0;
             }
 
-            if (0 == byte_count)
-            {
-                return false;
-            }
+            cp32 = (cp32 << 6) | (ch & 0x3F);
+        }
+#endif
+
+        *code_point_ptr = cp32;
+        return byte_count;
+    }
+
+    // The run of non-ASCII characters at data_ptr as \uXXXX, surrogate pairs above U+FFFF
+    // Bytes that do not start a valid UTF-8 sequence are copied as they are
+    void _append_unicode_escape(json_writer& append_str, const _tchar* data_ptr, const _tchar* data_end, const _tchar** end_ptr)
+    {
+        _tchar out_buffer[256];
+        size_t length = 0;
+
+        while (data_ptr < data_end && (_utchar)*data_ptr >= 0x80)
+        {
+            uint32_t cp32 = 0;
+            size_t byte_count = _get_escape_code_point(data_ptr, data_end, &cp32);
 
-            for (size_t i = 1; i < byte_count; i++)
+            if (0 == byte_count)
             {
-                cp32 = cp32 << 6;
-                cp32 |= data_ptr[i] & 0x3F;
+                out_buffer[length++] = *data_ptr++;
+                continue;
             }
 
-            char text_buffer[32] = { 0 };
-            if (cp32 < 0x10000)
+            if (cp32 >= 0x10000)
             {
-                snprintf(text_buffer, sizeof(text_buffer), R"(\u%.4x)", cp32);
-                append_str.append(text_buffer, 6);
+                cp32 -= 0x10000;
+                length += _put_escaped_code_unit(out_buffer + length, 0xD800 + ((cp32 >> 10) & 0x3FF));
+                length += _put_escaped_code_unit(out_buffer + length, 0xDC00 + (cp32 & 0x3FF));
             }
             else
             {
-                uint32_t cp = (uint16_t)(cp32 - 0x10000);
-                uint16_t cp32_high = (uint16_t)(cp >> 10) + 0xD800;
-                uint16_t cp32_low = (uint16_t)(cp & 0x3FF) + 0xDC00;
-
-                snprintf(text_buffer, sizeof(text_buffer), R"(\u%.4x\u%.4x)", cp32_high, cp32_low);
-                append_str.append(text_buffer, 12);
+                length += _put_escaped_code_unit(out_buffer + length, cp32);
             }
 
             data_ptr += byte_count;
-        }
-#endif
 
-        if (end_ptr)
-        {
-            *end_ptr = data_ptr;
+            // Room for one more surrogate pair
+            if (length > sizeof(out_buffer) / sizeof(_tchar) - 12)
+            {
+                append_str.append(out_buffer, length);
+                length = 0;
+            }
         }
 
-        return false;
+        append_str.append(out_buffer, length);
+        *end_ptr = data_ptr;
     }
 
     std::string _get_utf8_text_for_code_point(uint32_t cp32)
@@ -2819,343 +8948,527 @@ namespace fcjson
         return text_buffer;
     }
 
-    int32_t _utf8_to_utf16(const void* data_ptr, size_t size/* = -1*/, std::string* text_utf8_ptr/* = nullptr*/, std::wstring* text_utf16_ptr/* = nullptr*/)
+    // Writes cp32 as UTF-8, returns the byte count
+    inline size_t _put_utf8(char* out_ptr, uint32_t cp32)
     {
-        const uint8_t* ch_data_ptr = (const uint8_t*)data_ptr;
-        std::wstring text_out_utf16;
-        std::string text_out_utf8;
-        uint32_t cp32 = 0;
-        int32_t byte_count = 0;
-        int32_t ch_count = 0;
-        bool result_flag = true;
+        if (cp32 < 0x80)
+        {
+            out_ptr[0] = (char)cp32;
+            return 1;
+        }
 
-        if (text_utf8_ptr)
+        if (cp32 < 0x800)
         {
-            text_out_utf8 += *text_utf8_ptr;
+            out_ptr[0] = (char)(0xC0 | (cp32 >> 6));
+            out_ptr[1] = (char)(0x80 | (cp32 & 0x3F));
+            return 2;
         }
 
-        if (text_utf16_ptr)
+        if (cp32 < 0x10000)
         {
-            text_out_utf16 += *text_utf16_ptr;
+            out_ptr[0] = (char)(0xE0 | (cp32 >> 12));
+            out_ptr[1] = (char)(0x80 | ((cp32 >> 6) & 0x3F));
+            out_ptr[2] = (char)(0x80 | (cp32 & 0x3F));
+            return 3;
         }
 
-        if ((0xEF == ch_data_ptr[0]) && (0xBB == ch_data_ptr[1]) && (0xBF == ch_data_ptr[2]))
+        out_ptr[0] = (char)(0xF0 | (cp32 >> 18));
+        out_ptr[1] = (char)(0x80 | ((cp32 >> 12) & 0x3F));
+        out_ptr[2] = (char)(0x80 | ((cp32 >> 6) & 0x3F));
+        out_ptr[3] = (char)(0x80 | (cp32 & 0x3F));
+        return 4;
+    }
+
+    // Length of the UTF-8 sequence at data_ptr (1 - 4), 0 for overlong forms, surrogates, code points above U+10FFFF and truncated sequences
+    inline size_t _get_utf8_sequence(const uint8_t* data_ptr, const uint8_t* data_end, uint32_t* code_point_ptr)
+    {
+        uint8_t ch = *data_ptr;
+        uint8_t second_min = 0x80;
+        uint8_t second_max = 0xBF;
+        uint32_t cp32 = 0;
+        size_t byte_count = 0;
+
+        if (ch < 0x80)
         {
-            ch_data_ptr += 3;
+            *code_point_ptr = ch;
+            return 1;
+        }
 
-            if (-1 != size)
-            {
-                size -= 3;
-            }
+        // The second byte range excludes overlong forms, surrogates and code points above U+10FFFF
+        if (ch >= 0xC2 && ch <= 0xDF)
+        {
+            byte_count = 2;
+            cp32 = ch & 0x1F;
+        }
+        else if (ch >= 0xE0 && ch <= 0xEF)
+        {
+            byte_count = 3;
+            cp32 = ch & 0x0F;
+            second_min = 0xE0 == ch ? 0xA0 : 0x80;
+            second_max = 0xED == ch ? 0x9F : 0xBF;
+        }
+        else if (ch >= 0xF0 && ch <= 0xF4)
+        {
+            byte_count = 4;
+            cp32 = ch & 0x07;
+            second_min = 0xF0 == ch ? 0x90 : 0x80;
+            second_max = 0xF4 == ch ? 0x8F : 0xBF;
+        }
+        else
+        {
+            return 0;
         }
 
-        while ((0 != *ch_data_ptr) && (0 != size))
+        if ((size_t)(data_end - data_ptr) < byte_count || data_ptr[1] < second_min || data_ptr[1] > second_max)
         {
-            uint8_t ch = *ch_data_ptr;
+            return 0;
+        }
 
-            if (ch < 0x7F)
+        cp32 = (cp32 << 6) | (data_ptr[1] & 0x3F);
+        for (size_t i = 2; i < byte_count; i++)
+        {
+            if (0x80 != (data_ptr[i] & 0xC0))
             {
-                cp32 = ch;
-                ch_count++;
+                return 0;
             }
-            else
-            {
-                if (0 == byte_count)
-                {
-                    cp32 = 0;
-                    if (ch >= 0xC0)
-                    {
-                        if (ch >= 0xC0 && ch <= 0xDF)
-                        {
-                            byte_count = 2;
-                            cp32 = ch & 0x1F;
-                        }
-                        else if (ch >= 0xE0 && ch <= 0xEF)
-                        {
-                            byte_count = 3;
-                            cp32 = ch & 0x0F;
-                        }
-                        else if (ch >= 0xF0 && ch <= 0xF7)
-                        {
-                            byte_count = 4;
-                            cp32 = ch & 0x07;
-                        }
-                        else if (ch >= 0xF8 && ch <= 0xFB)
-                        {
-                            byte_count = 5;
-                            cp32 = ch & 0x03;
-                        }
-                        else if (ch >= 0xFC && ch <= 0xFD)
-                        {
-                            byte_count = 6;
-                            cp32 = ch & 0x01;
-                        }
-
-                        if (0 == byte_count)
-                        {
-                            result_flag = false;
-                            break;
-                        }
-
-                        byte_count--;
-                    }
-                    else
-                    {
-                        result_flag = false;
-                        break;
-                    }
-                }
-                else
-                {
-                    if (0x80 != (ch & 0xC0))
-                    {
-                        result_flag = false;
-                        break;
-                    }
 
-                    cp32 = cp32 << 6;
-                    cp32 |= ch & 0x3F;
+            cp32 = (cp32 << 6) | (data_ptr[i] & 0x3F);
+        }
+
+        *code_point_ptr = cp32;
+        return byte_count;
+    }
 
-                    byte_count--;
+    using json_utf8_validate_fn = bool(*)(const uint8_t* data_ptr, size_t size);
 
-                    if (0 == byte_count)
-                    {
-                        ch_count++;
-                    }
+#ifdef FC_JSON_SIMD_X86
+
+    // ASCII blocks are skipped 16 bytes at a time, the rest is checked by the scalar decoder
+    static bool _is_utf8_text_sse2(const uint8_t* data_ptr, size_t size)
+    {
+        const uint8_t* data_end = data_ptr + size;
+        uint32_t cp32 = 0;
+
+        while (data_ptr < data_end)
+        {
+            const uint8_t* block_end = data_end;
+            if (data_end - data_ptr >= 16)
+            {
+                if (0 == _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)data_ptr)))
+                {
+                    data_ptr += 16;
+                    continue;
                 }
+
+                block_end = data_ptr + 16;
             }
 
-            if (0 == byte_count)
+            while (data_ptr < block_end)
             {
-                if (text_utf8_ptr)
+                if (*data_ptr < 0x80)
                 {
-                    text_out_utf8 += std::move(_get_utf8_text_for_code_point(cp32));
+                    data_ptr++;
+                    continue;
                 }
 
-                if (text_utf16_ptr)
+                size_t byte_count = _get_utf8_sequence(data_ptr, data_end, &cp32);
+                if (0 == byte_count)
                 {
-                    if (cp32 < 0x10000)
-                    {
-                        text_out_utf16.push_back((uint16_t)(cp32 & 0xFFFF));
-                    }
-                    else
-                    {
-                        uint16_t cp = (uint16_t)(cp32 - 0x10000);
-                        uint16_t cp32_high = (uint16_t)(cp >> 10) + 0xD800;
-                        uint16_t cp32_low = (uint16_t)(cp & 0x3FF) + 0xDC00;
-
-                        text_out_utf16.push_back(cp32_high);
-                        text_out_utf16.push_back(cp32_low);
-                    }
+                    return false;
                 }
+
+                data_ptr += byte_count;
             }
+        }
 
-            ch_data_ptr++;
+        return true;
+    }
 
-            if (-1 != size)
+    // Keiser & Lemire lookup algorithm, "Validating UTF-8 In Less Than One Instruction Per Byte"
+    // Each byte and its predecessor select error bits from three nibble tables, a valid pair selects none
+    FC_JSON_TARGET_AVX2
+    static bool _is_utf8_text_avx2(const uint8_t* data_ptr, size_t size)
+    {
+        const uint8_t too_short = 1 << 0;           // Lead byte not followed by a continuation
+        const uint8_t too_long = 1 << 1;            // Continuation after ASCII
+        const uint8_t overlong_3 = 1 << 2;          // E0 80 - E0 9F
+        const uint8_t too_large = 1 << 3;           // Above U+10FFFF
+        const uint8_t surrogate = 1 << 4;           // ED A0 - ED BF
+        const uint8_t overlong_2 = 1 << 5;          // C0 - C1
+        const uint8_t too_large_1000 = 1 << 6;      // F5 80 - FF 8F
+        const uint8_t overlong_4 = 1 << 6;          // F0 80 - F0 8F
+        const uint8_t two_conts = 1 << 7;           // Continuation after a continuation
+        const uint8_t carry = too_short | too_long | two_conts;
+
+        // High nibble of the previous byte
+        static const uint8_t byte_1_high_table[16] =
+        {
+            too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+            two_conts, two_conts, two_conts, two_conts,
+            too_short | overlong_2,
+            too_short,
+            too_short | overlong_3 | surrogate,
+            too_short | too_large | too_large_1000 | overlong_4,
+        };
+
+        // Low nibble of the previous byte
+        static const uint8_t byte_1_low_table[16] =
+        {
+            carry | overlong_3 | overlong_2 | overlong_4,
+            carry | overlong_2,
+            carry,
+            carry,
+            carry | too_large,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000 | surrogate,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+        };
+
+        // High nibble of the current byte
+        static const uint8_t byte_2_high_table[16] =
+        {
+            too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+            too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+            too_long | overlong_2 | two_conts | overlong_3 | too_large,
+            too_long | overlong_2 | two_conts | surrogate | too_large,
+            too_long | overlong_2 | two_conts | surrogate | too_large,
+            too_short, too_short, too_short, too_short,
+        };
+
+        // A block ending in a lead byte needs continuations in the next block
+        static const uint8_t incomplete_table[32] =
+        {
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+        };
+
+        const __m256i byte_1_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)byte_1_high_table));
+        const __m256i byte_1_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)byte_1_low_table));
+        const __m256i byte_2_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)byte_2_high_table));
+        const __m256i incomplete_max = _mm256_loadu_si256((const __m256i*)incomplete_table);
+        const __m256i nibble_mask = _mm256_set1_epi8(0x0F);
+        const __m256i third_byte_min = _mm256_set1_epi8((char)(0xE0 - 0x80));
+        const __m256i fourth_byte_min = _mm256_set1_epi8((char)(0xF0 - 0x80));
+        const __m256i high_bit = _mm256_set1_epi8((char)0x80);
+        __m256i prev_input = _mm256_setzero_si256();
+        __m256i prev_incomplete = _mm256_setzero_si256();
+        __m256i error = _mm256_setzero_si256();
+        uint8_t tail_buffer[32] = { 0 };
+
+        for (size_t pos = 0; pos < size; pos += 32)
+        {
+            __m256i input;
+            if (size - pos >= 32)
+            {
+                input = _mm256_loadu_si256((const __m256i*)(data_ptr + pos));
+            }
+            else
             {
-                size--;
+                // The zero padding is ASCII, a truncated sequence at the end is an error
+                memcpy(tail_buffer, data_ptr + pos, size - pos);
+                input = _mm256_loadu_si256((const __m256i*)tail_buffer);
             }
-        }
 
-        if (!result_flag)
-        {
-            return -1;
-        }
+            if (0 == _mm256_movemask_epi8(input))
+            {
+                error = _mm256_or_si256(error, prev_incomplete);
+                prev_incomplete = _mm256_setzero_si256();
+            }
+            else
+            {
+                // The 1, 2 and 3 bytes before each byte
+                __m256i shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+                __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+                __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+                __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
 
-        if (text_utf8_ptr)
-        {
-            *text_utf8_ptr = std::move(text_out_utf8);
+                __m256i special = _mm256_and_si256(
+                    _mm256_and_si256(
+                        _mm256_shuffle_epi8(byte_1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble_mask)),
+                        _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, nibble_mask))
+                    ),
+                    _mm256_shuffle_epi8(byte_2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble_mask))
+                );
+
+                // Third and fourth bytes of 3 and 4 byte sequences must be the only continuations flagged two_conts
+                __m256i must_23 = _mm256_or_si256(_mm256_subs_epu8(prev2, third_byte_min), _mm256_subs_epu8(prev3, fourth_byte_min));
+                error = _mm256_or_si256(error, _mm256_xor_si256(_mm256_and_si256(must_23, high_bit), special));
+
+                prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+            }
+
+            prev_input = input;
         }
 
-        if (text_utf16_ptr)
+        error = _mm256_or_si256(error, prev_incomplete);
+        return 0 != _mm256_testz_si256(error, error);
+    }
+
+#else
+
+    static bool _is_utf8_text_scalar(const uint8_t* data_ptr, size_t size)
+    {
+        const uint8_t* data_end = data_ptr + size;
+        uint32_t cp32 = 0;
+
+        while (data_ptr < data_end)
         {
-            *text_utf16_ptr = std::move(text_out_utf16);
+            if (*data_ptr < 0x80)
+            {
+                data_ptr++;
+                continue;
+            }
+
+            size_t byte_count = _get_utf8_sequence(data_ptr, data_end, &cp32);
+            if (0 == byte_count)
+            {
+                return false;
+            }
+
+            data_ptr += byte_count;
         }
 
-        return ch_count;
+        return true;
+    }
+
+#endif
+
+    bool _is_utf8_text(const uint8_t* data_ptr, size_t size)
+    {
+#ifdef FC_JSON_SIMD_X86
+        static json_utf8_validate_fn validate_fn = _cpu_has_avx2() ? _is_utf8_text_avx2 : _is_utf8_text_sse2;
+#else
+        static json_utf8_validate_fn validate_fn = _is_utf8_text_scalar;
+#endif
+        return validate_fn(data_ptr, size);
     }
 
-    int32_t _utf16_to_utf8(const void* data_ptr, size_t size/* = -1*/, std::string* text_utf8_ptr/* = nullptr*/, std::wstring* text_utf16_ptr/* = nullptr*/)
+    bool _utf8_to_utf16(const uint8_t* data_ptr, size_t size, std::wstring* text_ptr)
     {
-        const uint16_t* ch_data_ptr = (const uint16_t*)data_ptr;
-        std::wstring text_out_utf16;
-        std::string text_out_utf8;
+        const uint8_t* data_end = data_ptr + size;
+        wchar_t out_buffer[1024];
+        size_t out_count = 0;
         uint32_t cp32 = 0;
-        uint16_t cp32_high = 0;
-        uint16_t cp32_low = 0;
-        uint16_t cp16 = 0;
-        int32_t byte_count = 0;
-        int32_t ch_count = 0;
-        bool flag_big_endian = false;
-        bool flag_little_endian = false;
-        bool result_flag = true;
 
-        if (text_utf8_ptr)
+        if (size >= 3 && 0xEF == data_ptr[0] && 0xBB == data_ptr[1] && 0xBF == data_ptr[2])
         {
-            text_out_utf8 += *text_utf8_ptr;
+            data_ptr += 3;
         }
 
-        if (text_utf16_ptr)
+        // Validation only, nothing to build
+        if (nullptr == text_ptr)
         {
-            text_out_utf16 += *text_utf16_ptr;
+            return _is_utf8_text(data_ptr, data_end - data_ptr);
         }
 
-        if (-1 != size)
+        text_ptr->clear();
+        text_ptr->reserve(data_end - data_ptr);
+
+        while (data_ptr < data_end)
         {
-            if ((size < 2) || (0 != (size % 2)))
+            // A step adds at most 16 units
+            if (out_count > sizeof(out_buffer) / sizeof(out_buffer[0]) - 16)
             {
-                return -1;
+                text_ptr->append(out_buffer, out_count);
+                out_count = 0;
             }
-        }
 
-        cp16 = *ch_data_ptr;
-        if (0xFFFE == cp16 || 0xFEFF == cp16)
-        {
-            if (0xFFFE == cp16)
+#ifdef FC_JSON_SIMD_X86
+            // ASCII blocks are widened 16 bytes at a time
+            if (data_end - data_ptr >= 16)
+            {
+                __m128i chars = _mm_loadu_si128((const __m128i*)data_ptr);
+                if (0 == _mm_movemask_epi8(chars))
+                {
+                    const __m128i zero = _mm_setzero_si128();
+                    __m128i low = _mm_unpacklo_epi8(chars, zero);
+                    __m128i high = _mm_unpackhi_epi8(chars, zero);
+                    wchar_t* out_ptr = out_buffer + out_count;
+
+                    if (2 == sizeof(wchar_t))
+                    {
+                        _mm_storeu_si128((__m128i*)out_ptr, low);
+                        _mm_storeu_si128((__m128i*)(out_ptr + 8), high);
+                    }
+                    else
+                    {
+                        _mm_storeu_si128((__m128i*)out_ptr, _mm_unpacklo_epi16(low, zero));
+                        _mm_storeu_si128((__m128i*)(out_ptr + 4), _mm_unpackhi_epi16(low, zero));
+                        _mm_storeu_si128((__m128i*)(out_ptr + 8), _mm_unpacklo_epi16(high, zero));
+                        _mm_storeu_si128((__m128i*)(out_ptr + 12), _mm_unpackhi_epi16(high, zero));
+                    }
+
+                    out_count += 16;
+                    data_ptr += 16;
+                    continue;
+                }
+            }
+#endif
+
+            if (*data_ptr < 0x80)
             {
-                flag_big_endian = true;
+                out_buffer[out_count++] = *data_ptr++;
+                continue;
             }
 
-            if (0xFEFF == cp16)
+            size_t byte_count = _get_utf8_sequence(data_ptr, data_end, &cp32);
+            if (0 == byte_count)
             {
-                flag_little_endian = true;
+                text_ptr->clear();
+                return false;
             }
 
-            ch_data_ptr++;
+            data_ptr += byte_count;
 
-            if (-1 != size)
+            // A 32-bit wchar_t holds the code point as is
+            if (cp32 >= 0x10000 && 2 == sizeof(wchar_t))
+            {
+                cp32 -= 0x10000;
+                out_buffer[out_count++] = (wchar_t)(0xD800 + (cp32 >> 10));
+                out_buffer[out_count++] = (wchar_t)(0xDC00 + (cp32 & 0x3FF));
+            }
+            else
             {
-                size -= 2;
+                out_buffer[out_count++] = (wchar_t)cp32;
             }
         }
 
-        while ((0 != *ch_data_ptr) && (0 != size))
+        text_ptr->append(out_buffer, out_count);
+        return true;
+    }
+
+    bool _utf16_to_utf8(const uint16_t* data_ptr, size_t count, std::string* text_ptr)
+    {
+        const uint16_t* data_end = data_ptr + count;
+        char out_buffer[4096];
+        size_t out_count = 0;
+        bool flag_big_endian = false;
+
+        // The BOM gives the byte order, native order without one
+        if (count > 0 && (0xFEFF == *data_ptr || 0xFFFE == *data_ptr))
+        {
+            flag_big_endian = 0xFFFE == *data_ptr;
+            data_ptr++;
+        }
+
+        if (text_ptr)
         {
-            cp16 = *ch_data_ptr;
+            text_ptr->clear();
+            text_ptr->reserve(data_end - data_ptr);
+        }
 
-            if (flag_big_endian)
+        while (data_ptr < data_end)
+        {
+            // A step adds at most 16 bytes, nothing is kept when only validating
+            if (out_count > sizeof(out_buffer) - 16)
             {
-                cp16 = ((cp16 >> 8) | (cp16 << 8));
+                if (text_ptr)
+                {
+                    text_ptr->append(out_buffer, out_count);
+                }
+                out_count = 0;
             }
 
-            if (!(cp16 >= 0xD800 && cp16 <= 0xDFFF))
+#ifdef FC_JSON_SIMD_X86
+            // ASCII blocks are narrowed 16 units at a time
+            if (data_end - data_ptr >= 16)
             {
-                if (cp32_high > 0)
+                __m128i low = _mm_loadu_si128((const __m128i*)data_ptr);
+                __m128i high = _mm_loadu_si128((const __m128i*)(data_ptr + 8));
+
+                if (flag_big_endian)
                 {
-                    result_flag = false;
-                    break;
+                    low = _mm_or_si128(_mm_slli_epi16(low, 8), _mm_srli_epi16(low, 8));
+                    high = _mm_or_si128(_mm_slli_epi16(high, 8), _mm_srli_epi16(high, 8));
                 }
 
-                cp32 = cp16;
-                ch_count++;
-            }
-            else
-            {
-                if (0 == byte_count)
+                __m128i non_ascii = _mm_and_si128(_mm_or_si128(low, high), _mm_set1_epi16((short)0xFF80));
+                if (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, _mm_setzero_si128())))
                 {
-                    if (cp16 >= 0xD800 && cp16 <= 0xDBFF)
-                    {
-                        cp32_high = (cp16 - 0xD800);
-                        byte_count = 1;
-                    }
-                    else
-                    {
-                        result_flag = false;
-                        break;
-                    }
+                    _mm_storeu_si128((__m128i*)(out_buffer + out_count), _mm_packus_epi16(low, high));
+                    out_count += 16;
+                    data_ptr += 16;
+                    continue;
                 }
-                else
-                {
-                    if (1 == byte_count)
-                    {
-                        if ((cp16 >= 0xDC00) && (cp16 <= 0xDFFF))
-                        {
-                            cp32_low = (cp16 - 0xDC00);
-                            cp32 = 0x10000 + ((uint32_t)cp32_high << 10 | cp32_low);
-                            cp32_low = 0;
-                            cp32_high = 0;
-                        }
-                        else
-                        {
-                            result_flag = false;
-                            break;
-                        }
-                    }
-
-                    byte_count--;
+            }
+#endif
 
-                    if (0 == byte_count)
-                    {
-                        ch_count++;
-                    }
-                }
+            uint32_t cp32 = *data_ptr++;
+            if (flag_big_endian)
+            {
+                cp32 = ((cp32 >> 8) | (cp32 << 8)) & 0xFFFF;
             }
 
-            if (0 == byte_count)
+            if (cp32 >= 0xD800 && cp32 <= 0xDFFF)
             {
-                if (text_utf8_ptr)
+                // A high surrogate followed by a low surrogate
+                uint32_t cp_low = data_ptr < data_end ? *data_ptr : 0;
+                if (flag_big_endian)
                 {
-                    text_out_utf8 += std::move(_get_utf8_text_for_code_point(cp32));
+                    cp_low = ((cp_low >> 8) | (cp_low << 8)) & 0xFFFF;
                 }
 
-                if (text_utf16_ptr)
+                if (cp32 > 0xDBFF || cp_low < 0xDC00 || cp_low > 0xDFFF)
                 {
-                    if (cp32 < 0x10000)
-                    {
-                        text_out_utf16.push_back((uint16_t)(cp32 & 0xFFFF));
-                    }
-                    else
+                    if (text_ptr)
                     {
-                        uint16_t cp = (uint16_t)(cp32 - 0x10000);
-                        uint16_t cpHi = (uint16_t)(cp >> 10) + 0xD800;
-                        uint16_t cp_low = (uint16_t)(cp & 0x3FF) + 0xDC00;
-
-                        text_out_utf16.push_back(cpHi);
-                        text_out_utf16.push_back(cp_low);
+                        text_ptr->clear();
                     }
+                    return false;
                 }
-            }
-
-            ch_data_ptr++;
 
-            if (-1 != size)
-            {
-                size -= 2;
+                data_ptr++;
+                cp32 = 0x10000 + ((cp32 - 0xD800) << 10) + (cp_low - 0xDC00);
             }
-        }
-
-        if (!result_flag)
-        {
-            return -1;
-        }
 
-        if (text_utf8_ptr)
-        {
-            *text_utf8_ptr = std::move(text_out_utf8);
+            out_count += _put_utf8(out_buffer + out_count, cp32);
         }
 
-        if (text_utf16_ptr)
+        if (text_ptr)
         {
-            *text_utf16_ptr = std::move(text_out_utf16);
+            text_ptr->append(out_buffer, out_count);
         }
 
-        return ch_count;
+        return true;
     }
 
-    std::string _utf16_to_utf8(const std::wstring utf16)
+    std::string _utf16_to_utf8(const std::wstring& utf16)
     {
         std::string str_utf8;
-        std::wstring str_utf16;
-        int32_t utf8_length = _utf16_to_utf8(utf16.data(), utf16.size() * sizeof(wchar_t), &str_utf8, &str_utf16);
+
+#if WCHAR_MAX > 0xFFFF
+        // A 32-bit wchar_t holds code points
+        char out_buffer[4];
+        str_utf8.reserve(utf16.size());
+        for (wchar_t ch : utf16)
+        {
+            uint32_t cp32 = (uint32_t)ch;
+            if (cp32 > 0x10FFFF || (cp32 >= 0xD800 && cp32 <= 0xDFFF))
+            {
+                return std::string();
+            }
+
+            str_utf8.append(out_buffer, _put_utf8(out_buffer, cp32));
+        }
+#else
+        _utf16_to_utf8((const uint16_t*)utf16.data(), utf16.size(), &str_utf8);
+#endif
+
         return str_utf8;
     }
 
-    std::wstring _utf8_to_utf16(const std::string utf8)
+    std::wstring _utf8_to_utf16(const std::string& utf8)
     {
-        std::string str_utf8;
         std::wstring str_utf16;
-        int32_t utf16_length = _utf8_to_utf16(utf8.data(), utf8.size() * sizeof(wchar_t), &str_utf8, &str_utf16);
+        _utf8_to_utf16((const uint8_t*)utf8.data(), utf8.size(), &str_utf16);
         return str_utf16;
     }
 
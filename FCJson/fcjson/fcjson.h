@@ -4,12 +4,30 @@
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <iosfwd>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <algorithm>
+#include <initializer_list>
+#include <functional>
+#include <new>
+#include <type_traits>
 #include <cfloat>
 
+#ifdef FC_JSON_INTERN_KEYS
+#include <unordered_map>
+#endif
+
+#if (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L
+#define FC_JSON_HAS_STRING_VIEW
+#include <string_view>
+#endif
+
 // VS sets the execution character set to UTF-8
 // Project Property Pages -> Configuration Properties -> C/C++ -> Command Line -> Additional Options (D)
 // Add /execution-charset:utf-8 or /utf-8
@@ -40,300 +58,1886 @@ using _utchar = unsigned char;
 #define _TEXT(x)    __T(x)
 
 #define FC_JSON_RETURN              "\n"
-#define FC_JSON_FLOAT_FORMAT        "%.16g"
 
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
-#define FC_JSON_INT64_FORMAT        "%lld"
-#define FC_JSON_UINT64_FORMAT       "%llu"
-#else
-#define FC_JSON_INT64_FORMAT        "%ld"
-#define FC_JSON_UINT64_FORMAT       "%lu"
+// Pass a json_arena to parse to place the containers of a document in large blocks, the arena must
+// outlive the values parsed into it
+
+// json_object is a std::map by default, define FC_JSON_FLAT_OBJECT for a vector sorted by key or
+// FC_JSON_HASH_OBJECT for a hash index over members in insertion order, which dump in that order
+// With either, insertion and removal invalidate references to other members of the object
+
+// Parsers reject text nested deeper than FC_JSON_MAX_DEPTH containers, define it to change the limit
+#ifndef FC_JSON_MAX_DEPTH
+#define FC_JSON_MAX_DEPTH           1024
 #endif
 
+// json_parse_parallel uses one thread per hardware thread, define FC_JSON_PARSE_THREADS to fix the count
+#ifndef FC_JSON_PARSE_THREADS
+#define FC_JSON_PARSE_THREADS       0
+#endif
+
+// Define FC_JSON_INTERN_KEYS to share object keys: each distinct key of a parsed document is stored once
+// and json_object is keyed by json_key, which converts to const _tstring&
+
 // JSON Parse / Dump
 // FlameCyclone
 namespace fcjson
 {
     class json_value;
-    using json_null = nullptr_t;
-    using json_bool = bool;
-    using json_int = int64_t;
-    using json_uint = uint64_t;
-    using json_float = double;
-    using json_string = _tstring;
-    using json_object = std::map<_tstring, json_value>;
-    using json_array = std::vector<json_value>;
-    using json_bin = std::vector<uint8_t>;
 
-    // Exception
-    class json_exception
+    // Monotonic allocator, memory is only released by reset() or the destructor
+    class json_arena
     {
     public:
-        json_exception(const _tstring& msg) :
-            m_msg(msg)
+
+        json_arena(size_t block_size = 64 * 1024);
+        json_arena(const json_arena&) = delete;
+        json_arena& operator = (const json_arena&) = delete;
+        ~json_arena();
+
+        // Returns nullptr when out of memory
+        void* allocate(size_t size, size_t align)
         {
+            uintptr_t begin_ptr = ((uintptr_t)m_cur_ptr + (align - 1)) & ~(uintptr_t)(align - 1);
+            if (m_cur_ptr && begin_ptr + size <= (uintptr_t)m_end_ptr)
+            {
+                m_cur_ptr = (uint8_t*)(begin_ptr + size);
+                return (void*)begin_ptr;
+            }
+
+            return _allocate_block(size, align);
         }
 
-        _tstring get_message() const
+        // Releases every block, values still using the arena become invalid
+        void reset();
+
+        // Bytes handed out
+        size_t used() const;
+
+        // Bytes held in blocks
+        size_t reserved() const;
+
+    private:
+
+        struct json_arena_block;
+
+        void* _allocate_block(size_t size, size_t align);
+
+    private:
+
+        json_arena_block*   m_block_ptr;        // Current block, linked to the previous ones
+        uint8_t*            m_cur_ptr;          // Next free byte in the current block
+        uint8_t*            m_end_ptr;          // End of the current block
+        size_t              m_block_size;       // Size of the next block
+        size_t              m_used;             // Bytes handed out by full blocks
+        size_t              m_reserved;         // Bytes held in blocks
+    };
+
+    // Container allocator taking memory from a json_arena, or from the heap without one
+    // Copies of containers go to the heap, deallocate leaves arena memory to the arena
+    template<typename T>
+    class json_allocator
+    {
+    public:
+
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::false_type;
+        using propagate_on_container_swap = std::false_type;
+        using is_always_equal = std::false_type;
+
+        json_allocator() noexcept :
+            m_arena(nullptr)
         {
-            return m_msg;
         }
 
-        _tstring get_text_pos() const
+        json_allocator(json_arena* arena) noexcept :
+            m_arena(arena)
         {
-            return m_msg;
         }
 
-    private:
-        _tstring    m_msg;      // Message
-    };
+        template<typename U>
+        json_allocator(const json_allocator<U>& r) noexcept :
+            m_arena(r.arena())
+        {
+        }
 
-    // JSON Data type
-    enum json_type :uint8_t
-    {
-        json_type_null,              // null
-        json_type_bool,              // true Or false
-        json_type_int,               // 0 - 9223372036854775807 Or -1 - (9223372036854775807 - 1)
-        json_type_uint,              // 0 - 18446744073709551615
-        json_type_float,             // 3.141592653589793
-        json_type_string,            // "FlameCyclone"
-        json_type_object,            // [128,256,512,1204,"string",{"name":"FlameCyclone"}]
-        json_type_array,             // {"name":"FlameCyclone"}
-        json_type_bin,               // binary data
-    };
+        T* allocate(size_t count)
+        {
+            if (nullptr == m_arena)
+            {
+                return static_cast<T*>(::operator new(count * sizeof(T)));
+            }
 
-    // JSON Bin Tpye
-    enum json_raw_type :uint8_t
-    {
-        raw_null            = 0x10, // Null
-        raw_false           = 0x20, // Boolean false
-        raw_true            = 0x30, // Boolean true
+            void* data_ptr = m_arena->allocate(count * sizeof(T), alignof(T));
+            if (nullptr == data_ptr)
+            {
+                throw std::bad_alloc();
+            }
 
-        raw_int8            = 0x40, // Signed int, value: [-128,-1]                 and [0,127]
-        raw_int16           = 0x41, // Signed int, value: [-32768,-1]               and [0,32767]
-        raw_int32           = 0x42, // Signed int, value: [-2147483648,-1]          and [0,2147483647]
-        raw_int64           = 0x43, // Signed int, value: [-9223372036854775808,-1] and [0,9223372036854775807]
+            return static_cast<T*>(data_ptr);
+        }
 
-        raw_uint8           = 0x50, // Unsigned int, value: [0,255]
-        raw_uint16          = 0x51, // Unsigned int, value: [0,65535]
-        raw_uint32          = 0x52, // Unsigned int, value: [0,4294967295]
-        raw_uint64          = 0x53, // Unsigned int, value: [0,18446744073709551615]
+        void deallocate(T* data_ptr, size_t count) noexcept
+        {
+            (void)count;
+            if (nullptr == m_arena)
+            {
+                ::operator delete(data_ptr);
+            }
+        }
 
-        raw_float           = 0x60, // Float, value: [2.2250738585072014e-308, 1.7976931348623158e+308]
+        json_allocator select_on_container_copy_construction() const
+        {
+            return json_allocator();
+        }
 
-        raw_string_empty    = 0xA0, // Empty string
-        raw_string8         = 0xA1, // String, length: [0,255]
-        raw_string16        = 0xA2, // String, length: [0,65535]
-        raw_string32        = 0xA3, // String, length: [0,4294967295]
+        json_arena* arena() const
+        {
+            return m_arena;
+        }
 
-        raw_object_empty    = 0xB0, // Empty object
-        raw_object_beg      = 0xB1, // Object Start
-        raw_object_end      = 0xBF, // Object End
+        template<typename U>
+        bool operator == (const json_allocator<U>& r) const
+        {
+            return m_arena == r.arena();
+        }
 
-        raw_array_empty     = 0xC0, // Empty array
-        raw_array_beg       = 0xC1, // Array Start
-        raw_array_end       = 0xCF, // Array End
+        template<typename U>
+        bool operator != (const json_allocator<U>& r) const
+        {
+            return m_arena != r.arena();
+        }
 
-        raw_bin_empty       = 0xE0, // Empty binary
-        raw_bin8            = 0xE1, // binary, length: [0,255]
-        raw_bin16           = 0xE2, // binary, length: [0,65535]
-        raw_bin32           = 0xE3, // binary, length: [0,4294967295]
-    };
+    private:
 
-    // JSON Character Encoding
-    enum json_encoding :uint8_t
-    {
-        json_encoding_auto,              // Auto
-        json_encoding_utf8,              // Utf8
-        json_encoding_utf16,             // Utf16
+        json_arena*     m_arena;        // nullptr: heap
     };
 
-    // JSON value class
-    class json_value
+    // Object container kept as a vector sorted by key (FC_JSON_FLAT_OBJECT)
+    // Binary search over contiguous members, insertion and removal move the members behind
+    template<typename Key, typename T, typename Alloc = std::allocator<std::pair<Key, T>>>
+    class json_flat_map
     {
     public:
 
-        // Constructor
-        json_value(json_type type = json_type::json_type_object);
-        json_value(nullptr_t);
-        json_value(json_bool val);
-        json_value(int32_t val);
-        json_value(uint32_t val);
-        json_value(int64_t val);
-        json_value(uint64_t val);
-        json_value(json_float val);
-        json_value(const _tchar* val);
-        json_value(const json_string& r);
-        json_value(const json_object& r);
-        json_value(const json_array& r);
-        json_value(const json_bin& r);
-        json_value(const json_value& r);
-        json_value(json_value&& r) noexcept;
-        json_value(json_string&& r);
-        json_value(json_object&& r);
-        json_value(json_array&& r);
-        json_value(json_bin&& r);
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<Key, T>;
+        using size_type = size_t;
+        using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<value_type>;
+        using iterator = typename std::vector<value_type, allocator_type>::iterator;
+        using const_iterator = typename std::vector<value_type, allocator_type>::const_iterator;
 
-        // Operator Overloading
-        json_value& operator = (nullptr_t);
-        json_value& operator = (json_type type);
-        json_value& operator = (json_bool val);
-        json_value& operator = (int32_t val);
-        json_value& operator = (uint32_t val);
-        json_value& operator = (int64_t val);
-        json_value& operator = (uint64_t val);
-        json_value& operator = (json_float val);
-        json_value& operator = (const _tchar* val);
-        json_value& operator = (const json_string& r);
-        json_value& operator = (const json_object& r);
-        json_value& operator = (const json_array& r);
-        json_value& operator = (const json_value& r);
-        json_value& operator = (const json_bin& r);
-        json_value& operator = (json_string&& r);
-        json_value& operator = (json_object&& r);
-        json_value& operator = (json_array&& r);
-        json_value& operator = (json_bin&& r);
-        json_value& operator = (json_value&& r) noexcept;
+        json_flat_map()
+        {
+        }
 
-        // [] Overloading, Accessing a non-existent index will create a new sub-item
-        json_value& operator [] (const _tstring& val_name) noexcept;
-        json_value& operator [] (size_t index) noexcept;
+        explicit json_flat_map(const allocator_type& alloc) :
+            m_items(alloc)
+        {
+        }
 
-        ~json_value();
+        json_flat_map(std::initializer_list<value_type> items)
+        {
+            for (const auto& item : items)
+            {
+                insert(item);
+            }
+        }
 
-        // Type checking
-        bool is_null() const;
-        bool is_bool() const;
-        bool is_int() const;
-        bool is_float() const;
-        bool is_number() const;
-        bool is_string() const;
-        bool is_object() const;
-        bool is_array() const;
-        bool is_bin() const;
+        iterator begin()
+        {
+            return m_items.begin();
+        }
 
-        // Get data
-        json_bool as_bool() const;
-        json_bool as_bool(json_bool default_val) const;
-        json_int as_int() const;
-        json_int as_int(json_int default_val) const;
-        json_uint as_uint() const;
-        json_uint as_uint(json_uint default_val) const;
-        json_float as_float() const;
-        json_float as_float(json_float default_val) const;
-        json_float as_number() const;
-        json_float as_number(json_float default_val) const;
-        json_string& as_string() const;
-        json_string as_string(json_string default_val) const;
-        json_object& as_object() const;
-        json_object as_object(json_object default_val) const;
-        json_array& as_array() const;
-        json_array as_array(json_array default_val) const;
-        json_bin& as_bin() const;
-        json_bin as_bin(json_bin default_val) const;
+        iterator end()
+        {
+            return m_items.end();
+        }
 
-        // Parse
-        bool parse(const _tstring& text);
-        bool parse_from_file(const _tstring& file_path);
-        bool parse_from_binary(uint8_t* data, size_t size);
-        bool parse_from_binary_file(const _tstring& file_path);
+        const_iterator begin() const
+        {
+            return m_items.begin();
+        }
 
-        // Dump
-        _tstring dump(int indent = 0, bool flag_escape = false) const;
-        bool dump_to_file(const _tstring& file_path, int indent = 0, bool flag_escape = false, json_encoding enc = json_encoding::json_encoding_auto);
-        std::vector<uint8_t> dump_to_binary();
-        bool dump_to_binary_file(const _tstring& strPath);
+        const_iterator end() const
+        {
+            return m_items.end();
+        }
 
-        // Others
-        size_t count() const;
-        bool has_value(const _tstring& name = _T("")) const;
-        bool remove(const _tstring& name);
-        bool remove(const size_t index);
-        json_type type() const;
-        _tstring type_name() const;
-        void clear();
+        size_type size() const
+        {
+            return m_items.size();
+        }
 
-#ifdef _WIN32
+        bool empty() const
+        {
+            return m_items.empty();
+        }
 
-        // ANSI string
-        static std::wstring AStrToWStr(const std::string& str);
-        static std::string AStrToU8Str(const std::string& str);
-        static _tstring AStrToTStr(const std::string& str);
+        void clear()
+        {
+            m_items.clear();
+        }
 
-        // Wide string
-        static std::string WStrToU8Str(const std::wstring& str);
-        static std::string WStrToAStr(const std::wstring& str);
-        static _tstring WStrToTStr(const std::wstring& str);
+        void reserve(size_type count)
+        {
+            m_items.reserve(count);
+        }
 
-        // UTF-8 string
-        static std::wstring U8StrToWStr(const std::string& str);
-        static std::string U8StrToAStr(const std::string& str);
-        static _tstring U8StrToTStr(const std::string& str);
+        size_type capacity() const
+        {
+            return m_items.capacity();
+        }
 
-        // Text string
-        static std::string TStrToAStr(const _tstring& str);
-        static std::wstring TStrToWStr(const _tstring& str);
-        static std::string TStrToU8Str(const _tstring& str);
+        allocator_type get_allocator() const
+        {
+            return m_items.get_allocator();
+        }
 
-#endif
+        iterator find(const Key& key)
+        {
+            iterator it = _lower_bound(key);
+            return (m_items.end() != it && !(key < it->first)) ? it : m_items.end();
+        }
 
-    private:
+        const_iterator find(const Key& key) const
+        {
+            return const_cast<json_flat_map*>(this)->find(key);
+        }
 
-        static json_value& _get_none_value();
+        size_type count(const Key& key) const
+        {
+            return end() != find(key) ? 1 : 0;
+        }
 
-        // Reset type
-        inline void _reset_type(json_type type);
+        T& operator [] (const Key& key)
+        {
+            iterator it = find(key);
+            if (m_items.end() != it)
+            {
+                return it->second;
+            }
 
-        // Parse
-        bool _parse_number(const _tchar* data_ptr, json_value& val, const _tchar** end_ptr);
-        bool _parse_unicode(const _tchar* data_ptr, _tstring& val, const _tchar** end_ptr);
-        bool _parse_string(const _tchar* data_ptr, _tstring& val, const _tchar** end_ptr);
-        bool _parse_object(const _tchar* data_ptr, json_value& val, const _tchar** end_ptr);
-        bool _parse_array(const _tchar* data_ptr, json_value& val, const _tchar** end_ptr);
-        bool _parse_value(const _tchar* data_ptr, json_value& val, const _tchar** end_ptr);
-        bool _parse(const _tchar* data_ptr, json_value& val, const _tchar** end_ptr);
+            return emplace(key, T()).first->second;
+        }
 
-        // Dump
-        void _dump_int(_tstring& append_buf, int64_t val) const;
-        void _dump_uint(_tstring& append_buf, uint64_t val) const;
-        void _dump_float(_tstring& append_buf, double val) const;
-        void _dump_string(_tstring& append_buf, const _tstring& text, bool flag_escape) const;
-        void _dump_object(_tstring& append_buf, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const;
-        void _dump_array(_tstring& append_buf, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const;
-        void _dump(_tstring& append_buf, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const;
+        // An existing key keeps its value
+        template<typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args)
+        {
+            value_type item(std::forward<Args>(args)...);
+            if (0 == m_items.capacity())
+            {
+                m_items.reserve(4);
+            }
+
+            // Members of a sorted dump arrive in order
+            if (m_items.empty() || m_items.back().first < item.first)
+            {
+                m_items.push_back(std::move(item));
+                return std::make_pair(m_items.end() - 1, true);
+            }
+
+            iterator it = _lower_bound(item.first);
+            if (!(item.first < it->first))
+            {
+                return std::make_pair(it, false);
+            }
+
+            return std::make_pair(m_items.insert(it, std::move(item)), true);
+        }
+
+        template<typename P>
+        std::pair<iterator, bool> insert(P&& item)
+        {
+            return emplace(std::forward<P>(item));
+        }
+
+        iterator erase(const_iterator it)
+        {
+            return m_items.erase(it);
+        }
+
+        size_type erase(const Key& key)
+        {
+            iterator it = find(key);
+            if (m_items.end() == it)
+            {
+                return 0;
+            }
+
+            m_items.erase(it);
+            return 1;
+        }
+
+    private:
+
+        iterator _lower_bound(const Key& key)
+        {
+            return std::lower_bound(m_items.begin(), m_items.end(), key, [](const value_type& item, const Key& key) {
+                return item.first < key;
+            });
+        }
+
+    private:
+
+        std::vector<value_type, allocator_type>     m_items;        // Members sorted by key
+    };
+
+    // Object container kept in insertion order with an open-addressing index (FC_JSON_HASH_OBJECT)
+    // Small objects are scanned, larger ones probe a linear table of hash tags and member positions
+    template<typename Key, typename T, typename Alloc = std::allocator<std::pair<Key, T>>>
+    class json_hash_map
+    {
+    public:
+
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<Key, T>;
+        using size_type = size_t;
+        using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<value_type>;
+        using slot_allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<uint64_t>;
+        using iterator = typename std::vector<value_type, allocator_type>::iterator;
+        using const_iterator = typename std::vector<value_type, allocator_type>::const_iterator;
+
+        json_hash_map()
+        {
+        }
+
+        explicit json_hash_map(const allocator_type& alloc) :
+            m_items(alloc),
+            m_slots(slot_allocator_type(alloc))
+        {
+        }
+
+        json_hash_map(std::initializer_list<value_type> items)
+        {
+            for (const auto& item : items)
+            {
+                insert(item);
+            }
+        }
+
+        iterator begin()
+        {
+            return m_items.begin();
+        }
+
+        iterator end()
+        {
+            return m_items.end();
+        }
+
+        const_iterator begin() const
+        {
+            return m_items.begin();
+        }
+
+        const_iterator end() const
+        {
+            return m_items.end();
+        }
+
+        size_type size() const
+        {
+            return m_items.size();
+        }
+
+        bool empty() const
+        {
+            return m_items.empty();
+        }
+
+        void clear()
+        {
+            m_items.clear();
+            m_slots.clear();
+        }
+
+        void reserve(size_type count)
+        {
+            m_items.reserve(count);
+        }
+
+        size_type capacity() const
+        {
+            return m_items.capacity();
+        }
+
+        allocator_type get_allocator() const
+        {
+            return m_items.get_allocator();
+        }
+
+        // Slots of the index, 0 while the object is scanned
+        size_type bucket_count() const
+        {
+            return m_slots.size();
+        }
+
+        iterator find(const Key& key)
+        {
+            return m_items.begin() + _find(key, _hash(key));
+        }
+
+        const_iterator find(const Key& key) const
+        {
+            return const_cast<json_hash_map*>(this)->find(key);
+        }
+
+        size_type count(const Key& key) const
+        {
+            return end() != find(key) ? 1 : 0;
+        }
+
+        T& operator [] (const Key& key)
+        {
+            iterator it = find(key);
+            if (m_items.end() != it)
+            {
+                return it->second;
+            }
+
+            return emplace(key, T()).first->second;
+        }
+
+        // An existing key keeps its value
+        template<typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args)
+        {
+            value_type item(std::forward<Args>(args)...);
+            uint64_t hash = _hash(item.first);
+            size_t pos = _find(item.first, hash);
+            if (m_items.size() != pos)
+            {
+                return std::make_pair(m_items.begin() + pos, false);
+            }
+
+            if (0 == m_items.capacity())
+            {
+                m_items.reserve(4);
+            }
+
+            m_items.push_back(std::move(item));
+            if (!m_slots.empty() && m_items.size() * 4 <= m_slots.size() * 3)
+            {
+                _insert_slot(hash, pos);
+            }
+            else if (m_items.size() > linear_max)
+            {
+                _rebuild();
+            }
+
+            return std::make_pair(m_items.begin() + pos, true);
+        }
+
+        template<typename P>
+        std::pair<iterator, bool> insert(P&& item)
+        {
+            return emplace(std::forward<P>(item));
+        }
+
+        // Positions behind the member shift, so the index is rebuilt
+        iterator erase(const_iterator it)
+        {
+            size_t pos = it - m_items.begin();
+            m_items.erase(m_items.begin() + pos);
+            _rebuild();
+            return m_items.begin() + pos;
+        }
+
+        size_type erase(const Key& key)
+        {
+            iterator it = find(key);
+            if (m_items.end() == it)
+            {
+                return 0;
+            }
+
+            erase(it);
+            return 1;
+        }
+
+    private:
+
+        static const size_t linear_max = 8;     // Members found by a scan
+
+        static uint64_t _hash(const Key& key)
+        {
+            const _tstring& text = key;
+            return (uint64_t)std::hash<_tstring>()(text) * 0x9E3779B97F4A7C15ULL;
+        }
+
+        // Position of the member, or size() when absent
+        size_t _find(const Key& key, uint64_t hash) const
+        {
+            if (m_slots.empty())
+            {
+                for (size_t i = 0; i < m_items.size(); i++)
+                {
+                    if (m_items[i].first == key)
+                    {
+                        return i;
+                    }
+                }
+
+                return m_items.size();
+            }
+
+            // Slot: hash tag in the high half, position + 1 in the low half, 0 when empty
+            size_t mask = m_slots.size() - 1;
+            uint64_t tag = hash & 0xFFFFFFFF00000000ULL;
+            for (size_t i = (size_t)(hash >> 32) & mask; 0 != m_slots[i]; i = (i + 1) & mask)
+            {
+                if (tag == (m_slots[i] & 0xFFFFFFFF00000000ULL))
+                {
+                    size_t pos = (size_t)(m_slots[i] & 0xFFFFFFFF) - 1;
+                    if (m_items[pos].first == key)
+                    {
+                        return pos;
+                    }
+                }
+            }
+
+            return m_items.size();
+        }
+
+        void _insert_slot(uint64_t hash, size_t pos)
+        {
+            size_t mask = m_slots.size() - 1;
+            size_t i = (size_t)(hash >> 32) & mask;
+            while (0 != m_slots[i])
+            {
+                i = (i + 1) & mask;
+            }
+
+            m_slots[i] = (hash & 0xFFFFFFFF00000000ULL) | (uint64_t)(pos + 1);
+        }
+
+        void _rebuild()
+        {
+            m_slots.clear();
+            if (m_items.size() <= linear_max)
+            {
+                return;
+            }
+
+            // At most half full after a rebuild
+            size_t slot_count = 32;
+            while (slot_count < m_items.size() * 2)
+            {
+                slot_count *= 2;
+            }
+
+            m_slots.resize(slot_count);
+            for (size_t i = 0; i < m_items.size(); i++)
+            {
+                _insert_slot(_hash(m_items[i].first), i);
+            }
+        }
+
+    private:
+
+        std::vector<value_type, allocator_type>         m_items;        // Members in insertion order
+        std::vector<uint64_t, slot_allocator_type>      m_slots;        // Open-addressing index, empty while small
+    };
+
+#ifdef FC_JSON_INTERN_KEYS
+
+    // Reference counted object key (FC_JSON_INTERN_KEYS)
+    class json_key
+    {
+    public:
+
+        json_key();
+        json_key(const _tchar* text);
+        json_key(const _tstring& text);
+        json_key(const json_key& r);
+        json_key(json_key&& r) noexcept;
+        ~json_key();
+
+        json_key& operator = (const json_key& r);
+        json_key& operator = (json_key&& r) noexcept;
+
+        // Lookup key referring to text without copying it, it must not outlive text
+        static json_key borrow(const _tstring& text);
+
+        operator const _tstring& () const;
+        const _tstring& str() const;
+        const _tchar* c_str() const;
+        size_t size() const;
+        bool empty() const;
+
+        bool operator < (const json_key& r) const;
+        bool operator == (const json_key& r) const;
+        bool operator != (const json_key& r) const;
+
+    private:
+
+        struct json_key_data;
+
+        void _release();
+
+    private:
+
+        uintptr_t       m_ptr;          // json_key_data*, or a borrowed _tstring* with the low bit set
+    };
+
+    // Gives every occurrence of a key text the same json_key, one per parse
+    class json_key_pool
+    {
+    public:
+
+        json_key intern(const _tstring& text);
+        size_t size() const;
+        void clear();
+
+    private:
+
+        std::unordered_map<_tstring, json_key>  m_keys;     // Key text -> shared key
+    };
+
+    using json_object_key = json_key;
+
+#else
+
+    using json_object_key = _tstring;
+
+#endif
+
+    using json_null = nullptr_t;
+    using json_bool = bool;
+    using json_int = int64_t;
+    using json_uint = uint64_t;
+    using json_float = double;
+    using json_string = _tstring;
+#if defined(FC_JSON_FLAT_OBJECT)
+    using json_object = json_flat_map<json_object_key, json_value, json_allocator<std::pair<json_object_key, json_value>>>;
+#elif defined(FC_JSON_HASH_OBJECT)
+    using json_object = json_hash_map<json_object_key, json_value, json_allocator<std::pair<json_object_key, json_value>>>;
+#else
+    using json_object = std::map<json_object_key, json_value, std::less<json_object_key>, json_allocator<std::pair<const json_object_key, json_value>>>;
+#endif
+    using json_array = std::vector<json_value, json_allocator<json_value>>;
+    using json_bin = std::vector<uint8_t>;
+
+    // Exception
+    class json_exception
+    {
+    public:
+        json_exception(const _tstring& msg) :
+            m_msg(msg)
+        {
+        }
+
+        _tstring get_message() const
+        {
+            return m_msg;
+        }
+
+        _tstring get_text_pos() const
+        {
+            return m_msg;
+        }
+
+    private:
+        _tstring    m_msg;      // Message
+    };
+
+    // JSON Data type
+    enum json_type :uint8_t
+    {
+        json_type_null,              // null
+        json_type_bool,              // true Or false
+        json_type_int,               // 0 - 9223372036854775807 Or -1 - (9223372036854775807 - 1)
+        json_type_uint,              // 0 - 18446744073709551615
+        json_type_float,             // 3.141592653589793
+        json_type_string,            // "FlameCyclone"
+        json_type_object,            // [128,256,512,1204,"string",{"name":"FlameCyclone"}]
+        json_type_array,             // {"name":"FlameCyclone"}
+        json_type_bin,               // binary data
+    };
+
+    // JSON Bin Tpye
+    enum json_raw_type :uint8_t
+    {
+        raw_null            = 0x10, // Null
+        raw_false           = 0x20, // Boolean false
+        raw_true            = 0x30, // Boolean true
+
+        raw_int8            = 0x40, // Signed int, value: [-128,-1]                 and [0,127]
+        raw_int16           = 0x41, // Signed int, value: [-32768,-1]               and [0,32767]
+        raw_int32           = 0x42, // Signed int, value: [-2147483648,-1]          and [0,2147483647]
+        raw_int64           = 0x43, // Signed int, value: [-9223372036854775808,-1] and [0,9223372036854775807]
+
+        raw_uint8           = 0x50, // Unsigned int, value: [0,255]
+        raw_uint16          = 0x51, // Unsigned int, value: [0,65535]
+        raw_uint32          = 0x52, // Unsigned int, value: [0,4294967295]
+        raw_uint64          = 0x53, // Unsigned int, value: [0,18446744073709551615]
+
+        raw_float           = 0x60, // Float, value: [2.2250738585072014e-308, 1.7976931348623158e+308]
+
+        raw_string_empty    = 0xA0, // Empty string
+        raw_string8         = 0xA1, // String, length: [0,255]
+        raw_string16        = 0xA2, // String, length: [0,65535]
+        raw_string32        = 0xA3, // String, length: [0,4294967295]
+
+        raw_object_empty    = 0xB0, // Empty object
+        raw_object_beg      = 0xB1, // Object Start
+        raw_object_end      = 0xBF, // Object End
+
+        raw_array_empty     = 0xC0, // Empty array
+        raw_array_beg       = 0xC1, // Array Start
+        raw_array_end       = 0xCF, // Array End
+
+        raw_bin_empty       = 0xE0, // Empty binary
+        raw_bin8            = 0xE1, // binary, length: [0,255]
+        raw_bin16           = 0xE2, // binary, length: [0,65535]
+        raw_bin32           = 0xE3, // binary, length: [0,4294967295]
+    };
+
+    // JSON Character Encoding
+    enum json_encoding :uint8_t
+    {
+        json_encoding_auto,              // Auto
+        json_encoding_utf8,              // Utf8
+        json_encoding_utf16,             // Utf16
+    };
+
+    // JSON Parse flag
+    enum json_parse_flag :uint32_t
+    {
+        json_parse_default  = 0x00,      // Recursive descent over the text
+        json_parse_indexed  = 0x01,      // Build a structural index first (SSE2/AVX2), then descend over the index
+        json_parse_parallel = 0x02,      // Split large arrays across threads, see FC_JSON_PARSE_THREADS
+    };
+
+    // Combined flags stay a json_parse_flag, so they cannot be mistaken for a length
+    inline json_parse_flag operator|(json_parse_flag lhs, json_parse_flag rhs)
+    {
+        return (json_parse_flag)((uint32_t)lhs | (uint32_t)rhs);
+    }
+
+    // Memory held by a value tree, see json_value::memory_stats()
+    struct json_memory_stats
+    {
+        size_t  node_count;             // json_value nodes, the root included
+        size_t  node_bytes;             // Bytes of the nodes themselves
+        size_t  container_bytes;        // Container headers, map links and keys, unused element slots
+        size_t  string_bytes;           // Heap string headers and buffers, keys included
+        size_t  short_string_count;     // Strings stored inside their node
+    };
+
+    // Receives the text of a streaming dump in pieces, returns false to stop
+    using json_dump_sink = std::function<bool(const _tchar* data_ptr, size_t size)>;
+
+    class json_index;
+    struct json_parallel_context;
+    class json_stream_parser;
+    class json_writer;
+    class json_ondemand;
+    class json_document;
+    template<typename Handler>
+    class json_sax_reader;
+
+    // JSON value class
+    class json_value
+    {
+    public:
+
+        // Constructor
+        json_value(json_type type = json_type::json_type_object);
+        json_value(nullptr_t);
+        json_value(json_bool val);
+        json_value(int32_t val);
+        json_value(uint32_t val);
+        json_value(int64_t val);
+        json_value(uint64_t val);
+        json_value(json_float val);
+        json_value(const _tchar* val);
+        json_value(const json_string& r);
+        json_value(const json_object& r);
+        json_value(const json_array& r);
+        json_value(const json_bin& r);
+        json_value(const json_value& r);
+        json_value(json_value&& r) noexcept;
+        json_value(json_string&& r);
+        json_value(json_object&& r);
+        json_value(json_array&& r);
+        json_value(json_bin&& r);
+
+        // Operator Overloading
+        json_value& operator = (nullptr_t);
+        json_value& operator = (json_type type);
+        json_value& operator = (json_bool val);
+        json_value& operator = (int32_t val);
+        json_value& operator = (uint32_t val);
+        json_value& operator = (int64_t val);
+        json_value& operator = (uint64_t val);
+        json_value& operator = (json_float val);
+        json_value& operator = (const _tchar* val);
+        json_value& operator = (const json_string& r);
+        json_value& operator = (const json_object& r);
+        json_value& operator = (const json_array& r);
+        json_value& operator = (const json_value& r);
+        json_value& operator = (const json_bin& r);
+        json_value& operator = (json_string&& r);
+        json_value& operator = (json_object&& r);
+        json_value& operator = (json_array&& r);
+        json_value& operator = (json_bin&& r);
+        json_value& operator = (json_value&& r) noexcept;
+
+        // [] Overloading, Accessing a non-existent index will create a new sub-item
+        json_value& operator [] (const _tstring& val_name) noexcept;
+        json_value& operator [] (size_t index) noexcept;
+
+        ~json_value();
+
+        // Type checking
+        bool is_null() const;
+        bool is_bool() const;
+        bool is_int() const;
+        bool is_float() const;
+        bool is_number() const;
+        bool is_string() const;
+        bool is_object() const;
+        bool is_array() const;
+        bool is_bin() const;
+
+        // Get data
+        json_bool as_bool() const;
+        json_bool as_bool(json_bool default_val) const;
+        json_int as_int() const;
+        json_int as_int(json_int default_val) const;
+        json_uint as_uint() const;
+        json_uint as_uint(json_uint default_val) const;
+        json_float as_float() const;
+        json_float as_float(json_float default_val) const;
+        json_float as_number() const;
+        json_float as_number(json_float default_val) const;
+        json_string as_string(json_string default_val) const;
+        json_object as_object(json_object default_val) const;
+        json_array as_array(json_array default_val) const;
+
+        // A short string is moved to the heap and an empty container given a header, so that a reference
+        // can be handed out
+        json_string& as_string();
+        json_object& as_object();
+        json_array& as_array();
+
+        // Read-only, the value is never modified so several threads may share it
+        // as_string() returns a copy, string_data() / string_size() read the text in place
+        json_string as_string() const;
+        const json_object& as_object() const;
+        const json_array& as_array() const;
+
+        // NUL terminated text of a string, nullptr for other types
+        const _tchar* string_data() const;
+        size_t string_size() const;
+
+#ifdef FC_JSON_HAS_STRING_VIEW
+        std::basic_string_view<_tchar> as_string_view() const
+        {
+            if (!is_string())
+            {
+                throw json_exception(_T("as_string_view"));
+            }
+
+            return std::basic_string_view<_tchar>(string_data(), string_size());
+        }
+#endif
+        json_bin& as_bin() const;
+        json_bin as_bin(json_bin default_val) const;
+
+        // Parse
+        bool parse(const _tstring& text, json_parse_flag flags = json_parse_flag::json_parse_default);
+        bool parse(const _tchar* data, size_t size, json_parse_flag flags = json_parse_flag::json_parse_default);
+
+        // Parse with objects, arrays and strings placed in arena, which must outlive this value
+        // json_parse_parallel is ignored, a json_arena is filled from one thread
+        bool parse(const _tstring& text, json_arena& arena, json_parse_flag flags = json_parse_flag::json_parse_default);
+        bool parse(const _tchar* data, size_t size, json_arena& arena, json_parse_flag flags = json_parse_flag::json_parse_default);
+
+        // NUL-terminated text, a pointer with a json_parse_flag is never read as a length
+        // A template so a char array still prefers the overload below, which stops at its end
+        template<typename T>
+        typename std::enable_if<std::is_same<T, const _tchar*>::value || std::is_same<T, _tchar*>::value, bool>::type
+        parse(T text, json_parse_flag flags = json_parse_flag::json_parse_default)
+        {
+            return parse(text, std::char_traits<_tchar>::length(text), flags);
+        }
+
+        // String literal, parses up to the first NUL
+        // flags is not an integer, parse(buffer, length) with a char array always takes the bounded overload
+        template<size_t N>
+        bool parse(const _tchar(&text)[N], json_parse_flag flags = json_parse_flag::json_parse_default)
+        {
+            const _tchar* end_ptr = std::char_traits<_tchar>::find(text, N, _T('\0'));
+            return parse(text, end_ptr ? end_ptr - text : N, flags);
+        }
+
+#ifdef FC_JSON_HAS_STRING_VIEW
+        template<typename T, typename = typename std::enable_if<std::is_same<T, std::basic_string_view<_tchar>>::value>::type>
+        bool parse(T text, json_parse_flag flags = json_parse_flag::json_parse_default)
+        {
+            return parse(text.data(), text.size(), flags);
+        }
+#endif
+
+        bool parse_from_file(const _tstring& file_path, json_parse_flag flags = json_parse_flag::json_parse_default);
+        bool parse_from_binary(uint8_t* data, size_t size);
+        bool parse_from_binary_file(const _tstring& file_path);
+
+        // Dump
+        _tstring dump(int indent = 0, bool flag_escape = false) const;
+
+        // Length of dump(indent, flag_escape) in characters, measured without building the text
+        size_t dump_size(int indent = 0, bool flag_escape = false) const;
+
+        // Streaming dump through a fixed buffer, memory use does not grow with the document
+        // The text is written as _tchar without BOM, false once the sink fails
+        // Templates so that a literal 0 as in dump(0, flag_escape) is never taken for a sink or a FILE*
+        template<typename Sink, typename = typename std::enable_if<std::is_convertible<const Sink&, json_dump_sink>::value>::type>
+        bool dump(const Sink& sink, int indent = 0, bool flag_escape = false) const
+        {
+            return _dump_to_sink(sink, indent, flag_escape);
+        }
+
+        template<typename T, typename = typename std::enable_if<std::is_same<T, FILE*>::value>::type>
+        bool dump(T file, int indent = 0, bool flag_escape = false) const
+        {
+            return _dump_to_stdio(file, indent, flag_escape);
+        }
+
+        bool dump(std::basic_ostream<_tchar>& stream, int indent = 0, bool flag_escape = false) const;
+        bool dump_to_fd(int fd, int indent = 0, bool flag_escape = false) const;
+
+        bool dump_to_file(const _tstring& file_path, int indent = 0, bool flag_escape = false, json_encoding enc = json_encoding::json_encoding_auto);
+        std::vector<uint8_t> dump_to_binary();
+        bool dump_to_binary_file(const _tstring& strPath);
+
+        // Others
+        size_t count() const;
+        bool has_value(const _tstring& name = _T("")) const;
+        bool remove(const _tstring& name);
+        bool remove(const size_t index);
+        json_type type() const;
+        _tstring type_name() const;
+        void clear();
+
+        // Memory held by this value and its members
+        json_memory_stats memory_stats() const;
+
+#ifdef _WIN32
+
+        // ANSI string
+        static std::wstring AStrToWStr(const std::string& str);
+        static std::string AStrToU8Str(const std::string& str);
+        static _tstring AStrToTStr(const std::string& str);
+
+        // Wide string
+        static std::string WStrToU8Str(const std::wstring& str);
+        static std::string WStrToAStr(const std::wstring& str);
+        static _tstring WStrToTStr(const std::wstring& str);
+
+        // UTF-8 string
+        static std::wstring U8StrToWStr(const std::string& str);
+        static std::string U8StrToAStr(const std::string& str);
+        static _tstring U8StrToTStr(const std::string& str);
+
+        // Text string
+        static std::string TStrToAStr(const _tstring& str);
+        static std::wstring TStrToWStr(const _tstring& str);
+        static std::string TStrToU8Str(const _tstring& str);
+
+#endif
+
+    private:
+
+        friend class json_stream_parser;
+        friend class json_ondemand;
+        friend class json_dom_handler;
+        friend class json_document;
+        template<typename Handler>
+        friend class json_sax_reader;
+
+        union json_data;
+
+        static json_value& _get_none_value();
+
+        // Reset type, containers and strings are placed in arena if given
+        inline void _reset_type(json_type type, json_arena* arena = nullptr);
+
+        // Reset to a string, short text is stored inline
+        inline void _reset_string(const _tchar* data_ptr, size_t size);
+        inline void _reset_string(json_string&& text, json_arena* arena = nullptr);
+
+        // Moves a short string to the heap so that a json_string& can be handed out
+        bool _promote_string();
+
+        // Allocate the header of an empty object or array left without one
+        bool _promote_container();
+
+        void _memory_stats(json_memory_stats& stats) const;
+
+        // Parse
+        static bool _parse_number(const _tchar* data_ptr, const _tchar* data_end, json_type& type, json_data& data, const _tchar** end_ptr);
+        static bool _parse_number(const _tchar* data_ptr, const _tchar* data_end, json_value& val, const _tchar** end_ptr);
+        static bool _parse_unicode(const _tchar* data_ptr, const _tchar* data_end, _tstring& val, const _tchar** end_ptr);
+        static bool _parse_string(const _tchar* data_ptr, const _tchar* data_end, _tstring& val, const _tchar** end_ptr);
+        bool _parse(const _tchar* data_ptr, const _tchar* data_end, json_value& val, const _tchar** end_ptr, json_arena* arena = nullptr);
+
+        // Parse indexed
+        bool _parse_indexed_string(json_index& index, size_t begin_pos, _tstring& val);
+        bool _parse_indexed_scalar(json_index& index, size_t begin_pos, json_value& val);
+        bool _parse_indexed_object(json_index& index, json_value& val);
+        bool _parse_indexed_array(json_index& index, json_value& val);
+        bool _parse_indexed_value(json_index& index, json_value& val);
+        bool _parse_indexed(const _tchar* data_ptr, size_t size, json_value& val, json_arena* arena = nullptr);
+
+        // json_parse_parallel, the walk returns where each value ends, _parse_span takes an exact value
+        static bool _parse_parallel(const _tchar* data_ptr, size_t size, json_value& val, size_t thread_count);
+        static bool _parse_parallel_value(const _tchar* data_ptr, const _tchar* data_end, json_value& val, json_parallel_context& context, size_t depth, const _tchar** end_ptr);
+        static bool _parse_parallel_array(const _tchar* data_ptr, const _tchar* data_end, json_value& val, json_parallel_context& context, size_t depth, const _tchar** end_ptr);
+        static bool _parse_parallel_object(const _tchar* data_ptr, const _tchar* data_end, json_value& val, json_parallel_context& context, size_t depth, const _tchar** end_ptr);
+        static bool _parse_span(const _tchar* data_ptr, const _tchar* data_end, json_value& val, json_parallel_context& context, size_t depth);
+
+        // Dump
+        void _dump_int(json_writer& append_buf, int64_t val) const;
+        void _dump_uint(json_writer& append_buf, uint64_t val) const;
+        void _dump_float(json_writer& append_buf, double val) const;
+        void _dump_string(json_writer& append_buf, const _tchar* text, bool flag_escape) const;
+        void _dump_object(json_writer& append_buf, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const;
+        void _dump_array(json_writer& append_buf, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const;
+        void _dump(json_writer& append_buf, std::vector<_tstring>& indent_text, int depth, int indent, bool flag_escape) const;
+        size_t _dump_string_size(const _tchar* text, bool flag_escape) const;
+        size_t _dump_size(int depth, int indent, bool flag_escape) const;
+        bool _dump_to_sink(const json_dump_sink& sink, int indent, bool flag_escape) const;
+        bool _dump_to_stdio(FILE* file, int indent, bool flag_escape) const;
+
+        // Dump raw
+        void _dump_raw_int(std::vector<uint8_t>& append_buf, int64_t val) const;
+        void _dump_raw_uint(std::vector<uint8_t>& append_buf, uint64_t val) const;
+        void _dump_raw_float(std::vector<uint8_t>& append_buf, double val) const;
+        void _dump_raw_string(std::vector<uint8_t>& append_buf, const std::string& text) const;
+        void _dump_raw_object(std::vector<uint8_t>& append_buf, const json_object& object) const;
+        void _dump_raw_array(std::vector<uint8_t>& append_buf, const json_array& arrry) const;
+        void _dump_raw_bin(std::vector<uint8_t>& append_buf, const json_bin& arrry) const;
+        void _dump_raw(std::vector<uint8_t>& append_buf) const;
+
+        // Parse raw
+        bool _parse_raw_string(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val);
+        bool _parse_raw_object(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val);
+        bool _parse_raw_array(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val);
+        bool _parse_raw_bin(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val);
+        bool _parse_raw(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val);
+
+    private:
+
+        // JSON data
+        union json_data
+        {
+            json_bool    _bool;             // bool
+            json_int     _int;              // int64_t
+            json_uint    _uint;             // uint64_t
+            json_float   _float;            // double
+            json_string* _string_ptr;       // std::string
+            json_object* _object_ptr;       // std::map
+            json_array*  _array_ptr;        // std::vector
+            json_bin*    _raw_ptr;          // std::vector<uint8_t>
+        };
+
+        // Characters of a short string stored in the value, NUL included
+        static const size_t json_short_size = (2 * sizeof(json_data) - 2) / sizeof(_tchar);
+
+        // Short strings are stored in the value itself, sharing the leading type and flags
+        // m_long.type and m_long.flags are read for both, they are a common initial sequence
+        union
+        {
+            struct
+            {
+                json_type    type;                  // Data type
+                uint8_t      flags;                 // json_value_flag
+                json_data    data;                  // Data
+            } m_long;
+
+            struct
+            {
+                json_type    type;                  // m_long.type of a short string
+                uint8_t      flags;                 // m_long.flags of a short string
+                _tchar       text[json_short_size]; // NUL terminated text
+            } m_short;
+        };
+    };
+
+    // Skips runs of whitespace such as newline + indentation in blocks
+    const _tchar* _skip_whitespace_run(const _tchar* data_ptr, const _tchar* data_end);
+
+    inline const _tchar* _skip_whitespace(const _tchar* data_ptr, const _tchar* data_end)
+    {
+        // '\0' is not whitespace, an embedded NUL fails the parse
+        if (data_ptr >= data_end || *data_ptr > _T(' ') || _T('\0') == *data_ptr)
+        {
+            return data_ptr;
+        }
+
+        // A single space, as after ':' in most pretty printers
+        if (data_end - data_ptr >= 2 && (data_ptr[1] > _T(' ') || _T('\0') == data_ptr[1]))
+        {
+            return data_ptr + 1;
+        }
+
+        return _skip_whitespace_run(data_ptr, data_end);
+    }
+
+    inline const _tchar* _skip_bom(const _tchar* data_ptr, const _tchar* data_end)
+    {
+#ifdef _UNICODE
+
+        while (data_ptr < data_end && 0xFEFF == *data_ptr)
+        {
+            data_ptr++;
+        }
+
+#else
+        while (data_end - data_ptr >= 3 && 0 == std::char_traits<_tchar>::compare(data_ptr, "\xEF\xBB\xBF", 3))
+        {
+            data_ptr += 3;
+        }
+
+#endif
+        return data_ptr;
+    }
 
-        // Dump raw
-        void _dump_raw_int(std::vector<uint8_t>& append_buf, int64_t val) const;
-        void _dump_raw_uint(std::vector<uint8_t>& append_buf, uint64_t val) const;
-        void _dump_raw_float(std::vector<uint8_t>& append_buf, double val) const;
-        void _dump_raw_string(std::vector<uint8_t>& append_buf, const std::string& text) const;
-        void _dump_raw_object(std::vector<uint8_t>& append_buf, const json_object& object) const;
-        void _dump_raw_array(std::vector<uint8_t>& append_buf, const json_array& arrry) const;
-        void _dump_raw_bin(std::vector<uint8_t>& append_buf, const json_bin& arrry) const;
-        void _dump_raw(std::vector<uint8_t>& append_buf) const;
+    inline bool _skip_literal(const _tchar* data_ptr, const _tchar* data_end, const _tchar* literal, size_t length)
+    {
+        return (size_t)(data_end - data_ptr) >= length && 0 == std::char_traits<_tchar>::compare(literal, data_ptr, length);
+    }
 
-        // Parse raw
-        bool _parse_raw_string(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val);
-        bool _parse_raw_object(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val);
-        bool _parse_raw_array(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val);
-        bool _parse_raw_bin(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val);
-        bool _parse_raw(const uint8_t* data_ptr, const uint8_t** end_ptr, json_value& val);
+    // SAX event handler, called by json_sax_reader without virtual dispatch
+    // Every callback returns false to stop the parse
+    //
+    // class handler
+    // {
+    // public:
+    //     bool null_value();
+    //     bool bool_value(json_bool val);
+    //     bool int_value(json_int val);
+    //     bool uint_value(json_uint val);
+    //     bool float_value(json_float val);
+    //     bool string_value(_tstring& val);        // val may be moved from
+    //     bool key(_tstring& val);                 // val may be moved from
+    //     bool start_object();
+    //     bool end_object();
+    //     bool start_array();
+    //     bool end_array();
+    // };
+
+    // SAX handler that builds a json_value
+    class json_dom_handler
+    {
+    public:
+
+        json_dom_handler(json_value& root, json_arena* arena = nullptr);
+#ifdef FC_JSON_INTERN_KEYS
+        // Keys are interned in key_pool, which is shared with other handlers of the same thread
+        json_dom_handler(json_value& root, json_key_pool& key_pool);
+#endif
+
+        bool null_value();
+        bool bool_value(json_bool val);
+        bool int_value(json_int val);
+        bool uint_value(json_uint val);
+        bool float_value(json_float val);
+        bool string_value(_tstring& val);
+        bool key(_tstring& val);
+        bool start_object();
+        bool end_object();
+        bool start_array();
+        bool end_array();
+
+        // Number of open containers
+        size_t depth() const;
+
+        // Whether the innermost open container is an array
+        bool in_array() const;
 
     private:
 
-        // JSON data
-        union json_data
+        bool _add_value(json_value&& val);
+
+    private:
+
+        // Open object or array
+        struct json_dom_frame
         {
-            json_bool    _bool;             // bool
-            json_int     _int;              // int64_t
-            json_uint    _uint;             // uint64_t
-            json_float   _float;            // double
-            json_string* _string_ptr;       // std::string
-            json_object* _object_ptr;       // std::map
-            json_array*  _array_ptr;        // std::vector
-            json_bin*    _raw_ptr;          // std::vector<uint8_t>
-        }m_data;                            //
+            json_value      value;          // Container
+            _tstring        key;            // Key of the member being parsed
+            size_t          value_begin;    // First member on m_values
+            size_t          key_begin;      // First key on m_keys
+        };
+
+        std::vector<json_dom_frame>     m_stack;            // Open containers
+        std::vector<json_value>         m_values;           // Members of the open containers
+        std::vector<json_object_key>    m_keys;             // Keys of the members of open objects
+        json_value*                     m_root;             // Root value
+        json_arena*                     m_arena;            // Arena for containers and strings, or nullptr
+#ifdef FC_JSON_INTERN_KEYS
+        json_key_pool                   m_key_pool;         // Keys of this parse
+        json_key_pool*                  m_shared_key_pool;  // Pool used instead of m_key_pool, or nullptr
+#endif
+    };
+
+    // Parser reporting to a SAX handler, open containers are kept on an explicit stack
+    // so that nesting costs no call stack; text nested deeper than max_depth is rejected
+    template<typename Handler>
+    class json_sax_reader
+    {
+    public:
+
+        json_sax_reader(Handler& handler, size_t max_depth = FC_JSON_MAX_DEPTH) :
+            m_handler(handler),
+            m_max_depth(max_depth)
+        {
+        }
+
+        // Parse the whole text, BOM and surrounding whitespace included
+        bool parse(const _tchar* data_ptr, const _tchar* data_end, const _tchar** end_ptr)
+        {
+            bool result_flag = false;
+
+            data_ptr = _skip_bom(data_ptr, data_end);
+            if (_parse_value(data_ptr, data_end, &data_ptr) && data_ptr == data_end)
+            {
+                result_flag = true;
+            }
+
+            if (end_ptr)
+            {
+                *end_ptr = data_ptr;
+            }
+
+            return result_flag;
+        }
+
+    private:
+
+        // Parse a value and the whitespace after it
+        bool _parse_value(const _tchar* data_ptr, const _tchar* data_end, const _tchar** end_ptr)
+        {
+            bool result_flag = false;
+            bool flag_object = false;       // The innermost open container is an object
+
+            m_stack.clear();
+            while (true)
+            {
+                bool flag_member = false;   // Another member of the innermost container follows
+
+                data_ptr = _skip_whitespace(data_ptr, data_end);
+                if (data_ptr >= data_end)
+                {
+                    break;
+                }
+
+                _tchar ch = *data_ptr;
+                if (_T('{') == ch || _T('[') == ch)
+                {
+                    flag_object = _T('{') == ch;
+                    if (m_stack.size() >= m_max_depth || !(flag_object ? m_handler.start_object() : m_handler.start_array()))
+                    {
+                        break;
+                    }
+
+                    m_stack.push_back(flag_object ? 1 : 0);
+                    data_ptr = _skip_whitespace(data_ptr + 1, data_end);
+                    if (data_ptr >= data_end)
+                    {
+                        break;
+                    }
+
+                    if ((flag_object ? _T('}') : _T(']')) != *data_ptr)
+                    {
+                        flag_member = true;
+                    }
+                    else if (_end_container(flag_object))
+                    {
+                        data_ptr++;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+                else if (!_parse_scalar(data_ptr, data_end, &data_ptr))
+                {
+                    break;
+                }
+
+                // Close the containers that end here
+                while (!flag_member)
+                {
+                    data_ptr = _skip_whitespace(data_ptr, data_end);
+                    if (m_stack.empty())
+                    {
+                        result_flag = true;
+                        break;
+                    }
+
+                    if (data_ptr >= data_end)
+                    {
+                        break;
+                    }
+
+                    _tchar close_ch = flag_object ? _T('}') : _T(']');
+                    if (_T(',') == *data_ptr)
+                    {
+                        data_ptr = _skip_whitespace(data_ptr + 1, data_end);
+                        if (data_ptr >= data_end)
+                        {
+                            break;
+                        }
+
+                        // A trailing comma is accepted
+                        flag_member = close_ch != *data_ptr;
+                    }
+
+                    if (!flag_member)
+                    {
+                        if (close_ch != *data_ptr || !_end_container(flag_object))
+                        {
+                            break;
+                        }
+
+                        data_ptr++;
+                    }
+                }
+
+                if (!flag_member)
+                {
+                    break;
+                }
+
+                if (flag_object)
+                {
+                    m_string.clear();
+                    if (!json_value::_parse_string(data_ptr, data_end, m_string, &data_ptr) || !m_handler.key(m_string))
+                    {
+                        break;
+                    }
+
+                    data_ptr = _skip_whitespace(data_ptr, data_end);
+                    if (data_ptr >= data_end || _T(':') != *data_ptr)
+                    {
+                        break;
+                    }
+
+                    data_ptr++;
+                }
+            }
+
+            *end_ptr = data_ptr;
+            return result_flag;
+        }
+
+        bool _end_container(bool& flag_object)
+        {
+            bool result_flag = flag_object ? m_handler.end_object() : m_handler.end_array();
+
+            m_stack.pop_back();
+            flag_object = !m_stack.empty() && 0 != m_stack.back();
+            return result_flag;
+        }
+
+        bool _parse_number(const _tchar* data_ptr, const _tchar* data_end, const _tchar** end_ptr)
+        {
+            json_value::json_data number_data;
+            json_type number_type = json_type::json_type_null;
+
+            if (!json_value::_parse_number(data_ptr, data_end, number_type, number_data, end_ptr))
+            {
+                return false;
+            }
+
+            if (json_type::json_type_int == number_type)
+            {
+                return m_handler.int_value(number_data._int);
+            }
+
+            if (json_type::json_type_uint == number_type)
+            {
+                return m_handler.uint_value(number_data._uint);
+            }
+
+            return m_handler.float_value(number_data._float);
+        }
+
+        // String, number or literal
+        bool _parse_scalar(const _tchar* data_ptr, const _tchar* data_end, const _tchar** end_ptr)
+        {
+            bool result_flag = false;
+
+            switch (*data_ptr)
+            {
+            case _T('\"'):
+                m_string.clear();
+                result_flag = json_value::_parse_string(data_ptr, data_end, m_string, &data_ptr) && m_handler.string_value(m_string);
+                break;
+            case _T('-'):
+            case _T('0'): case _T('1'): case _T('2'): case _T('3'): case _T('4'):
+            case _T('5'): case _T('6'): case _T('7'): case _T('8'): case _T('9'):
+                result_flag = _parse_number(data_ptr, data_end, &data_ptr);
+                break;
+            default:
+                if (_skip_literal(data_ptr, data_end, _T("null"), 4))
+                {
+                    result_flag = m_handler.null_value();
+                    data_ptr += 4;
+                }
+                else if (_skip_literal(data_ptr, data_end, _T("true"), 4))
+                {
+                    result_flag = m_handler.bool_value(true);
+                    data_ptr += 4;
+                }
+                else if (_skip_literal(data_ptr, data_end, _T("false"), 5))
+                {
+                    result_flag = m_handler.bool_value(false);
+                    data_ptr += 5;
+                }
+                break;
+            }
+
+            *end_ptr = data_ptr;
+            return result_flag;
+        }
+
+    private:
+
+        Handler&                m_handler;          // Event handler
+        _tstring                m_string;           // String and key buffer
+        std::vector<uint8_t>    m_stack;            // Open containers, 1 for an object
+        size_t                  m_max_depth;        // Deepest nesting accepted
+    };
+
+    // Parse the text as SAX events
+    template<typename Handler>
+    bool parse_sax(const _tchar* data, size_t size, Handler& handler, size_t max_depth = FC_JSON_MAX_DEPTH)
+    {
+        json_sax_reader<Handler> reader(handler, max_depth);
+        return nullptr != data && reader.parse(data, data + size, nullptr);
+    }
+
+    template<typename Handler>
+    bool parse_sax(const _tstring& text, Handler& handler, size_t max_depth = FC_JSON_MAX_DEPTH)
+    {
+        return parse_sax(text.data(), text.size(), handler, max_depth);
+    }
+
+    // Push-style incremental parser, the text may be split at any character
+    class json_stream_parser
+    {
+    public:
+
+        json_stream_parser();
+
+        // Parse the next chunk, returns false once the text is known to be invalid
+        bool feed(const _tchar* data, size_t size);
+        bool feed(const _tstring& text);
+
+        // No more input, returns true if the text was one complete value
+        bool finish();
+
+        // Parsed value, complete after finish() returned true
+        json_value& value();
+
+        // Start over for the next text
+        void reset();
+
+    private:
+
+        // Parse state
+        enum json_stream_state :uint8_t
+        {
+            json_stream_bom,                // Leading BOM
+            json_stream_value,              // Value
+            json_stream_array_value,        // Value or ]
+            json_stream_object_key,         // Key or }
+            json_stream_colon,              // :
+            json_stream_comma,              // , or the closing bracket
+            json_stream_string,             // Inside a string
+            json_stream_key,                // Inside a key
+            json_stream_number,             // Inside a number
+            json_stream_literal,            // Inside null, true or false
+            json_stream_end,                // Value complete
+            json_stream_error,              // Invalid text
+        };
+
+        bool _parse_string(const _tchar* data_ptr, size_t size, bool flag_key);
+        bool _parse_scalar();
+        void _next_state();
+
+    private:
+
+        json_value                      m_value;            // Root value
+        json_dom_handler                m_handler;          // Builds m_value
+        _tstring                        m_token;            // Partial string, number, literal or BOM
+        _tstring                        m_string;           // String and key buffer
+        json_stream_state               m_state;            // Parse state
+        bool                            m_escape;           // Partial string ends with an unpaired backslash
+    };
+
+    // On-demand reader: a position in the text, values are parsed only when asked for
+    // and untouched subtrees are skipped by bracket matching, without building json_value nodes
+    // Only the parts that are read are validated, the text must outlive the reader
+    class json_ondemand
+    {
+    public:
+
+        // Array element iterator
+        class iterator
+        {
+        public:
+
+            iterator(const _tchar* data_ptr, const _tchar* data_end);
+
+            json_ondemand operator * () const;
+            iterator& operator ++ ();
+            bool operator == (const iterator& r) const;
+            bool operator != (const iterator& r) const;
+
+        private:
+
+            const _tchar*   m_data;         // Current element, nullptr at the end
+            const _tchar*   m_end;          // Text end
+        };
+
+    public:
+
+        json_ondemand();
+        json_ondemand(const _tchar* data, size_t size);
+        json_ondemand(const _tstring& text);
+        json_ondemand(_tstring&& text) = delete;
+
+        // Type of the value, json_type_null also for an invalid reader
+        json_type type() const;
+        bool is_valid() const;
+        bool is_null() const;
+
+        // Object member, invalid if missing
+        json_ondemand find_field(const _tstring& name) const;
+        json_ondemand operator [] (const _tstring& name) const;
+
+        // Array element, invalid if missing
+        json_ondemand at(size_t index) const;
+        iterator begin() const;
+        iterator end() const;
+
+        // Get data, false if the value is not of that type
+        bool get_bool(json_bool& val) const;
+        bool get_int64(json_int& val) const;
+        bool get_uint64(json_uint& val) const;
+        bool get_double(json_float& val) const;
+        bool get_string(_tstring& val) const;
+
+        // Parse the whole value into a json_value
+        bool get_value(json_value& val) const;
+
+    private:
+
+        friend class json_value;
+
+        static json_ondemand _make_value(const _tchar* data_ptr, const _tchar* data_end);
+        static const _tchar* _skip_string(const _tchar* data_ptr, const _tchar* data_end);
+        static const _tchar* _skip_value(const _tchar* data_ptr, const _tchar* data_end);
+        bool _get_number(json_type& type, json_value::json_data& data) const;
+
+    private:
+
+        const _tchar*   m_data;             // Value start, nullptr for an invalid reader
+        const _tchar*   m_end;              // Text end
+    };
+
+    // Read-only view of a value in a json_document, valid while the document is unchanged
+    class json_element
+    {
+    public:
+
+        // Element iterator, for objects key() gives the member name
+        class iterator
+        {
+        public:
+
+            iterator(const json_document* doc, size_t pos, bool flag_object);
+
+            json_element operator * () const;
+            json_element value() const;
+            _tstring key() const;
+            iterator& operator ++ ();
+            bool operator == (const iterator& r) const;
+            bool operator != (const iterator& r) const;
+
+        private:
+
+            const json_document*    m_doc;          // Document
+            size_t                  m_pos;          // Tape position of the element, or of the key in an object
+            bool                    m_object;       // Iterating an object
+        };
+
+    public:
+
+        json_element();
+        json_element(const json_document* doc, size_t pos);
+
+        // Type checking, json_type_null also for an invalid element
+        json_type type() const;
+        bool is_valid() const;
+        bool is_null() const;
+        bool is_bool() const;
+        bool is_int() const;
+        bool is_float() const;
+        bool is_number() const;
+        bool is_string() const;
+        bool is_object() const;
+        bool is_array() const;
+
+        // Get data
+        json_bool as_bool() const;
+        json_bool as_bool(json_bool default_val) const;
+        json_int as_int() const;
+        json_int as_int(json_int default_val) const;
+        json_uint as_uint() const;
+        json_uint as_uint(json_uint default_val) const;
+        json_float as_float() const;
+        json_float as_float(json_float default_val) const;
+        json_float as_number() const;
+        json_float as_number(json_float default_val) const;
+        _tstring as_string() const;
+        _tstring as_string(const _tstring& default_val) const;
+
+        // NUL terminated text of a string, nullptr for other types
+        const _tchar* string_data() const;
+        size_t string_size() const;
+
+#ifdef FC_JSON_HAS_STRING_VIEW
+        std::basic_string_view<_tchar> as_string_view() const
+        {
+            if (!is_string())
+            {
+                throw json_exception(_T("as_string_view"));
+            }
+
+            return std::basic_string_view<_tchar>(string_data(), string_size());
+        }
+#endif
+
+        // Object member or array element, invalid if missing
+        json_element operator [] (const _tstring& name) const;
+        json_element operator [] (size_t index) const;
+        json_element find_field(const _tstring& name) const;
+        json_element at(size_t index) const;
+
+        iterator begin() const;
+        iterator end() const;
+
+        // Number of members or elements
+        size_t count() const;
+
+        // Copy into a mutable value
+        json_value to_value() const;
+        bool get_value(json_value& val) const;
+
+    private:
+
+        uint64_t _entry() const;
+
+    private:
 
-        json_type    m_type;                // Data type
+        const json_document*    m_doc;              // Document, nullptr for an invalid element
+        size_t                  m_pos;              // Tape position
     };
+
+    // Immutable document: the whole parse in one tape of 64-bit entries and one string buffer
+    //
+    // Entry: tag in the high 8 bits, payload in the low 56 bits
+    // null, true, false:       [tag]
+    // int, uint, float:        [tag] [64-bit value]
+    // string, key:             [tag | string offset] [length]
+    // object, array start:     [tag | end position] [member count]
+    // object, array end:       [tag | start position]
+    //
+    // Object members are a key entry followed by the value
+    // Buffers are kept by parse() and clear(), so reparsing reuses them
+    class json_document
+    {
+    public:
+
+        json_document();
+
+        bool parse(const _tstring& text);
+        bool parse(const _tchar* data, size_t size);
+
+        // Root value, invalid if nothing was parsed
+        json_element root() const;
+        json_element operator [] (const _tstring& name) const;
+        json_element operator [] (size_t index) const;
+
+        // Copy into a mutable value
+        json_value to_value() const;
+
+        // Bytes used by the tape and the strings
+        size_t tape_size() const;
+        size_t string_size() const;
+
+        void clear();
+
+    private:
+
+        friend class json_element;
+
+        // Tape entry tag
+        enum json_tape_tag :uint8_t
+        {
+            json_tape_null          = 'n',
+            json_tape_true          = 't',
+            json_tape_false         = 'f',
+            json_tape_int           = 'l',
+            json_tape_uint          = 'u',
+            json_tape_float         = 'd',
+            json_tape_string        = '\"',
+            json_tape_object        = '{',
+            json_tape_object_end    = '}',
+            json_tape_array         = '[',
+            json_tape_array_end     = ']',
+        };
+
+        static const uint64_t json_tape_payload_mask = 0x00FFFFFFFFFFFFFFULL;
+
+        // SAX handler appending to the tape
+        class json_tape_handler
+        {
+        public:
+
+            json_tape_handler(json_document& doc);
+
+            bool null_value();
+            bool bool_value(json_bool val);
+            bool int_value(json_int val);
+            bool uint_value(json_uint val);
+            bool float_value(json_float val);
+            bool string_value(_tstring& val);
+            bool key(_tstring& val);
+            bool start_object();
+            bool end_object();
+            bool start_array();
+            bool end_array();
+
+        private:
+
+            void _add_value();
+            void _append_string(const _tstring& val);
+            bool _start(json_tape_tag tag);
+            bool _end(json_tape_tag start_tag, json_tape_tag end_tag);
+
+        private:
+
+            json_document&      m_doc;              // Document being built
+        };
+
+        static uint8_t _tag(uint64_t entry);
+        static size_t _payload(uint64_t entry);
+        static uint64_t _make_entry(json_tape_tag tag, size_t payload);
+
+        // Position after the value at pos
+        size_t _skip(size_t pos) const;
+
+#ifdef FC_JSON_INTERN_KEYS
+        bool _get_value(size_t pos, json_value& val, json_key_pool& key_pool) const;
+#else
+        bool _get_value(size_t pos, json_value& val) const;
+#endif
+
+    private:
+
+        std::vector<uint64_t>       m_tape;             // Tape entries
+        std::vector<_tchar>         m_strings;          // NUL terminated string texts
+        std::vector<size_t>         m_stack;            // Open container starts while parsing
+    };
+
+    // NDJSON / JSON Lines: one value per line, blank lines are skipped
+    struct json_ndjson_options
+    {
+        json_ndjson_options() :
+            thread_count(0),
+            batch_size(1024 * 1024),
+            max_batches(0),
+            ordered(true),
+            flags(json_parse_flag::json_parse_default)
+        {
+        }
+
+        size_t          thread_count;       // Parse threads, 0 for one per hardware thread
+        size_t          batch_size;         // Characters of whole lines a thread takes at a time
+        size_t          max_batches;        // Batches parsed or waiting to be read, 0 for 4 per thread, bounds memory
+        bool            ordered;            // Records in text order, else batches as they finish
+        json_parse_flag flags;              // Parse flags of every line
+    };
+
+    struct json_ndjson_record
+    {
+        json_ndjson_record() :
+            line(0),
+            valid(false),
+            value(json_type::json_type_null)
+        {
+        }
+
+        size_t          line;               // Line number, from 1
+        bool            valid;              // The line parsed, value is null if not
+        json_value      value;              // Parsed value
+    };
+
+    // Reads the records of an NDJSON text parsed on a thread pool
+    // Lines are split and parsed by the threads, the reader only hands out finished batches
+    class json_ndjson_reader
+    {
+    public:
+
+        json_ndjson_reader();
+        ~json_ndjson_reader();
+
+        json_ndjson_reader(const json_ndjson_reader&) = delete;
+        json_ndjson_reader& operator = (const json_ndjson_reader&) = delete;
+
+        // The text must outlive the reader
+        bool open(const _tchar* data, size_t size, const json_ndjson_options& options = json_ndjson_options());
+        bool open(const _tstring& text, const json_ndjson_options& options = json_ndjson_options());
+        bool open(_tstring&& text, const json_ndjson_options& options = json_ndjson_options()) = delete;
+
+        // UTF-8 file, memory mapped when possible
+        bool open_file(const _tstring& file_path, const json_ndjson_options& options = json_ndjson_options());
+
+        // Next record, false once all were read
+        bool next(json_ndjson_record& record);
+
+        // Stop the threads, records not read yet are dropped
+        void close();
+
+    private:
+
+        struct json_ndjson_state;
+
+        bool _start(const json_ndjson_options& options);
+        static void _worker(json_ndjson_state* state);
+
+    private:
+
+        json_ndjson_state*          m_state;            // Threads and batches, nullptr when closed
+    };
+
+    // Parse every line and pass it to callback, which returns false to stop
+    // Returns true if all lines were valid and callback never stopped
+    bool parse_ndjson(const _tchar* data, size_t size, const std::function<bool(json_ndjson_record& record)>& callback, const json_ndjson_options& options = json_ndjson_options());
+    bool parse_ndjson(const _tstring& text, const std::function<bool(json_ndjson_record& record)>& callback, const json_ndjson_options& options = json_ndjson_options());
+    bool parse_ndjson_file(const _tstring& file_path, const std::function<bool(json_ndjson_record& record)>& callback, const json_ndjson_options& options = json_ndjson_options());
 }
\ No newline at end of file
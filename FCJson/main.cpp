@@ -2,8 +2,19 @@
 #include <locale>
 #include <string>
 #include <fstream>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <chrono>
+#include <thread>
 #include "fcjson/fcjson.h"
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #pragma execution_character_set("utf-8")
 
 #if  0
@@ -15,6 +26,16 @@
 int count = 1;
 int dump_indent = 4;
 
+// Demo check, a failed one ends the demo with a non-zero exit code
+static void check_result(bool fResult, const char* pName)
+{
+    std::cout << pName << ": " << (fResult ? "ok" : "FAILED") << std::endl;
+    if (!fResult)
+    {
+        exit(EXIT_FAILURE);
+    }
+}
+
 int main()
 {
     setlocale(LC_ALL, "en_US.UTF-8");
@@ -104,6 +125,19 @@ int main()
         val["hobby"] = nullptr;
 
         std::cout << val.dump(4, true) << std::endl;
+
+        // Length-bounded parse of a char buffer, the text past the length is not read
+        char szBuffer[64] = "[1,2,3] trailing";
+        int nLength = 7;
+        fcjson::json_value valBuffer;
+        bool fBuffer = valBuffer.parse(szBuffer, nLength);
+        std::cout << "buffer: " << fBuffer << " " << valBuffer.dump() << std::endl;
+        check_result(fBuffer && 3 == valBuffer.count(), "buffer length");
+
+        // NUL-terminated text with a flag, the flag is not taken as a length
+        const char* pText = "[1,2,3]";
+        fcjson::json_value valText;
+        check_result(valText.parse(pText, fcjson::json_parse_indexed) && 3 == valText.count(), "pointer with flag");
     }
 
     // Parse File / Dump File
@@ -113,6 +147,219 @@ int main()
         fcjson::json_value val;
         val.parse_from_file("data.json");
         val.dump_to_file("dump.json", 4);
+
+        // Streamed through a small buffer, the text is never held as a whole
+        FILE* file = fopen("dump_stream.json", "wb");
+        if (file)
+        {
+            val.dump(file, 4);
+            fclose(file);
+        }
+        val.dump(std::cout, 4);
+        std::cout << std::endl;
+    }
+
+#ifndef _WIN32
+    // Parse File From A FIFO
+    std::cout << std::endl;
+    std::cout << "Parse File From A FIFO" << std::endl;
+    {
+        // A FIFO has no size, it is read in chunks until the writer closes it
+        const char* pFifoPath = "fifo.json";
+        unlink(pFifoPath);
+        if (0 == mkfifo(pFifoPath, 0600))
+        {
+            std::thread writer([pFifoPath]() {
+                std::ofstream outputFile(pFifoPath, std::ios::binary | std::ios::out);
+                outputFile << R"({"name":"FlameCyclone","array":[1,2,3]})";
+                });
+
+            fcjson::json_value val;
+            bool fResult = val.parse_from_file(pFifoPath);
+            writer.join();
+            unlink(pFifoPath);
+            std::cout << "fifo: " << fResult << " " << val.dump() << std::endl;
+        }
+    }
+#endif
+
+    // NDJSON / JSON Lines
+    std::cout << std::endl;
+    std::cout << "NDJSON / JSON Lines" << std::endl;
+    {
+        std::string strLines = "{\"name\":\"FlameCyclone\"}\n[1,2,3]\n\n{\"age\":30}\n";
+        fcjson::parse_ndjson(strLines, [](fcjson::json_ndjson_record& record) {
+            std::cout << record.line << ": " << record.value.dump() << std::endl;
+            return true;
+            });
+    }
+
+    // Parse Modes
+    std::cout << std::endl;
+    std::cout << "Parse Modes" << std::endl;
+    {
+        // Control characters and bytes >= 0x80 between tokens, both modes must agree
+        std::string strLoose = "{\"a\"\x05:\x90 1,\x01\"b\":[1,\xff 2]}";
+        fcjson::json_value valDefault;
+        fcjson::json_value valIndexed;
+        bool fDefault = valDefault.parse(strLoose);
+        bool fIndexed = valIndexed.parse(strLoose, fcjson::json_parse_indexed);
+        std::cout << "default: " << fDefault << " " << valDefault.dump() << std::endl;
+        std::cout << "indexed: " << fIndexed << " " << valIndexed.dump() << std::endl;
+        std::cout << "same: " << (fDefault == fIndexed && valDefault.dump() == valIndexed.dump()) << std::endl;
+    }
+
+    // Parse Engines
+    std::cout << std::endl;
+    std::cout << "Parse Engines" << std::endl;
+    {
+        // Pretty-printed and over the parallel split size, every engine must dump as the default parse does
+        fcjson::json_value valSource = fcjson::json_array{};
+        for (int i = 0; i < 20000; i++)
+        {
+            valSource[i] = fcjson::json_object{
+                { "id", i },
+                { "name", "city_" + std::to_string(i) },
+                { "location", fcjson::json_array{ i * 0.25, -i * 0.5 } },
+                { "tags", fcjson::json_array{ "a\"b", "\u4e2d\u6587", nullptr, i % 2 == 0 } },
+            };
+        }
+        std::string strEngine = valSource.dump(4);
+
+        fcjson::json_value valDefault;
+        check_result(valDefault.parse(strEngine), "default parse");
+        std::string strExpected = valDefault.dump();
+
+        fcjson::json_value valIndexed;
+        check_result(valIndexed.parse(strEngine, fcjson::json_parse_indexed) && valIndexed.dump() == strExpected, "indexed parse");
+
+        // The same document without whitespace
+        fcjson::json_value valMinified;
+        check_result(valMinified.parse(strExpected) && valMinified.dump() == strExpected, "minified parse");
+
+        // The arena is declared first, it must outlive the value placed in it
+        fcjson::json_arena arena;
+        fcjson::json_value valArena(fcjson::json_type::json_type_null);
+        check_result(valArena.parse(strEngine, arena) && valArena.dump() == strExpected, "arena parse");
+
+        // Read-only tape, copied into a mutable value to dump it
+        fcjson::json_document doc;
+        check_result(doc.parse(strEngine) && doc.to_value().dump() == strExpected, "document parse");
+
+        // Split across threads when there is more than one hardware thread, see FC_JSON_PARSE_THREADS
+        fcjson::json_value valParallel;
+        check_result(valParallel.parse(strEngine, fcjson::json_parse_parallel) && valParallel.dump() == strExpected, "parallel parse");
+    }
+
+    // Integer Dump Testing
+    std::cout << std::endl;
+    std::cout << "Integer Dump Testing" << std::endl;
+    {
+        // Every digit count and both ends of the range, as std::to_string writes them
+        bool fSame = fcjson::json_value(INT64_MIN).dump() == std::to_string(INT64_MIN) &&
+            fcjson::json_value(UINT64_MAX).dump() == std::to_string(UINT64_MAX);
+        uint64_t uPower = 1;
+        for (int i = 0; i < 20; i++, uPower *= 10)
+        {
+            fSame = fSame &&
+                fcjson::json_value(uPower).dump() == std::to_string(uPower) &&
+                fcjson::json_value(uPower - 1).dump() == std::to_string(uPower - 1) &&
+                fcjson::json_value(-(int64_t)(uPower / 10 * 9)).dump() == std::to_string(-(int64_t)(uPower / 10 * 9));
+        }
+        check_result(fSame, "integer dump");
+    }
+
+    // Float Parse Testing
+    std::cout << std::endl;
+    std::cout << "Float Parse Testing" << std::endl;
+    {
+        std::vector<double> values;
+        std::string strFloat = "[";
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+        char szBuf[64] = { 0 };
+
+        // Random bit patterns, printed with enough digits to round trip
+        while (values.size() < 1000000)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+
+            double value = 0;
+            uint64_t bits = seed & 0x7FFFFFFFFFFFFFFFULL;
+            memcpy(&value, &bits, sizeof(value));
+            if ((bits >> 52) == 0x7FF)
+            {
+                continue;
+            }
+
+            snprintf(szBuf, sizeof(szBuf), "%.17g", value);
+            if (!values.empty())
+            {
+                strFloat += ",";
+            }
+            strFloat += szBuf;
+            values.push_back(value);
+        }
+        strFloat += "]";
+
+        fcjson::json_value val;
+        clock_t timeBegin = clock();
+        val.parse(strFloat);
+        clock_t timeEnd = clock();
+        std::cout << "fcjson parse cost time: " << timeEnd - timeBegin << std::endl;
+
+        size_t nMismatch = 0;
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            double value = val[i].is_float() ? val[i].as_float() : (double)val[i].as_int();
+            if (0 != memcmp(&value, &values[i], sizeof(value)))
+            {
+                nMismatch++;
+            }
+        }
+        std::cout << "round trip mismatch: " << nMismatch << std::endl;
+
+        // strtod over the same text
+        double dSum = 0;
+        timeBegin = clock();
+        for (const char* pText = strFloat.c_str() + 1; '\0' != *pText; pText++)
+        {
+            char* pEnd = nullptr;
+            dSum += strtod(pText, &pEnd);
+            pText = pEnd;
+        }
+        timeEnd = clock();
+        std::cout << "strtod cost time: " << timeEnd - timeBegin << " (" << dSum << ")" << std::endl;
+
+        // Dump writes the shortest text that reads back to the same double
+        timeBegin = clock();
+        std::string strDump = val.dump();
+        timeEnd = clock();
+        std::cout << "fcjson dump cost time: " << timeEnd - timeBegin << std::endl;
+
+        fcjson::json_value valBack;
+        valBack.parse(strDump);
+        nMismatch = 0;
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            double value = valBack[i].is_float() ? valBack[i].as_float() : (double)valBack[i].as_int();
+            if (0 != memcmp(&value, &values[i], sizeof(value)))
+            {
+                nMismatch++;
+            }
+        }
+        std::cout << "dump round trip mismatch: " << nMismatch << " (" << strDump.size() << " / " << strFloat.size() << " bytes)" << std::endl;
+
+        // snprintf over the same values
+        size_t nLength = 0;
+        timeBegin = clock();
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            nLength += snprintf(szBuf, sizeof(szBuf), "%.17g", values[i]);
+        }
+        timeEnd = clock();
+        std::cout << "snprintf cost time: " << timeEnd - timeBegin << " (" << nLength << ")" << std::endl;
     }
 
     std::ifstream inputFile(TEST_JSON_FILE, std::ios::binary | std::ios::in);
@@ -129,6 +376,22 @@ int main()
     inputFile.read((char*)&strBuffer[0], nSize);
     inputFile.close();
 
+    // Memory Report
+    std::cout << std::endl;
+    std::cout << "Memory Report" << std::endl;
+    {
+        fcjson::json_value val(fcjson::json_type::json_type_null);
+        val.parse(strBuffer);
+
+        fcjson::json_memory_stats stats = val.memory_stats();
+        size_t nTotal = stats.node_bytes + stats.container_bytes + stats.string_bytes;
+        std::cout << "nodes: " << stats.node_count << " (short strings: " << stats.short_string_count << ")" << std::endl;
+        std::cout << "node bytes: " << stats.node_bytes << std::endl;
+        std::cout << "container bytes: " << stats.container_bytes << std::endl;
+        std::cout << "string bytes: " << stats.string_bytes << std::endl;
+        std::cout << "bytes per node: " << (stats.node_count ? (double)nTotal / stats.node_count : 0.0) << std::endl;
+    }
+
     // Performance Testing
     size_t nCount = count;
     clock_t timeBegin = clock();
@@ -143,22 +406,71 @@ int main()
             val.parse_from_file("data.json");
 
             timeBegin = clock();
-            for (int i = 0; i < nCount; i++)
+            for (size_t i = 0; i < nCount; i++)
             {
                 val.parse(strBuffer);
             }
             timeEnd = clock();
             std::cout << "parse cost time: " << timeEnd - timeBegin << std::endl;
 
+            timeBegin = clock();
+            for (size_t i = 0; i < nCount; i++)
+            {
+                val.parse(strBuffer, fcjson::json_parse_indexed);
+            }
+            timeEnd = clock();
+            std::cout << "parse indexed cost time: " << timeEnd - timeBegin << std::endl;
+
+            // Wall clock, clock() adds up the time of every thread on some platforms
+            std::chrono::steady_clock::time_point wallBegin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < nCount; i++)
+            {
+                val.parse(strBuffer, fcjson::json_parse_parallel);
+            }
+            std::chrono::steady_clock::time_point wallEnd = std::chrono::steady_clock::now();
+            std::cout << "parse parallel cost time: " << std::chrono::duration_cast<std::chrono::milliseconds>(wallEnd - wallBegin).count() << std::endl;
+
+            // Containers and strings placed in one arena, released together
+            timeBegin = clock();
+            for (size_t i = 0; i < nCount; i++)
+            {
+                fcjson::json_arena arena;
+                fcjson::json_value valArena(fcjson::json_type::json_type_null);
+                valArena.parse(strBuffer, arena);
+            }
+            timeEnd = clock();
+            std::cout << "parse arena cost time: " << timeEnd - timeBegin << std::endl;
+
+            // Read-only tape, the document keeps its buffers between parses
+            fcjson::json_document doc;
+            timeBegin = clock();
+            for (size_t i = 0; i < nCount; i++)
+            {
+                doc.parse(strBuffer);
+            }
+            timeEnd = clock();
+            std::cout << "parse document cost time: " << timeEnd - timeBegin << std::endl;
+            std::cout << "document tape size: " << doc.tape_size() << " string size: " << doc.string_size() << std::endl;
+
+            // Same document without indentation, pretty-printed input should be close
+            std::string strMinified = val.dump();
+            timeBegin = clock();
+            for (size_t i = 0; i < nCount; i++)
+            {
+                val.parse(strMinified);
+            }
+            timeEnd = clock();
+            std::cout << "parse minified cost time: " << timeEnd - timeBegin << std::endl;
+
             timeBegin = clock();
             std::string strDump;
-            for (int i = 0; i < nCount; i++)
+            for (size_t i = 0; i < nCount; i++)
             {
                 strDump = val.dump(dump_indent);
             }
             timeEnd = clock();
             std::cout << "dump cost time: " << timeEnd - timeBegin << std::endl;
-            std::cout << "dump text size: " << strDump.size() << std::endl;
+            std::cout << "dump text size: " << strDump.size() << " (measured " << val.dump_size(dump_indent) << ")" << std::endl;
 
             {
                 std::ofstream outputFile("dump_fcjson.json", std::ios::binary | std::ios::out);